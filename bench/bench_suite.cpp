@@ -0,0 +1,455 @@
+#include "../src/emu.hpp"
+#include "../src/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char* USAGE = "chip8-bench [-n <instructions>] [-r <repetitions>] [-w <warm-up instructions>] "
+  "[-e <engine>]... [-roms <folder>] [-format text|csv|json] [-o <file>]";
+
+const int INSTRUCTIONS_PER_FRAME = Emu::DEFAULT_CLOCK_SPEED / Emu::TIMER_FREQUENCY;
+
+/**
+ * Address roms are loaded at.
+ */
+const int PROGRAM_START = 0x200;
+
+/**
+ * Instructions in the loop body of a synthetic opcode stream, before the jump back to its start.
+ */
+const int STREAM_BODY_LENGTH = 64;
+
+/**
+ * Address the memory stream's Fx55 and Fx65 work on, well clear of the program.
+ */
+const int STREAM_DATA_ADDRESS = 0x800;
+
+/**
+ * Settings read from the command line.
+ */
+struct BenchOptions {
+  long long instructions = 1000000;
+  int repetitions = 5;
+
+  /**
+   * Instructions run before timing starts, less than 0 for a tenth of the timed instructions.
+   */
+  long long warm_up = -1;
+
+  /**
+   * Indices into ENGINES of the engines to time, empty for all of them.
+   */
+  std::vector<int> engines;
+  std::string rom_folder;
+  std::string format = "text";
+  std::string output_file;
+};
+
+/**
+ * A program to benchmark, either a rom or a synthetic stream of one class of opcodes.
+ */
+struct BenchProgram {
+  std::string name;
+
+  /**
+   * "rom" for roms, run frame by frame, "opcodes" for synthetic streams, run by ExecuteBatch.
+   */
+  std::string kind;
+
+  std::vector<uint8_t> bytes;
+};
+
+/**
+ * Timings of one program on one engine.
+ */
+struct BenchResult {
+  std::string name;
+  std::string kind;
+  std::string engine;
+
+  /**
+   * Instruction cycles and frames run by each timed repetition.
+   */
+  long long cycles;
+  long long frames;
+
+  /**
+   * Instructions actually executed by the median and the best repetition, leaving out the cycles
+   * roms spend waiting on Fx0A.
+   */
+  long long instructions;
+  long long best_instructions;
+
+  double best_seconds;
+  double median_seconds;
+};
+
+/**
+ * Instructions executed by one timed repetition and the time they took.
+ */
+struct BenchRepetition {
+  long long instructions;
+  double seconds;
+};
+
+const char* ENGINE_NAMES[] = { "switch", "table", "threaded", "block", "jit" };
+const Emu::ExecutionEngine ENGINES[] = {
+  Emu::SWITCH_ENGINE, Emu::TABLE_ENGINE, Emu::THREADED_ENGINE, Emu::BLOCK_ENGINE, Emu::JIT_ENGINE
+};
+
+/**
+ * Appends p_opcode to p_bytes, high byte first.
+ */
+void emit(std::vector<uint8_t>& p_bytes, uint16_t p_opcode) {
+  p_bytes.push_back(p_opcode >> 8);
+  p_bytes.push_back(p_opcode & 0xFF);
+}
+
+/**
+ * Builds a program that runs p_setup once and then loops over p_body forever. p_body is given the
+ * address it starts at.
+ */
+BenchProgram make_stream(const std::string& p_name, const std::vector<uint16_t>& p_setup,
+                         std::vector<uint16_t> (*p_body)(int)) {
+  BenchProgram program;
+  program.name = p_name;
+  program.kind = "opcodes";
+  for (uint16_t opcode : p_setup) {
+    emit(program.bytes, opcode);
+  }
+  int loop = PROGRAM_START + program.bytes.size();
+  for (uint16_t opcode : p_body(loop)) {
+    emit(program.bytes, opcode);
+  }
+  return program;
+}
+
+/**
+ * ALU: every 8xy* operation, cycling through the registers.
+ */
+std::vector<uint16_t> alu_body(int p_loop) {
+  const int operations[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+  std::vector<uint16_t> body;
+  for (int i = 0; i < STREAM_BODY_LENGTH - 1; i++) {
+    int x = i % 15;
+    int y = (i * 7 + 3) % 15;
+    body.push_back(0x8000 | x << 8 | y << 4 | operations[i % 9]);
+  }
+  body.push_back(0x1000 | p_loop);
+  return body;
+}
+
+/**
+ * Draws: 5 row sprites at a spread of positions, some of them clipped at the edges.
+ */
+std::vector<uint16_t> draw_body(int p_loop) {
+  std::vector<uint16_t> body;
+  for (int i = 0; i < STREAM_BODY_LENGTH - 1; i++) {
+    int x = i % 6;
+    int y = (i + 1) % 6;
+    body.push_back(0xD005 | x << 8 | y << 4);
+  }
+  body.push_back(0x1000 | p_loop);
+  return body;
+}
+
+/**
+ * Memory: Fx55 and Fx65 of all 16 registers, walking forward from the data address.
+ */
+std::vector<uint16_t> memory_body(int p_loop) {
+  std::vector<uint16_t> body;
+  body.push_back(0xA000 | STREAM_DATA_ADDRESS);
+  for (int i = 0; i < STREAM_BODY_LENGTH - 2; i++) {
+    body.push_back(i % 2 == 0 ? 0xFF55 : 0xFF65);
+  }
+  body.push_back(0x1000 | p_loop);
+  return body;
+}
+
+/**
+ * Flow: jumps to the next instruction alternating with calls to a subroutine that returns at
+ * once.
+ */
+std::vector<uint16_t> flow_body(int p_loop) {
+  int subroutine = p_loop + STREAM_BODY_LENGTH * 2;
+  std::vector<uint16_t> body;
+  for (int i = 0; i < STREAM_BODY_LENGTH - 1; i++) {
+    int next = p_loop + (i + 1) * 2;
+    body.push_back(i % 2 == 0 ? 0x1000 | next : 0x2000 | subroutine);
+  }
+  body.push_back(0x1000 | p_loop);
+  body.push_back(0x00EE);
+  return body;
+}
+
+/**
+ * Returns the synthetic opcode streams, one per class of opcode.
+ */
+std::vector<BenchProgram> make_streams() {
+  std::vector<uint16_t> registers;
+  for (int x = 0; x < 16; x++) {
+    registers.push_back(0x6000 | x << 8 | ((x * 37 + 11) & 0xFF));
+  }
+  std::vector<uint16_t> positions = { 0x6000, 0x6108, 0x6210, 0x631C, 0x643C, 0x651E, 0xA000 };
+
+  std::vector<BenchProgram> streams;
+  streams.push_back(make_stream("alu", registers, alu_body));
+  streams.push_back(make_stream("draw", positions, draw_body));
+  streams.push_back(make_stream("memory", registers, memory_body));
+  streams.push_back(make_stream("flow", {}, flow_body));
+  return streams;
+}
+
+/**
+ * Reads every file in p_folder as a rom, in name order. Returns false if the folder can not be
+ * listed.
+ */
+bool read_roms(const std::string& p_folder, std::vector<BenchProgram>& p_roms) {
+  std::error_code error;
+  std::vector<std::string> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(p_folder, error)) {
+    if (entry.is_regular_file()) {
+      paths.push_back(entry.path().string());
+    }
+  }
+  if (error) {
+    return false;
+  }
+  std::sort(paths.begin(), paths.end());
+
+  for (const std::string& path : paths) {
+    std::ifstream file(path, std::ios::binary);
+    BenchProgram rom;
+    rom.name = std::filesystem::path(path).filename().string();
+    rom.kind = "rom";
+    rom.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (!rom.bytes.empty()) {
+      p_roms.push_back(rom);
+    }
+  }
+  return true;
+}
+
+/**
+ * Runs p_frames frames of a rom on p_emu. A key is tapped every half second so roms waiting on
+ * Fx0A keep executing. Returns the number of instructions executed, which leaves out the cycles 
+ * spent waiting.
+ */
+long long run_frames(Emu& p_emu, long long p_frames) {
+  long long executed = 0;
+  for (long long i = 0; i < p_frames; i++) {
+    long long frame = p_emu.get_cycle_count() / INSTRUCTIONS_PER_FRAME;
+    if (frame % 30 == 0) {
+      p_emu.KeyDown(frame / 30 % 16);
+    } else if (frame % 30 == 5) {
+      p_emu.KeyUp(frame / 30 % 16);
+    }
+    executed += p_emu.RunFrame(INSTRUCTIONS_PER_FRAME).executed;
+  }
+  return executed;
+}
+
+/**
+ * Warms up a fresh emulator on p_program with engine ENGINES[p_engine] and then times
+ * p_options.repetitions runs of p_options.instructions instruction cycles each. Idle loop skipping
+ * is turned off and cycles spent waiting on Fx0A are left out, so every instruction counted is 
+ * really executed. The repetitions are ranked by time per executed instruction.
+ */
+BenchResult bench_program(const BenchProgram& p_program, int p_engine,
+                          const BenchOptions& p_options) {
+  Emu emu;
+  emu.set_execution_engine(ENGINES[p_engine]);
+  emu.set_idle_loop_skipping(false);
+  emu.LoadRom(p_program.bytes.data(), p_program.bytes.size());
+
+  bool rom = p_program.kind == "rom";
+  long long frames = rom ? std::max(1LL, p_options.instructions / INSTRUCTIONS_PER_FRAME) : 0;
+  long long cycles = rom ? frames * INSTRUCTIONS_PER_FRAME : p_options.instructions;
+  long long warm_up = p_options.warm_up < 0 ? cycles / 10 : p_options.warm_up;
+
+  // Returns the instructions executed. ExecuteBatch takes an int, so large counts go in pieces.
+  auto run = [&](long long p_cycles) {
+    if (rom) {
+      return run_frames(emu, p_cycles / INSTRUCTIONS_PER_FRAME);
+    }
+    long long executed = 0;
+    while (p_cycles > 0) {
+      int batch = std::min(p_cycles, 1LL << 20);
+      executed += emu.ExecuteBatch(batch);
+      p_cycles -= batch;
+    }
+    return executed;
+  };
+
+  run(warm_up);
+  std::vector<BenchRepetition> repetitions;
+  for (int i = 0; i < p_options.repetitions; i++) {
+    auto start = std::chrono::steady_clock::now();
+    BenchRepetition repetition;
+    repetition.instructions = std::max(1LL, run(cycles));
+    repetition.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+    repetitions.push_back(repetition);
+  }
+  std::sort(repetitions.begin(), repetitions.end(), 
+    [](const BenchRepetition& p_first, const BenchRepetition& p_second) {
+      return p_first.seconds * p_second.instructions < p_second.seconds * p_first.instructions;
+    });
+  const BenchRepetition& median = repetitions[repetitions.size() / 2];
+
+  BenchResult result;
+  result.name = p_program.name;
+  result.kind = p_program.kind;
+  result.engine = ENGINE_NAMES[p_engine];
+  result.cycles = cycles;
+  result.frames = frames;
+  result.instructions = median.instructions;
+  result.best_instructions = repetitions.front().instructions;
+  result.best_seconds = repetitions.front().seconds;
+  result.median_seconds = median.seconds;
+  return result;
+}
+
+/**
+ * Returns p_text quoted for a CSV field.
+ */
+std::string csv_field(const std::string& p_text) {
+  std::string quoted = "\"";
+  for (char c : p_text) {
+    quoted += c == '"' ? "\"\"" : std::string(1, c);
+  }
+  return quoted + "\"";
+}
+
+/**
+ * Writes p_results to p_out in p_format. Rates are taken from the median repetition, with the
+ * best repetition's instruction rate alongside.
+ */
+void write_results(std::ostream& p_out, const std::vector<BenchResult>& p_results,
+                   const std::string& p_format) {
+  if (p_format == "csv") {
+    p_out << "name,kind,engine,cycles,instructions,frames,median_seconds,best_seconds,"
+      "instructions_per_second,best_instructions_per_second,frames_per_second,ns_per_instruction\n";
+  } else if (p_format == "json") {
+    p_out << "[\n";
+  }
+
+  for (size_t i = 0; i < p_results.size(); i++) {
+    const BenchResult& result = p_results[i];
+    double rate = result.instructions / result.median_seconds;
+    double best_rate = result.best_instructions / result.best_seconds;
+    double frame_rate = result.frames / result.median_seconds;
+    double nanoseconds = result.median_seconds * 1e9 / result.instructions;
+
+    std::ostringstream line;
+    if (p_format == "csv") {
+      line << csv_field(result.name) << "," << result.kind << "," << result.engine << ","
+        << result.cycles << "," << result.instructions << "," << result.frames << ","
+        << result.median_seconds << ","
+        << result.best_seconds << "," << static_cast<long long>(rate) << ","
+        << static_cast<long long>(best_rate) << "," << static_cast<long long>(frame_rate) << ","
+        << nanoseconds << "\n";
+    } else if (p_format == "json") {
+      line << "  {\"name\": " << json_string(result.name) << ", \"kind\": \"" << result.kind
+        << "\", \"engine\": \"" << result.engine << "\", \"cycles\": " << result.cycles
+        << ", \"instructions\": " << result.instructions << ", \"frames\": " << result.frames
+        << ", \"median_seconds\": " << result.median_seconds
+        << ", \"best_seconds\": " << result.best_seconds << ", \"instructions_per_second\": "
+        << static_cast<long long>(rate) << ", \"best_instructions_per_second\": "
+        << static_cast<long long>(best_rate) << ", \"frames_per_second\": "
+        << static_cast<long long>(frame_rate) << ", \"ns_per_instruction\": " << nanoseconds
+        << "}" << (i + 1 < p_results.size() ? "," : "") << "\n";
+    } else {
+      line << result.kind << " " << result.name << " [" << result.engine << "]: "
+        << static_cast<long long>(rate) << " instructions/s, " << nanoseconds << " ns/instruction";
+      if (result.frames > 0) {
+        line << ", " << static_cast<long long>(frame_rate) << " frames/s";
+      }
+      line << "\n";
+    }
+    p_out << line.str();
+  }
+
+  if (p_format == "json") {
+    p_out << "]\n";
+  }
+}
+
+/**
+ * Times every rom in the rom folder and every synthetic opcode stream on each engine, then writes
+ * the results as text, CSV or JSON to standard output or a file.
+ */
+int main(int argc, char* argv[]) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-n" && i + 1 < argc) {
+      options.instructions = std::max(1LL, std::atoll(argv[++i]));
+    } else if (arg == "-r" && i + 1 < argc) {
+      options.repetitions = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-w" && i + 1 < argc) {
+      options.warm_up = std::atoll(argv[++i]);
+    } else if (arg == "-e" && i + 1 < argc) {
+      std::string name = argv[++i];
+      int engine = std::find(std::begin(ENGINE_NAMES), std::end(ENGINE_NAMES), name)
+        - std::begin(ENGINE_NAMES);
+      if (engine == 5) {
+        std::cout << "Unknown engine: " << name << std::endl;
+        return 1;
+      }
+      options.engines.push_back(engine);
+    } else if (arg == "-roms" && i + 1 < argc) {
+      options.rom_folder = argv[++i];
+    } else if (arg == "-format" && i + 1 < argc) {
+      options.format = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      options.output_file = argv[++i];
+    } else {
+      std::cout << USAGE << std::endl;
+      return 1;
+    }
+  }
+  if (options.engines.empty()) {
+    for (int engine = 0; engine < 5; engine++) {
+      options.engines.push_back(engine);
+    }
+  }
+
+  std::vector<BenchProgram> programs;
+  if (!options.rom_folder.empty()) {
+    if (!read_roms(options.rom_folder, programs)) {
+      std::cout << "Unable to read roms from " << options.rom_folder << std::endl;
+      return 1;
+    }
+  } else if (!read_roms("roms", programs)) {
+    read_roms("../roms", programs);
+  }
+  std::vector<BenchProgram> streams = make_streams();
+  programs.insert(programs.end(), streams.begin(), streams.end());
+
+  std::vector<BenchResult> results;
+  for (const BenchProgram& program : programs) {
+    for (int engine : options.engines) {
+      results.push_back(bench_program(program, engine, options));
+    }
+  }
+
+  if (options.output_file.empty()) {
+    write_results(std::cout, results, options.format);
+  } else {
+    std::ofstream file(options.output_file);
+    write_results(file, results, options.format);
+    if (!file) {
+      std::cout << "Unable to write " << options.output_file << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include "../src/emu.hpp"
+#include "../src/lockstep_emu.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Loads the rom at p_path into p_emu starting at the program start address. Returns false if the 
+ * rom could not be read.
+ */
+bool load_rom(Emu& p_emu, const std::string& p_path) {
+  std::ifstream rom(p_path, std::ifstream::binary);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(rom)), 
+    std::istreambuf_iterator<char>());
+  return p_emu.LoadRom(bytes.data(), bytes.size()) > 0;
+}
+
+/**
+ * Runs a fresh emulator using engine p_engine through p_instructions instructions of the rom at 
+ * p_path and reports the number of instructions executed per second. If p_batch is above zero the
+ * instructions are run through ExecuteBatch p_batch at a time, otherwise they are stepped one by 
+ * one.
+ */
+void bench_rom(const std::string& p_path, int p_instructions, Emu::ExecutionEngine p_engine,
+  int p_batch) {
+  Emu* emu = new Emu();
+  emu->set_execution_engine(p_engine);
+  if (!load_rom(*emu, p_path)) {
+    std::cout << "Unable to read rom: " << p_path << std::endl;
+    delete emu;
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (p_batch > 0) {
+    for (int i = 0; i < p_instructions; i += p_batch) {
+      emu->ExecuteBatch(p_batch);
+    }
+  } else {
+    for (int i = 0; i < p_instructions; i++) {
+      emu->Step();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << p_path << ": " << p_instructions << " instructions in " << seconds << "s ("
+    << static_cast<long long>(p_instructions / seconds) << " instructions/s)" << std::endl;
+
+  if (p_engine == Emu::BLOCK_ENGINE || p_engine == Emu::JIT_ENGINE) {
+    BlockCacheStats stats = emu->get_block_cache_stats();
+    std::cout << "  block cache: " << stats.hits << " hits, " << stats.misses << " misses, " 
+      << stats.invalidations << " invalidations" << std::endl;
+  }
+  delete emu;
+}
+
+/**
+ * Runs p_lanes copies of the rom at p_path for p_instructions instructions each, once as p_lanes
+ * separate emulators and once as the lanes of a LockstepEmu, and reports the combined instructions 
+ * per second of both and the speedup of the lockstep run. Both run frame by frame with a different
+ * random seed per lane.
+ */
+void bench_lanes(const std::string& p_path, int p_instructions, int p_lanes) {
+  std::ifstream file(p_path, std::ifstream::binary);
+  std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), 
+    std::istreambuf_iterator<char>());
+  if (rom.empty()) {
+    std::cout << "Unable to read rom: " << p_path << std::endl;
+    return;
+  }
+  const int instructions_per_frame = 9;
+  int frames = p_instructions / instructions_per_frame;
+  long long total = (long long)frames * instructions_per_frame * p_lanes;
+
+  std::vector<Emu*> emus;
+  for (int lane = 0; lane < p_lanes; lane++) {
+    emus.push_back(new Emu());
+    emus[lane]->LoadRom(rom.data(), rom.size());
+    emus[lane]->set_random_seed(lane);
+    emus[lane]->set_idle_loop_skipping(false);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    for (int lane = 0; lane < p_lanes; lane++) {
+      emus[lane]->RunFrame(instructions_per_frame);
+    }
+  }
+  double scalar_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+    .count();
+  for (int lane = 0; lane < p_lanes; lane++) {
+    delete emus[lane];
+  }
+
+  LockstepEmu* lockstep = new LockstepEmu(p_lanes);
+  lockstep->LoadRom(rom.data(), rom.size());
+  for (int lane = 0; lane < p_lanes; lane++) {
+    lockstep->set_random_seed(lane, lane);
+  }
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; frame++) {
+    lockstep->RunFrame(instructions_per_frame);
+  }
+  double lockstep_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+    .count();
+  LockstepStats stats = lockstep->get_stats();
+  delete lockstep;
+
+  std::cout << p_path << ": " << p_lanes << " lanes x " << frames * instructions_per_frame 
+    << " instructions" << std::endl;
+  std::cout << "  separate emulators: " << static_cast<long long>(total / scalar_seconds) 
+    << " instructions/s" << std::endl;
+  std::cout << "  lockstep: " << static_cast<long long>(total / lockstep_seconds) 
+    << " instructions/s, " << (double)stats.lane_instructions / stats.groups 
+    << " lanes per group, " << 100.0 * stats.scalar_instructions / stats.lane_instructions 
+    << "% run lane by lane" << std::endl;
+  std::cout << "  lockstep vs separate: " << scalar_seconds / lockstep_seconds << "x" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int instructions = 1000000;
+  Emu::ExecutionEngine engine = Emu::TABLE_ENGINE;
+  int batch = 0;
+  int lanes = 0;
+  std::vector<std::string> roms;
+
+  for (int i = 1; i < argc; i++) {
+    if ((std::string(argv[i]) == "-n") && (i + 1 < argc)) {
+      instructions = std::stoi(argv[++i]);
+    } else if ((std::string(argv[i]) == "-e") && (i + 1 < argc)) {
+      // Engine to run with, either "switch", "table", "threaded", "block" or "jit".
+      std::string name = argv[++i];
+      if (name == "switch") {
+        engine = Emu::SWITCH_ENGINE;
+      } else if (name == "threaded") {
+        engine = Emu::THREADED_ENGINE;
+      } else if (name == "block") {
+        engine = Emu::BLOCK_ENGINE;
+      } else if (name == "jit") {
+        engine = Emu::JIT_ENGINE;
+      } else {
+        engine = Emu::TABLE_ENGINE;
+      }
+    } else if ((std::string(argv[i]) == "-b") && (i + 1 < argc)) {
+      batch = std::stoi(argv[++i]);
+    } else if ((std::string(argv[i]) == "-lanes") && (i + 1 < argc)) {
+      // Compare that many separate emulators against one LockstepEmu instead.
+      lanes = std::stoi(argv[++i]);
+    } else {
+      roms.push_back(argv[i]);
+    }
+  }
+
+  if (roms.empty() && lanes > 0) {
+    // Tetris lanes drift apart with their seeds, breakout lanes stay together.
+    roms.push_back("../roms/tetris.rom");
+    roms.push_back("../roms/breakout.rom");
+  } else if (roms.empty()) {
+    roms.push_back("../roms/tetris.rom");
+    roms.push_back("../roms/test_opcode.ch8");
+  }
+
+  for (int i = 0; i < roms.size(); i++) {
+    if (lanes > 0) {
+      bench_lanes(roms[i], instructions, lanes);
+    } else {
+      bench_rom(roms[i], instructions, engine, batch);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include "block_cache.hpp"
+
+const int BlockCache::MAX_BLOCK_INSTRUCTIONS;
+
+BlockCache::BlockCache() {
+  dispatch_table_ = DispatchTable::Get();
+  generation_ = 0;
+  ResetStats();
+}
+
+Block* BlockCache::GetBlock(int p_address, Ram& p_memory) {
+  if (blocks_.empty()) {
+    blocks_.resize(Ram::ADDRESSES);
+    coverage_.assign(Ram::ADDRESSES, 0);
+  }
+
+  Block* block = nullptr;
+  if (p_address >= 0 && p_address < Ram::ADDRESSES) {
+    block = &blocks_[p_address];
+    if (block->valid) {
+      stats_.hits++;
+    } else {
+      stats_.misses++;
+      Translate(p_address, p_memory, *block);
+    }
+  }
+  return block;
+}
+
+void BlockCache::Translate(int p_address, Ram& p_memory, Block& p_block) {
+  p_block.start_address = p_address;
+  p_block.entries.clear();
+  p_block.executions = 0;
+  p_block.native_code = nullptr;
+  p_block.native_length = 0;
+
+  int address = p_address;
+  bool done = false;
+  while (!done && address < Ram::ADDRESSES) {
+    uint16_t opcode = (p_memory.ReadByte(address) << 8) | p_memory.ReadByte(address + 1);
+    const DispatchEntry* entry = &dispatch_table_[opcode];
+    p_block.entries.push_back(entry);
+    address += 2;
+
+    done = EndsBlock(entry->instruction.type) 
+      || p_block.entries.size() == MAX_BLOCK_INSTRUCTIONS;
+  }
+
+  // An instruction straddling the end of memory only covers the last address.
+  p_block.end_address = address > Ram::ADDRESSES ? Ram::ADDRESSES : address;
+  p_block.valid = true;
+
+  for (int i = p_block.start_address; i < p_block.end_address; i++) {
+    coverage_[i]++;
+  }
+}
+
+void BlockCache::Invalidate(int p_address, int p_length) {
+  if (blocks_.empty()) {
+    return;
+  }
+
+  int first = p_address < 0 ? 0 : p_address;
+  int last = p_address + p_length > Ram::ADDRESSES ? Ram::ADDRESSES : p_address + p_length;
+
+  // Nothing to do unless at least one written address is covered by a block.
+  bool covered = false;
+  for (int i = first; i < last && !covered; i++) {
+    covered = coverage_[i] > 0;
+  }
+
+  if (covered) {
+    // A block overlapping the range can start at most one full block length before it.
+    int scan_start = first - MAX_BLOCK_INSTRUCTIONS * 2 + 1;
+    if (scan_start < 0) {
+      scan_start = 0;
+    }
+    for (int i = scan_start; i < last; i++) {
+      Block& block = blocks_[i];
+      if (block.valid && block.start_address < last && block.end_address > first) {
+        Discard(block);
+        stats_.invalidations++;
+      }
+    }
+  }
+}
+
+void BlockCache::Clear() {
+  for (int i = 0; i < blocks_.size(); i++) {
+    if (blocks_[i].valid) {
+      Discard(blocks_[i]);
+    }
+  }
+}
+
+void BlockCache::ClearNativeCode() {
+  for (int i = 0; i < blocks_.size(); i++) {
+    blocks_[i].executions = 0;
+    blocks_[i].native_code = nullptr;
+    blocks_[i].native_length = 0;
+  }
+}
+
+void BlockCache::Discard(Block& p_block) {
+  p_block.valid = false;
+  for (int i = p_block.start_address; i < p_block.end_address; i++) {
+    coverage_[i]--;
+  }
+  generation_++;
+}
+
+long long BlockCache::get_generation() {
+  return generation_;
+}
+
+BlockCacheStats BlockCache::get_stats() {
+  return stats_;
+}
+
+void BlockCache::ResetStats() {
+  stats_.hits = 0;
+  stats_.misses = 0;
+  stats_.invalidations = 0;
+}
+
+bool BlockCache::EndsBlock(int p_type) {
+  switch (p_type) {
+    case OP_RETURN:
+    case OP_JUMP:
+    case OP_CALL:
+    case OP_SKIP_EQUAL:
+    case OP_SKIP_NOT_EQUAL:
+    case OP_SKIP_REGISTERS_EQUAL:
+    case OP_SKIP_REGISTERS_NOT_EQUAL:
+    case OP_JUMP_OFFSET:
+    case OP_SKIP_KEY_PRESSED:
+    case OP_SKIP_KEY_NOT_PRESSED:
+    case OP_WAIT_KEY:
+      return true;
+    default:
+      return false;
+  }
+}
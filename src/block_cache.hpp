@@ -0,0 +1,171 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include "dispatch_table.hpp"
+#include "ram.hpp"
+
+#include <vector>
+
+/**
+ * A straight-line run of predecoded instructions. The run starts at start_address and ends with 
+ * the first jump, call, return, skip or key wait, so every instruction but the last one is known 
+ * to simply fall through to the next.
+ */
+struct Block {
+  /**
+   * Address of the first instruction in the block.
+   */
+  int start_address;
+
+  /**
+   * One past the address of the last byte the block was translated from.
+   */
+  int end_address;
+
+  /**
+   * False once the block has been invalidated, or if it was never translated.
+   */
+  bool valid;
+
+  /**
+   * Dispatch table entries of the instructions in the block, in program order.
+   */
+  std::vector<const DispatchEntry*> entries;
+
+  /**
+   * Number of times the block has been run since it was translated, used to decide when a block
+   * is hot enough to compile to native code.
+   */
+  int executions;
+
+  /**
+   * Native code compiled from the block by the JIT, or nullptr if it has not been compiled.
+   */
+  void* native_code;
+
+  /**
+   * Number of instructions, counted from the start of the block, that native_code executes.
+   */
+  int native_length;
+};
+
+/**
+ * Counters describing how well the block cache is working.
+ */
+struct BlockCacheStats {
+  /**
+   * Lookups that found an already translated block.
+   */
+  long long hits;
+
+  /**
+   * Lookups that had to translate a new block.
+   */
+  long long misses;
+
+  /**
+   * Blocks thrown away because memory they were translated from was written to.
+   */
+  long long invalidations;
+};
+
+/**
+ * Cache of translated blocks, keyed by the address they start at. Blocks are invalidated exactly
+ * when a write lands inside the range of memory they were translated from.
+ */
+class BlockCache {
+
+public:
+
+  /**
+   * The most instructions a single block will hold before it is cut off.
+   */
+  const static int MAX_BLOCK_INSTRUCTIONS = 64;
+
+  BlockCache();
+
+  /**
+   * Returns the block starting at p_address, translating it from p_memory if it is not cached.
+   */
+  Block* GetBlock(int p_address, Ram& p_memory);
+
+  /**
+   * Invalidates every cached block translated from any of the p_length bytes starting at 
+   * p_address.
+   */
+  void Invalidate(int p_address, int p_length);
+
+  /**
+   * Throws away every cached block. Does not count as invalidations.
+   */
+  void Clear();
+
+  /**
+   * Forgets the native code of every block while keeping the blocks themselves, for when the code
+   * it lived in is reused.
+   */
+  void ClearNativeCode();
+
+  /**
+   * Returns a counter that changes every time a block is invalidated. Used while executing a 
+   * block to notice when an instruction overwrote the block itself.
+   */
+  long long get_generation();
+
+  /**
+   * Returns the hit, miss and invalidation counters.
+   */
+  BlockCacheStats get_stats();
+
+  /**
+   * Sets all counters back to zero.
+   */
+  void ResetStats();
+
+private:
+
+  /**
+   * One block slot per address. Left empty until the first block is translated, so emulators that
+   * never use the cache do not pay for it.
+   */
+  std::vector<Block> blocks_;
+
+  /**
+   * Number of valid blocks covering each address, used to skip invalidation scans for writes that
+   * cannot touch any block.
+   */
+  std::vector<uint8_t> coverage_;
+
+  /**
+   * Counters reported by get_stats.
+   */
+  BlockCacheStats stats_;
+
+  /**
+   * Incremented every time a block is discarded.
+   */
+  long long generation_;
+
+  /**
+   * Shared table the block entries point into.
+   */
+  const DispatchEntry* dispatch_table_;
+
+  /**
+   * Translates the block starting at p_address into p_block.
+   */
+  void Translate(int p_address, Ram& p_memory, Block& p_block);
+
+  /**
+   * Marks p_block as invalid and removes it from the coverage counts.
+   */
+  void Discard(Block& p_block);
+
+  /**
+   * Returns true if an instruction of type p_type can change the program counter, meaning it has 
+   * to be the last instruction of a block.
+   */
+  static bool EndsBlock(int p_type);
+};
+
+#endif
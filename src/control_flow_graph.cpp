@@ -0,0 +1,444 @@
+#include "control_flow_graph.hpp"
+
+#include <algorithm>
+
+/**
+ * Returns true if p_instruction ends a basic block: anything that does not just carry on with the
+ * next instruction.
+ */
+static bool ends_block(const Instruction& p_instruction) {
+  switch (p_instruction.type) {
+    case OP_RETURN:
+    case OP_JUMP:
+    case OP_CALL:
+    case OP_JUMP_OFFSET:
+    case OP_SKIP_EQUAL:
+    case OP_SKIP_NOT_EQUAL:
+    case OP_SKIP_REGISTERS_EQUAL:
+    case OP_SKIP_REGISTERS_NOT_EQUAL:
+    case OP_SKIP_KEY_PRESSED:
+    case OP_SKIP_KEY_NOT_PRESSED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int ControlFlowGraph::BlockAt(int p_address) const {
+  auto found = std::lower_bound(blocks.begin(), blocks.end(), p_address,
+    [](const BasicBlock& a, int b) { return a.start < b; });
+  if (found == blocks.end() || found->start != p_address) {
+    return -1;
+  }
+  return found - blocks.begin();
+}
+
+/**
+ * Splits the instructions of p_disassembly into blocks. A block starts at 0x200, at every address
+ * control can arrive at other than by falling through, and after every instruction that ends one.
+ */
+static void split_blocks(const Disassembly& p_disassembly, ControlFlowGraph& p_graph) {
+  const std::vector<DisassembledInstruction>& instructions = p_disassembly.instructions;
+  std::vector<bool> leader(Disassembly::ORIGIN + p_disassembly.rom.size() + 4, false);
+  leader[Disassembly::ORIGIN] = true;
+  for (const DisassembledInstruction& code : instructions) {
+    if (ends_block(code.instruction)) {
+      for (int successor : instruction_successors(code.instruction, code.address)) {
+        if (successor < (int)leader.size()) {
+          leader[successor] = true;
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < (int)instructions.size(); i++) {
+    int address = instructions[i].address;
+    bool starts = i == 0 || leader[address] || ends_block(instructions[i - 1].instruction)
+      || instructions[i - 1].address + 2 != address;
+    if (starts) {
+      BasicBlock block;
+      block.start = address;
+      block.unresolved = false;
+      block.returns = false;
+      block.function = -1;
+      block.loop_depth = 0;
+      p_graph.blocks.push_back(block);
+    }
+    BasicBlock& block = p_graph.blocks.back();
+    block.instructions.push_back(i);
+    block.end = address + 2;
+  }
+}
+
+/**
+ * Adds the edges leaving each block.
+ */
+static void link_blocks(const Disassembly& p_disassembly, ControlFlowGraph& p_graph) {
+  for (BasicBlock& block : p_graph.blocks) {
+    const DisassembledInstruction& last = p_disassembly.instructions[block.instructions.back()];
+    const Instruction& instruction = last.instruction;
+    int next = p_graph.BlockAt(last.address + 2);
+    int target = p_graph.BlockAt(instruction.nnn);
+
+    switch (instruction.type) {
+      case OP_RETURN: {
+        block.returns = true;
+        break;
+      }
+      case OP_JUMP_OFFSET: {
+        block.unresolved = true;
+        p_graph.unresolved_jumps++;
+        break;
+      }
+      case OP_JUMP: {
+        if (target >= 0) {
+          block.successors.push_back({ target, EDGE_JUMP });
+        }
+        break;
+      }
+      case OP_CALL: {
+        if (target >= 0) {
+          block.successors.push_back({ target, EDGE_CALL });
+        }
+        if (next >= 0) {
+          block.successors.push_back({ next, EDGE_NEXT });
+        }
+        break;
+      }
+      default: {
+        if (next >= 0) {
+          block.successors.push_back({ next, EDGE_NEXT });
+        }
+        int skip = p_graph.BlockAt(last.address + 4);
+        if (ends_block(instruction) && skip >= 0) {
+          block.successors.push_back({ skip, EDGE_SKIP });
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Finds the blocks of each function by following every edge but calls from its entry, and which
+ * functions it calls.
+ */
+static void find_functions(const Disassembly& p_disassembly, ControlFlowGraph& p_graph) {
+  std::vector<int> entries = { 0 };
+  for (int subroutine : p_disassembly.subroutines) {
+    int block = p_graph.BlockAt(subroutine);
+    if (block > 0) {
+      entries.push_back(block);
+    }
+  }
+
+  std::vector<int> function_at(p_graph.blocks.size(), -1);
+  for (int entry : entries) {
+    function_at[entry] = p_graph.functions.size();
+    CfgFunction function;
+    function.entry = entry;
+    function.call_depth = 0;
+    function.recursive = false;
+    p_graph.functions.push_back(function);
+  }
+
+  std::vector<int> seen(p_graph.blocks.size(), -1);
+  for (int index = 0; index < (int)p_graph.functions.size(); index++) {
+    CfgFunction& function = p_graph.functions[index];
+    std::vector<int> pending = { function.entry };
+    seen[function.entry] = index;
+    while (!pending.empty()) {
+      int block = pending.back();
+      pending.pop_back();
+      function.blocks.push_back(block);
+      if (p_graph.blocks[block].function < 0) {
+        p_graph.blocks[block].function = index;
+      }
+
+      for (const CfgEdge& edge : p_graph.blocks[block].successors) {
+        if (edge.kind == EDGE_CALL) {
+          if (function_at[edge.target] >= 0) {
+            function.callees.push_back(function_at[edge.target]);
+          }
+        } else if (seen[edge.target] != index) {
+          seen[edge.target] = index;
+          pending.push_back(edge.target);
+        }
+      }
+    }
+    std::sort(function.blocks.begin(), function.blocks.end());
+    std::sort(function.callees.begin(), function.callees.end());
+    function.callees.erase(std::unique(function.callees.begin(), function.callees.end()),
+                           function.callees.end());
+  }
+}
+
+/**
+ * Bookkeeping for measure_calls, which finds the cycles of calls as the strongly connected 
+ * components of the call graph.
+ */
+struct CallSearch {
+  /**
+   * Visit order of each function, -1 until it is visited.
+   */
+  std::vector<int> order;
+
+  /**
+   * Lowest visit order of a function on the chain that each function reaches through its calls.
+   */
+  std::vector<int> lowest;
+
+  /**
+   * Functions visited but not yet placed in a component, in visit order.
+   */
+  std::vector<int> chain;
+  std::vector<bool> on_chain;
+  int visited;
+};
+
+/**
+ * Works out the call depth of function p_function from its callees, marking every function on a
+ * cycle of calls as recursive. A function heads a cycle when none of its calls reach a function 
+ * visited before it, and every function above it on p_search's chain is then on that cycle.
+ */
+static void measure_calls(ControlFlowGraph& p_graph, int p_function, CallSearch& p_search) {
+  CfgFunction& function = p_graph.functions[p_function];
+  p_search.order[p_function] = p_search.lowest[p_function] = p_search.visited++;
+  p_search.chain.push_back(p_function);
+  p_search.on_chain[p_function] = true;
+
+  int depth = 0;
+  for (int callee : function.callees) {
+    if (p_search.order[callee] < 0) {
+      measure_calls(p_graph, callee, p_search);
+    }
+    if (p_search.on_chain[callee]) {
+      // A call back into a function still being measured.
+      p_search.lowest[p_function] = std::min(p_search.lowest[p_function], 
+                                             p_search.lowest[callee]);
+      function.recursive |= callee == p_function;
+      depth = -1;
+      continue;
+    }
+    int below = p_graph.functions[callee].call_depth;
+    if (depth >= 0) {
+      depth = below < 0 ? -1 : std::max(depth, below + 1);
+    }
+  }
+  function.call_depth = depth;
+
+  if (p_search.lowest[p_function] == p_search.order[p_function]) {
+    bool cycle = p_search.chain.back() != p_function;
+    int member;
+    do {
+      member = p_search.chain.back();
+      p_search.chain.pop_back();
+      p_search.on_chain[member] = false;
+      if (cycle) {
+        p_graph.functions[member].recursive = true;
+        p_graph.functions[member].call_depth = -1;
+      }
+    } while (member != p_function);
+  }
+}
+
+/**
+ * Finds the natural loops from the dominator tree of the graph without call edges, every function
+ * entry hanging off a common root.
+ */
+static void find_loops(ControlFlowGraph& p_graph) {
+  int count = p_graph.blocks.size();
+  int root = count;
+  std::vector<std::vector<int>> successors(count + 1);
+  std::vector<std::vector<int>> predecessors(count + 1);
+  for (const CfgFunction& function : p_graph.functions) {
+    successors[root].push_back(function.entry);
+    predecessors[function.entry].push_back(root);
+  }
+  for (int block = 0; block < count; block++) {
+    for (const CfgEdge& edge : p_graph.blocks[block].successors) {
+      if (edge.kind != EDGE_CALL) {
+        successors[block].push_back(edge.target);
+        predecessors[edge.target].push_back(block);
+      }
+    }
+  }
+
+  // Reverse postorder from the root.
+  std::vector<int> order;
+  std::vector<int> position(count + 1, -1);
+  std::vector<bool> visited(count + 1, false);
+  std::vector<std::pair<int, size_t>> stack = { { root, 0 } };
+  visited[root] = true;
+  while (!stack.empty()) {
+    int block = stack.back().first;
+    size_t& next = stack.back().second;
+    if (next < successors[block].size()) {
+      int successor = successors[block][next++];
+      if (!visited[successor]) {
+        visited[successor] = true;
+        stack.push_back({ successor, 0 });
+      }
+    } else {
+      order.push_back(block);
+      stack.pop_back();
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  for (int i = 0; i < (int)order.size(); i++) {
+    position[order[i]] = i;
+  }
+
+  // Immediate dominators, by the iterative algorithm of Cooper, Harvey and Kennedy.
+  std::vector<int> dominator(count + 1, -1);
+  dominator[root] = root;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (int block : order) {
+      if (block == root) {
+        continue;
+      }
+      int candidate = -1;
+      for (int predecessor : predecessors[block]) {
+        if (dominator[predecessor] < 0) {
+          continue;
+        }
+        if (candidate < 0) {
+          candidate = predecessor;
+          continue;
+        }
+        int a = predecessor;
+        int b = candidate;
+        while (a != b) {
+          while (position[a] > position[b]) {
+            a = dominator[a];
+          }
+          while (position[b] > position[a]) {
+            b = dominator[b];
+          }
+        }
+        candidate = a;
+      }
+      if (candidate != dominator[block]) {
+        dominator[block] = candidate;
+        changed = true;
+      }
+    }
+  }
+  auto dominates = [&](int p_a, int p_b) {
+    while (p_b != root && p_b != p_a) {
+      p_b = dominator[p_b];
+    }
+    return p_b == p_a;
+  };
+
+  // Every edge to a block that dominates its source closes a loop headed by that block.
+  std::vector<int> loop_at(count, -1);
+  for (int block = 0; block < count; block++) {
+    if (dominator[block] < 0) {
+      continue;
+    }
+    for (int header : successors[block]) {
+      if (!dominates(header, block)) {
+        continue;
+      }
+      if (loop_at[header] < 0) {
+        loop_at[header] = p_graph.loops.size();
+        p_graph.loops.push_back({ header, { header }, 0 });
+      }
+      CfgLoop& loop = p_graph.loops[loop_at[header]];
+
+      // Walk back from the source of the edge to the header.
+      std::vector<int> pending = { block };
+      while (!pending.empty()) {
+        int member = pending.back();
+        pending.pop_back();
+        if (std::find(loop.blocks.begin(), loop.blocks.end(), member) != loop.blocks.end()) {
+          continue;
+        }
+        loop.blocks.push_back(member);
+        for (int predecessor : predecessors[member]) {
+          if (predecessor != root) {
+            pending.push_back(predecessor);
+          }
+        }
+      }
+    }
+  }
+
+  for (CfgLoop& loop : p_graph.loops) {
+    std::sort(loop.blocks.begin(), loop.blocks.end());
+    for (int block : loop.blocks) {
+      p_graph.blocks[block].loop_depth++;
+    }
+  }
+  for (CfgLoop& loop : p_graph.loops) {
+    loop.depth = p_graph.blocks[loop.header].loop_depth;
+    p_graph.max_loop_depth = std::max(p_graph.max_loop_depth, loop.depth);
+  }
+}
+
+/**
+ * Collects the runs of consecutive code bytes and checks which of them ANNN points into.
+ */
+static void find_regions(const Disassembly& p_disassembly, ControlFlowGraph& p_graph) {
+  int size = p_disassembly.rom.size();
+  for (int offset = 0; offset < size;) {
+    if (!(p_disassembly.flags[offset] & Disassembly::CODE)) {
+      offset++;
+      continue;
+    }
+    CodeRegion region;
+    region.start = Disassembly::ORIGIN + offset;
+    while (offset < size && (p_disassembly.flags[offset] & Disassembly::CODE)) {
+      offset++;
+    }
+    region.end = Disassembly::ORIGIN + offset;
+    region.read_as_data = false;
+    p_graph.regions.push_back(region);
+  }
+
+  for (const DisassembledInstruction& code : p_disassembly.instructions) {
+    if (code.instruction.type != OP_SET_INDEX) {
+      continue;
+    }
+    for (CodeRegion& region : p_graph.regions) {
+      if (code.instruction.nnn >= region.start && code.instruction.nnn < region.end) {
+        region.read_as_data = true;
+      }
+    }
+  }
+}
+
+ControlFlowGraph build_control_flow_graph(const Disassembly& p_disassembly) {
+  ControlFlowGraph graph;
+  graph.max_loop_depth = 0;
+  graph.max_call_depth = 0;
+  graph.unresolved_jumps = 0;
+  graph.reachable_bytes = 0;
+
+  split_blocks(p_disassembly, graph);
+  find_regions(p_disassembly, graph);
+  if (graph.blocks.empty()) {
+    return graph;
+  }
+  link_blocks(p_disassembly, graph);
+  find_functions(p_disassembly, graph);
+  find_loops(graph);
+
+  CallSearch search;
+  search.order.assign(graph.functions.size(), -1);
+  search.lowest.assign(graph.functions.size(), -1);
+  search.on_chain.assign(graph.functions.size(), false);
+  search.visited = 0;
+  for (int function = 0; function < (int)graph.functions.size(); function++) {
+    if (search.order[function] < 0) {
+      measure_calls(graph, function, search);
+    }
+  }
+  graph.max_call_depth = graph.functions[0].call_depth;
+
+  for (const BasicBlock& block : graph.blocks) {
+    graph.reachable_bytes += block.end - block.start;
+  }
+  return graph;
+}
@@ -0,0 +1,179 @@
+#ifndef CONTROL_FLOW_GRAPH_HPP
+#define CONTROL_FLOW_GRAPH_HPP
+
+#include "disassembler.hpp"
+
+#include <vector>
+
+/**
+ * How control gets from one basic block to another.
+ */
+enum CfgEdgeKind {
+  EDGE_NEXT, // Falling through, including back from a call to the instruction after it.
+  EDGE_JUMP, // 1NNN.
+  EDGE_SKIP, // The taken side of a 3XNN, 4XNN, 5XY0, 9XY0, EX9E or EXA1 skip.
+  EDGE_CALL, // 2NNN into a subroutine.
+};
+
+struct CfgEdge {
+  /**
+   * Index of the block control goes to.
+   */
+  int target;
+
+  CfgEdgeKind kind;
+};
+
+/**
+ * A straight run of instructions that is only ever entered at the top and left at the bottom.
+ */
+struct BasicBlock {
+  /**
+   * Address of the first instruction and one past the last byte of the last one.
+   */
+  int start;
+  int end;
+
+  /**
+   * Indices into Disassembly::instructions, in program order.
+   */
+  std::vector<int> instructions;
+
+  std::vector<CfgEdge> successors;
+
+  /**
+   * True if the block ends in a BNNN jump, whose targets depend on V0 and are not in the graph.
+   */
+  bool unresolved;
+
+  /**
+   * True if the block ends in 00EE.
+   */
+  bool returns;
+
+  /**
+   * Index of the first function the block belongs to.
+   */
+  int function;
+
+  /**
+   * Number of loops the block is inside, 0 for none.
+   */
+  int loop_depth;
+};
+
+/**
+ * A natural loop: a header block and every block that can get back to it without passing through
+ * it, found from the edges whose target dominates their source.
+ */
+struct CfgLoop {
+  int header;
+
+  /**
+   * Blocks of the loop, header included, in index order.
+   */
+  std::vector<int> blocks;
+
+  /**
+   * Nesting level, 1 for an outermost loop.
+   */
+  int depth;
+};
+
+/**
+ * The program's main code starting at 0x200, or a subroutine.
+ */
+struct CfgFunction {
+  /**
+   * Block the function starts at.
+   */
+  int entry;
+
+  /**
+   * Blocks reachable from the entry without following calls, in index order.
+   */
+  std::vector<int> blocks;
+
+  /**
+   * Functions called from the function's blocks, in index order.
+   */
+  std::vector<int> callees;
+
+  /**
+   * Most return addresses the function and the calls below it push, so 0 for a function that calls
+   * nothing, or -1 if it can recurse and has no bound.
+   */
+  int call_depth;
+
+  /**
+   * True if the function can end up calling itself.
+   */
+  bool recursive;
+};
+
+/**
+ * A run of consecutive code bytes, the unit worth translating ahead of execution.
+ */
+struct CodeRegion {
+  int start;
+  int end;
+
+  /**
+   * True if an ANNN points I into the region, so its bytes are also read as sprites or data and
+   * could be written over by Fx33 or Fx55.
+   */
+  bool read_as_data;
+};
+
+/**
+ * Control flow graph of the code found by disassemble, with what it says about loops and calls.
+ */
+struct ControlFlowGraph {
+  /**
+   * Blocks in address order. Block 0 starts at 0x200.
+   */
+  std::vector<BasicBlock> blocks;
+
+  std::vector<CfgLoop> loops;
+
+  /**
+   * Functions, the main code at 0x200 first and then subroutines in address order.
+   */
+  std::vector<CfgFunction> functions;
+
+  std::vector<CodeRegion> regions;
+
+  /**
+   * Deepest loop nesting of any block.
+   */
+  int max_loop_depth;
+
+  /**
+   * Most return addresses the program can have on the stack at once, -1 if recursion leaves it
+   * unbounded.
+   */
+  int max_call_depth;
+
+  /**
+   * Number of blocks ending in a BNNN jump.
+   */
+  int unresolved_jumps;
+
+  /**
+   * Bytes of the rom inside blocks.
+   */
+  int reachable_bytes;
+
+  /**
+   * Returns the index of the block starting at p_address, or -1 if none does.
+   */
+  int BlockAt(int p_address) const;
+};
+
+/**
+ * Splits the code of p_disassembly into basic blocks, links them and works out loops, functions,
+ * call depth and code regions.
+ */
+ControlFlowGraph build_control_flow_graph(const Disassembly& p_disassembly);
+
+#endif
@@ -0,0 +1,151 @@
+#include "debugger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+const int Debugger::ADDRESS_COUNT;
+
+bool instruction_memory_access(const Instruction& p_instruction, int p_index,
+                               MemoryAccess& p_access) {
+  p_access.address = p_index;
+  switch (p_instruction.type) {
+    case OP_DRAW: {
+      p_access.length = p_instruction.n;
+      p_access.write = false;
+      return p_access.length > 0;
+    }
+    case OP_STORE_BCD: {
+      p_access.length = 3;
+      p_access.write = true;
+      return true;
+    }
+    case OP_STORE_REGISTERS: {
+      p_access.length = p_instruction.x + 1;
+      p_access.write = true;
+      return true;
+    }
+    case OP_READ_REGISTERS: {
+      p_access.length = p_instruction.x + 1;
+      p_access.write = false;
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+std::string describe_stop(const DebugStop& p_stop) {
+  char text[64];
+  switch (p_stop.reason) {
+    case STOP_PAUSE:
+      std::snprintf(text, sizeof(text), "paused at 0x%03X", p_stop.program_counter);
+      break;
+    case STOP_STEP:
+      std::snprintf(text, sizeof(text), "stepped over 0x%03X", p_stop.program_counter);
+      break;
+    case STOP_BREAKPOINT:
+      std::snprintf(text, sizeof(text), "breakpoint at 0x%03X", p_stop.program_counter);
+      break;
+    case STOP_READ:
+      std::snprintf(text, sizeof(text), "read of 0x%03X at 0x%03X", p_stop.target,
+        p_stop.program_counter);
+      break;
+    case STOP_WRITE:
+      std::snprintf(text, sizeof(text), "write to 0x%03X at 0x%03X", p_stop.target,
+        p_stop.program_counter);
+      break;
+    case STOP_REGISTER:
+      std::snprintf(text, sizeof(text), "V%X changed at 0x%03X", p_stop.target,
+        p_stop.program_counter);
+      break;
+    default:
+      return "not stopped";
+  }
+  return text;
+}
+
+Debugger::Debugger() {
+  Clear();
+  paused_ = false;
+  resuming_ = false;
+  stopped_before_ = false;
+  steps_ = 0;
+  stop_ = { NOT_STOPPED, 0, 0 };
+  stop_count_ = 0;
+}
+
+void Debugger::SetBreakpoint(int p_address, bool p_enabled) {
+  if (p_address < 0 || p_address >= ADDRESS_COUNT) {
+    return;
+  }
+  if (p_enabled) {
+    flags_[p_address] |= BREAKPOINT;
+  } else {
+    flags_[p_address] &= ~BREAKPOINT;
+  }
+}
+
+bool Debugger::HasBreakpoint(int p_address) const {
+  return p_address >= 0 && p_address < ADDRESS_COUNT && (flags_[p_address] & BREAKPOINT);
+}
+
+void Debugger::SetWatchpoint(int p_first, int p_last, uint8_t p_flags) {
+  p_flags &= WATCH_READ | WATCH_WRITE;
+  for (int address = std::max(p_first, 0); address <= std::min(p_last, ADDRESS_COUNT - 1);
+       address++) {
+    bool watched = flags_[address] & (WATCH_READ | WATCH_WRITE);
+    flags_[address] = (flags_[address] & BREAKPOINT) | p_flags;
+    watchpoint_count_ += (p_flags != 0) - watched;
+  }
+}
+
+void Debugger::WatchRegister(int p_register, bool p_enabled) {
+  if (p_register < 0 || p_register > 0xF) {
+    return;
+  }
+  if (p_enabled) {
+    watched_registers_ |= 1 << p_register;
+  } else {
+    watched_registers_ &= ~(1 << p_register);
+  }
+}
+
+void Debugger::Clear() {
+  flags_.fill(0);
+  watchpoint_count_ = 0;
+  watched_registers_ = 0;
+}
+
+void Debugger::Pause(int p_program_counter) {
+  if (!paused_) {
+    Stop(STOP_PAUSE, p_program_counter, p_program_counter, true);
+  }
+}
+
+void Debugger::Resume() {
+  resuming_ = stopped_before_;
+  stopped_before_ = false;
+  paused_ = false;
+}
+
+void Debugger::StepInstruction() {
+  Resume();
+  steps_ = 1;
+}
+
+DebugStop Debugger::get_stop() const {
+  return stop_;
+}
+
+long long Debugger::get_stop_count() const {
+  return stop_count_;
+}
+
+void Debugger::Stop(StopReason p_reason, int p_address, int p_target, bool p_before) {
+  paused_ = true;
+  stopped_before_ = p_before;
+  steps_ = 0;
+  stop_ = { p_reason, p_address, p_target };
+  stop_count_++;
+}
@@ -0,0 +1,249 @@
+#ifndef DEBUGGER_HPP
+#define DEBUGGER_HPP
+
+#include "opcode.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * Why a Debugger stopped execution.
+ */
+enum StopReason {
+  NOT_STOPPED,
+  STOP_PAUSE,      // Pause was called.
+  STOP_STEP,       // StepInstruction's instruction has run.
+  STOP_BREAKPOINT, // The program counter reached a breakpoint.
+  STOP_READ,       // An instruction was about to read a watched address.
+  STOP_WRITE,      // An instruction was about to write a watched address.
+  STOP_REGISTER,   // An instruction changed a watched register.
+};
+
+/**
+ * Where and why execution stopped.
+ */
+struct DebugStop {
+  StopReason reason;
+
+  /**
+   * Address of the instruction that was about to run, or for STOP_STEP and STOP_REGISTER the one
+   * that just ran.
+   */
+  int program_counter;
+
+  /**
+   * The watched address that was hit, or the register that changed.
+   */
+  int target;
+};
+
+/**
+ * Memory an instruction reads or writes through the index register, besides fetching itself.
+ */
+struct MemoryAccess {
+  int address;
+  int length;
+  bool write;
+};
+
+/**
+ * Works out the memory p_instruction touches when I holds p_index: the sprite Dxyn draws, the
+ * digits Fx33 stores and the registers Fx55 and Fx65 store and load. Returns false for instructions
+ * that touch no memory.
+ */
+bool instruction_memory_access(const Instruction& p_instruction, int p_index,
+                               MemoryAccess& p_access);
+
+/**
+ * Returns a readable description of p_stop, e.g. "breakpoint at 0x23A".
+ */
+std::string describe_stop(const DebugStop& p_stop);
+
+/**
+ * Breakpoints on addresses, read and write watchpoints on memory and triggers on register changes,
+ * checked by an Emu it is attached to with set_debugger. While attached the emulator runs one
+ * instruction at a time through a separate loop that does the checks. Without a debugger the
+ * engines run as usual, so the checks cost nothing.
+ *
+ * Execution stops before an instruction at a breakpoint, or one that would access a watched
+ * address, runs, and after an instruction that changed a watched register. Once stopped the
+ * debugger stays paused, so the emulator executes nothing, until Resume or StepInstruction.
+ * Resuming runs the instruction that was stopped at without checking it again.
+ */
+class Debugger {
+
+public:
+
+  /**
+   * Number of addresses that can be watched, one for every byte of memory.
+   */
+  const static int ADDRESS_COUNT = 4096;
+
+  /**
+   * What is set on each address.
+   */
+  enum WatchFlags : uint8_t {
+    BREAKPOINT = 1,
+    WATCH_READ = 2,
+    WATCH_WRITE = 4,
+  };
+
+  Debugger();
+
+  /**
+   * Sets or clears a breakpoint on the instruction at p_address.
+   */
+  void SetBreakpoint(int p_address, bool p_enabled);
+
+  /**
+   * Returns true if there is a breakpoint at p_address.
+   */
+  bool HasBreakpoint(int p_address) const;
+
+  /**
+   * Watches the addresses p_first to p_last inclusive for the accesses in p_flags, WATCH_READ,
+   * WATCH_WRITE or both. Flags of 0 stop watching the addresses.
+   */
+  void SetWatchpoint(int p_first, int p_last, uint8_t p_flags);
+
+  /**
+   * Starts or stops watching variable register p_register for changes.
+   */
+  void WatchRegister(int p_register, bool p_enabled);
+
+  /**
+   * Removes every breakpoint, watchpoint and register trigger.
+   */
+  void Clear();
+
+  /**
+   * Stops execution before the instruction at p_program_counter, the one the emulator's program
+   * counter points at.
+   */
+  void Pause(int p_program_counter);
+
+  /**
+   * Lets execution carry on from where it stopped.
+   */
+  void Resume();
+
+  /**
+   * Lets exactly one instruction run before stopping again.
+   */
+  void StepInstruction();
+
+  bool is_paused() const { return paused_; }
+
+  /**
+   * Returns where the last stop happened, with reason NOT_STOPPED if there has been none.
+   */
+  DebugStop get_stop() const;
+
+  /**
+   * Returns the number of times execution has stopped.
+   */
+  long long get_stop_count() const;
+
+  /**
+   * Returns true if any address has a read or write watchpoint, so instructions need their memory
+   * accesses checked.
+   */
+  bool has_watchpoints() const { return watchpoint_count_ > 0; }
+
+  /**
+   * Returns a mask with bit n set if register Vn is watched.
+   */
+  uint16_t get_watched_registers() const { return watched_registers_; }
+
+  /**
+   * Called by the emulator before running the instruction at p_address. Returns false if execution
+   * has to stop first.
+   */
+  bool BeforeInstruction(int p_address) {
+    if (paused_) {
+      return false;
+    }
+    if (!resuming_ && (flags_[p_address & (ADDRESS_COUNT - 1)] & BREAKPOINT)) {
+      Stop(STOP_BREAKPOINT, p_address, p_address, true);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Called by the emulator before the instruction at p_address makes p_access. Returns false if
+   * execution has to stop first.
+   */
+  bool BeforeAccess(int p_address, const MemoryAccess& p_access) {
+    if (resuming_) {
+      return true;
+    }
+    uint8_t watched = p_access.write ? WATCH_WRITE : WATCH_READ;
+    // Addresses past the end of memory read as 0 and are never written, so are never watched.
+    int end = std::min(p_access.address + p_access.length, (int)ADDRESS_COUNT);
+    for (int address = p_access.address; address < end; address++) {
+      if (flags_[address] & watched) {
+        Stop(p_access.write ? STOP_WRITE : STOP_READ, p_address, address, true);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Called by the emulator after the instruction at p_address ran and changed watched register
+   * p_register.
+   */
+  void RegisterChanged(int p_address, int p_register) {
+    Stop(STOP_REGISTER, p_address, p_register, false);
+  }
+
+  /**
+   * Called by the emulator after the instruction at p_address ran.
+   */
+  void AfterInstruction(int p_address) {
+    resuming_ = false;
+    if (steps_ > 0 && --steps_ == 0 && !paused_) {
+      Stop(STOP_STEP, p_address, p_address, false);
+    }
+  }
+
+private:
+
+  std::array<uint8_t, ADDRESS_COUNT> flags_;
+
+  /**
+   * Number of addresses with a read or write watchpoint.
+   */
+  int watchpoint_count_;
+
+  uint16_t watched_registers_;
+
+  bool paused_;
+
+  /**
+   * Set by Resume and StepInstruction when execution stopped before an instruction, so that
+   * instruction runs without being checked again. Cleared once it has run.
+   */
+  bool resuming_;
+
+  /**
+   * True if the last stop happened before its instruction ran.
+   */
+  bool stopped_before_;
+
+  /**
+   * Instructions left to run before stopping, 0 when not stepping.
+   */
+  int steps_;
+
+  DebugStop stop_;
+
+  long long stop_count_;
+
+  void Stop(StopReason p_reason, int p_address, int p_target, bool p_before);
+};
+
+#endif
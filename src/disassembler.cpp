@@ -0,0 +1,175 @@
+#include "disassembler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+const int Disassembly::ORIGIN;
+
+/**
+ * Highest address a Chip-8 program can reach.
+ */
+static const int MEMORY_END = 0x1000;
+
+int Disassembly::Find(int p_address) const {
+  auto found = std::lower_bound(instructions.begin(), instructions.end(), p_address,
+    [](const DisassembledInstruction& a, int b) { return a.address < b; });
+  if (found == instructions.end() || found->address != p_address) {
+    return -1;
+  }
+  return found - instructions.begin();
+}
+
+std::vector<int> instruction_successors(const Instruction& p_instruction, int p_address) {
+  std::vector<int> successors;
+  switch (p_instruction.type) {
+    case OP_RETURN:
+    case OP_JUMP_OFFSET:
+    case OP_UNKNOWN: {
+      break;
+    }
+    case OP_JUMP: {
+      successors.push_back(p_instruction.nnn);
+      break;
+    }
+    case OP_CALL: {
+      successors.push_back(p_instruction.nnn);
+      successors.push_back(p_address + 2);
+      break;
+    }
+    case OP_SKIP_EQUAL:
+    case OP_SKIP_NOT_EQUAL:
+    case OP_SKIP_REGISTERS_EQUAL:
+    case OP_SKIP_REGISTERS_NOT_EQUAL:
+    case OP_SKIP_KEY_PRESSED:
+    case OP_SKIP_KEY_NOT_PRESSED: {
+      successors.push_back(p_address + 2);
+      successors.push_back(p_address + 4);
+      break;
+    }
+    default: {
+      successors.push_back(p_address + 2);
+    }
+  }
+  return successors;
+}
+
+Disassembly disassemble(const uint8_t* p_rom, int p_size) {
+  Disassembly disassembly;
+  p_size = std::max(0, std::min(p_size, MEMORY_END - Disassembly::ORIGIN));
+  disassembly.rom.assign(p_rom, p_rom + p_size);
+  disassembly.flags.assign(p_size, 0);
+  disassembly.indirect_jumps = false;
+
+  std::vector<uint8_t>& flags = disassembly.flags;
+  std::vector<int> pending = { Disassembly::ORIGIN };
+  while (!pending.empty()) {
+    int address = pending.back();
+    pending.pop_back();
+
+    // Follow straight-line code until it leaves the rom, runs into code already seen or ends.
+    while (true) {
+      int offset = address - Disassembly::ORIGIN;
+      if (offset < 0 || offset + 1 >= p_size || (flags[offset] & Disassembly::INSTRUCTION)) {
+        break;
+      }
+      Instruction instruction = decode_instruction(p_rom[offset] << 8 | p_rom[offset + 1]);
+      if (instruction.type == OP_UNKNOWN) {
+        break;
+      }
+      flags[offset] |= Disassembly::CODE | Disassembly::INSTRUCTION;
+      flags[offset + 1] |= Disassembly::CODE;
+      disassembly.instructions.push_back({ address, instruction });
+
+      int target = instruction.nnn - Disassembly::ORIGIN;
+      bool target_in_rom = target >= 0 && target < p_size;
+      if (instruction.type == OP_JUMP && target_in_rom) {
+        flags[target] |= Disassembly::LABEL;
+      } else if (instruction.type == OP_CALL && target_in_rom) {
+        flags[target] |= Disassembly::SUBROUTINE;
+      } else if (instruction.type == OP_JUMP_OFFSET) {
+        disassembly.indirect_jumps = true;
+        if (target_in_rom) {
+          flags[target] |= Disassembly::LABEL;
+        }
+      }
+
+      std::vector<int> successors = instruction_successors(instruction, address);
+      if (successors.empty()) {
+        break;
+      }
+      // Carry on with the first successor here, the rest are explored later.
+      pending.insert(pending.end(), successors.begin() + 1, successors.end());
+      address = successors[0];
+    }
+  }
+
+  std::sort(disassembly.instructions.begin(), disassembly.instructions.end(),
+    [](const DisassembledInstruction& a, const DisassembledInstruction& b) {
+      return a.address < b.address;
+    });
+  for (int offset = 0; offset < p_size; offset++) {
+    if (flags[offset] & Disassembly::LABEL) {
+      disassembly.labels.push_back(Disassembly::ORIGIN + offset);
+    }
+    if (flags[offset] & Disassembly::SUBROUTINE) {
+      disassembly.subroutines.push_back(Disassembly::ORIGIN + offset);
+    }
+  }
+  return disassembly;
+}
+
+std::string format_instruction(const Instruction& p_instruction, const std::string& p_target) {
+  char text[48];
+  const char* target = p_target.c_str();
+  char address[8];
+  if (p_target.empty()) {
+    std::snprintf(address, sizeof(address), "0x%03X", p_instruction.nnn);
+    target = address;
+  }
+
+  int x = p_instruction.x;
+  int y = p_instruction.y;
+  int nn = p_instruction.nn;
+  switch (p_instruction.type) {
+    case OP_CLEAR_SCREEN: return "CLS";
+    case OP_RETURN: return "RET";
+    case OP_JUMP: std::snprintf(text, sizeof(text), "JP %s", target); break;
+    case OP_CALL: std::snprintf(text, sizeof(text), "CALL %s", target); break;
+    case OP_SKIP_EQUAL: std::snprintf(text, sizeof(text), "SE V%X, 0x%02X", x, nn); break;
+    case OP_SKIP_NOT_EQUAL: std::snprintf(text, sizeof(text), "SNE V%X, 0x%02X", x, nn); break;
+    case OP_SKIP_REGISTERS_EQUAL: std::snprintf(text, sizeof(text), "SE V%X, V%X", x, y); break;
+    case OP_SET_REGISTER: std::snprintf(text, sizeof(text), "LD V%X, 0x%02X", x, nn); break;
+    case OP_ADD_VALUE: std::snprintf(text, sizeof(text), "ADD V%X, 0x%02X", x, nn); break;
+    case OP_COPY_REGISTER: std::snprintf(text, sizeof(text), "LD V%X, V%X", x, y); break;
+    case OP_OR: std::snprintf(text, sizeof(text), "OR V%X, V%X", x, y); break;
+    case OP_AND: std::snprintf(text, sizeof(text), "AND V%X, V%X", x, y); break;
+    case OP_XOR: std::snprintf(text, sizeof(text), "XOR V%X, V%X", x, y); break;
+    case OP_ADD_REGISTERS: std::snprintf(text, sizeof(text), "ADD V%X, V%X", x, y); break;
+    case OP_SUBTRACT: std::snprintf(text, sizeof(text), "SUB V%X, V%X", x, y); break;
+    case OP_SHIFT_RIGHT: std::snprintf(text, sizeof(text), "SHR V%X, V%X", x, y); break;
+    case OP_SUBTRACT_REVERSE: std::snprintf(text, sizeof(text), "SUBN V%X, V%X", x, y); break;
+    case OP_SHIFT_LEFT: std::snprintf(text, sizeof(text), "SHL V%X, V%X", x, y); break;
+    case OP_SKIP_REGISTERS_NOT_EQUAL:
+      std::snprintf(text, sizeof(text), "SNE V%X, V%X", x, y);
+      break;
+    case OP_SET_INDEX: std::snprintf(text, sizeof(text), "LD I, %s", target); break;
+    case OP_JUMP_OFFSET: std::snprintf(text, sizeof(text), "JP V0, %s", target); break;
+    case OP_RANDOM: std::snprintf(text, sizeof(text), "RND V%X, 0x%02X", x, nn); break;
+    case OP_DRAW:
+      std::snprintf(text, sizeof(text), "DRW V%X, V%X, %d", x, y, p_instruction.n);
+      break;
+    case OP_SKIP_KEY_PRESSED: std::snprintf(text, sizeof(text), "SKP V%X", x); break;
+    case OP_SKIP_KEY_NOT_PRESSED: std::snprintf(text, sizeof(text), "SKNP V%X", x); break;
+    case OP_GET_DELAY: std::snprintf(text, sizeof(text), "LD V%X, DT", x); break;
+    case OP_WAIT_KEY: std::snprintf(text, sizeof(text), "LD V%X, K", x); break;
+    case OP_SET_DELAY: std::snprintf(text, sizeof(text), "LD DT, V%X", x); break;
+    case OP_SET_SOUND: std::snprintf(text, sizeof(text), "LD ST, V%X", x); break;
+    case OP_ADD_INDEX: std::snprintf(text, sizeof(text), "ADD I, V%X", x); break;
+    case OP_SET_SPRITE: std::snprintf(text, sizeof(text), "LD F, V%X", x); break;
+    case OP_STORE_BCD: std::snprintf(text, sizeof(text), "LD B, V%X", x); break;
+    case OP_STORE_REGISTERS: std::snprintf(text, sizeof(text), "LD [I], V%X", x); break;
+    case OP_READ_REGISTERS: std::snprintf(text, sizeof(text), "LD V%X, [I]", x); break;
+    default: std::snprintf(text, sizeof(text), "DW 0x%04X", p_instruction.Opcode()); break;
+  }
+  return text;
+}
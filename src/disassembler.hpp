@@ -0,0 +1,92 @@
+#ifndef DISASSEMBLER_HPP
+#define DISASSEMBLER_HPP
+
+#include "opcode.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An instruction found by disassemble, with the address it sits at.
+ */
+struct DisassembledInstruction {
+  int address;
+  Instruction instruction;
+};
+
+/**
+ * A rom split into code and data by recursive descent from the program start.
+ */
+struct Disassembly {
+  /**
+   * Address the first byte of the rom is loaded at.
+   */
+  const static int ORIGIN = 0x200;
+
+  /**
+   * What each byte of the rom turned out to be, one entry per byte, indexed from ORIGIN.
+   */
+  enum ByteFlags : uint8_t {
+    CODE = 1,        // Part of an instruction that can be reached.
+    INSTRUCTION = 2, // First byte of a reachable instruction.
+    LABEL = 4,       // Target of a 1NNN jump or the base of a BNNN jump.
+    SUBROUTINE = 8,  // Target of a 2NNN call.
+  };
+
+  std::vector<uint8_t> rom;
+
+  std::vector<uint8_t> flags;
+
+  /**
+   * Every reachable instruction, in address order.
+   */
+  std::vector<DisassembledInstruction> instructions;
+
+  /**
+   * Jump and call targets in the rom, in address order.
+   */
+  std::vector<int> labels;
+  std::vector<int> subroutines;
+
+  /**
+   * True if the rom has a BNNN jump, whose targets depend on V0 and so were not followed.
+   */
+  bool indirect_jumps;
+
+  /**
+   * Returns true if p_address is inside the rom and has all of p_flags set.
+   */
+  bool Has(int p_address, uint8_t p_flags) const {
+    int offset = p_address - ORIGIN;
+    return offset >= 0 && offset < (int)flags.size() && (flags[offset] & p_flags) == p_flags;
+  }
+
+  /**
+   * Returns the index into instructions of the instruction at p_address, or -1 if none starts
+   * there.
+   */
+  int Find(int p_address) const;
+};
+
+/**
+ * Disassembles the p_size byte rom at p_rom by following every path from the program start: jumps,
+ * calls, returns and both ways out of skips. Bytes no path reaches are data. Instructions do not
+ * have to be two byte aligned, and paths stop at opcodes that decode to nothing.
+ */
+Disassembly disassemble(const uint8_t* p_rom, int p_size);
+
+/**
+ * Returns the addresses execution can continue at after p_instruction at p_address, leaving out
+ * BNNN's unknown target and the return address of 00EE.
+ */
+std::vector<int> instruction_successors(const Instruction& p_instruction, int p_address);
+
+/**
+ * Returns p_instruction in the usual Chip-8 assembly syntax, e.g. "DRW V0, V1, 5". Address operands
+ * are written as p_target if it is not empty, as hex otherwise.
+ */
+std::string format_instruction(const Instruction& p_instruction,
+                               const std::string& p_target = "");
+
+#endif
@@ -0,0 +1,179 @@
+#include "dispatch_table.hpp"
+#include "emu.hpp"
+
+#include <iostream>
+
+const int DispatchTable::ENTRIES;
+
+const DispatchEntry* DispatchTable::Get() {
+  // Function-local statics are initialized exactly once, even if several threads get here first.
+  static const DispatchEntry* table = Build();
+  return table;
+}
+
+const DispatchEntry* DispatchTable::Build() {
+  DispatchEntry* table = new DispatchEntry[ENTRIES];
+  for (int i = 0; i < ENTRIES; i++) {
+    table[i].instruction = decode_instruction(i);
+    table[i].handler = GetHandler(table[i].instruction.type);
+  }
+  return table;
+}
+
+InstructionHandler DispatchTable::GetHandler(int p_type) {
+  // Indexed by InstructionType, so the order here must match the enum.
+  static const InstructionHandler handlers[INSTRUCTION_TYPE_COUNT] = {
+    ClearScreen, Return, Jump, Call, SkipEqual, SkipNotEqual, SkipRegistersEqual, SetRegister,
+    AddValue, CopyRegister, Or, And, Xor, AddRegisters, Subtract, ShiftRight, SubtractReverse, 
+    ShiftLeft, SkipRegistersNotEqual, SetIndex, JumpOffset, Random, Draw, SkipKeyPressed, 
+    SkipKeyNotPressed, GetDelay, WaitKey, SetDelay, SetSound, AddIndex, SetSprite, StoreBcd, 
+    StoreRegisters, ReadRegisters, Unknown
+  };
+
+  InstructionHandler handler = Unknown;
+  if (p_type >= 0 && p_type < INSTRUCTION_TYPE_COUNT) {
+    handler = handlers[p_type];
+  }
+  return handler;
+}
+
+void DispatchTable::ClearScreen(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ClearScreen();
+}
+
+void DispatchTable::Return(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ReturnFromSubroutine();
+}
+
+void DispatchTable::Jump(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.Jump(p_instruction.nnn);
+}
+
+void DispatchTable::Call(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ExecuteSubroutine(p_instruction.nnn);
+}
+
+void DispatchTable::SkipEqual(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfEqual(p_instruction.x, p_instruction.nn);
+}
+
+void DispatchTable::SkipNotEqual(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfNotEqual(p_instruction.x, p_instruction.nn);
+}
+
+void DispatchTable::SkipRegistersEqual(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfRegistersEqual(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::SetRegister(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.set_register(p_instruction.x, p_instruction.nn);
+}
+
+void DispatchTable::AddValue(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.AddValToRegister(p_instruction.x, p_instruction.nn);
+}
+
+void DispatchTable::CopyRegister(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.CopyRegister(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::Or(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.OrRegisters(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::And(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.AndRegisters(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::Xor(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.XorRegisters(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::AddRegisters(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.AddRegisters(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::Subtract(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SubtractRegisters(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::ShiftRight(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ShiftRight(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::SubtractReverse(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SubtractRegistersReverse(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::ShiftLeft(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ShiftLeft(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::SkipRegistersNotEqual(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfRegistersNotEqual(p_instruction.x, p_instruction.y);
+}
+
+void DispatchTable::SetIndex(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.set_index_register(p_instruction.nnn);
+}
+
+void DispatchTable::JumpOffset(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.Jump(p_emu.get_register(0) + p_instruction.nnn);
+}
+
+void DispatchTable::Random(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.GenerateRandom(p_instruction.x, p_instruction.nn);
+}
+
+void DispatchTable::Draw(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.DisplaySprite(p_instruction.n, p_emu.get_register(p_instruction.x), 
+    p_emu.get_register(p_instruction.y));
+}
+
+void DispatchTable::SkipKeyPressed(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfKeyPressed(p_instruction.x);
+}
+
+void DispatchTable::SkipKeyNotPressed(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SkipIfKeyNotPressed(p_instruction.x);
+}
+
+void DispatchTable::GetDelay(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.set_register(p_instruction.x, p_emu.delay_timer_);
+}
+
+void DispatchTable::WaitKey(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.WaitForKeyPress(p_instruction.x);
+}
+
+void DispatchTable::SetDelay(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.set_delay_timer(p_emu.get_register(p_instruction.x));
+}
+
+void DispatchTable::SetSound(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.set_sound_timer(p_emu.get_register(p_instruction.x));
+}
+
+void DispatchTable::AddIndex(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.AddRegisterToIndex(p_instruction.x);
+}
+
+void DispatchTable::SetSprite(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.SetSpriteMemoryAddress(p_instruction.x);
+}
+
+void DispatchTable::StoreBcd(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.StoreBinaryCodedDecimal(p_instruction.x);
+}
+
+void DispatchTable::StoreRegisters(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.StoreRegistersToMem(p_instruction.x);
+}
+
+void DispatchTable::ReadRegisters(Emu& p_emu, const Instruction& p_instruction) {
+  p_emu.ReadMemToRegisters(p_instruction.x);
+}
+
+void DispatchTable::Unknown(Emu& p_emu, const Instruction& p_instruction) {
+  std::cout << "-> Unknown instruction 0x" << std::hex << p_instruction.Opcode() << std::endl;
+}
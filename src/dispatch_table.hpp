@@ -0,0 +1,93 @@
+#ifndef DISPATCH_TABLE_HPP
+#define DISPATCH_TABLE_HPP
+
+#include "opcode.hpp"
+
+class Emu;
+
+/**
+ * Function that executes a single decoded instruction on the given emulator.
+ */
+typedef void (*InstructionHandler)(Emu& p_emu, const Instruction& p_instruction);
+
+/**
+ * One entry of the dispatch table: the handler for an opcode and the operands to pass it.
+ */
+struct DispatchEntry {
+  InstructionHandler handler;
+  Instruction instruction;
+};
+
+/**
+ * Table holding all 65,536 possible opcodes, each predecoded into a handler and its operands. The 
+ * table is built once on first use and shared by every emulator, so executing an opcode is a single
+ * indexed load followed by an indirect call.
+ */
+class DispatchTable {
+
+public:
+
+  /**
+   * Number of entries in the table, one per 16-bit opcode.
+   */
+  const static int ENTRIES = 0x10000;
+
+  /**
+   * Returns a pointer to the first entry of the shared table, building it on the first call.
+   */
+  static const DispatchEntry* Get();
+
+  /**
+   * Returns the handler used to execute instructions of type p_type.
+   */
+  static InstructionHandler GetHandler(int p_type);
+
+private:
+
+  /**
+   * Predecodes every opcode into a freshly allocated table.
+   */
+  static const DispatchEntry* Build();
+
+  /**
+   * Instruction handlers, one per InstructionType. Each forwards the pre-extracted operands to the
+   * matching Emu instruction method.
+   */
+  static void ClearScreen(Emu& p_emu, const Instruction& p_instruction);
+  static void Return(Emu& p_emu, const Instruction& p_instruction);
+  static void Jump(Emu& p_emu, const Instruction& p_instruction);
+  static void Call(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipEqual(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipNotEqual(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipRegistersEqual(Emu& p_emu, const Instruction& p_instruction);
+  static void SetRegister(Emu& p_emu, const Instruction& p_instruction);
+  static void AddValue(Emu& p_emu, const Instruction& p_instruction);
+  static void CopyRegister(Emu& p_emu, const Instruction& p_instruction);
+  static void Or(Emu& p_emu, const Instruction& p_instruction);
+  static void And(Emu& p_emu, const Instruction& p_instruction);
+  static void Xor(Emu& p_emu, const Instruction& p_instruction);
+  static void AddRegisters(Emu& p_emu, const Instruction& p_instruction);
+  static void Subtract(Emu& p_emu, const Instruction& p_instruction);
+  static void ShiftRight(Emu& p_emu, const Instruction& p_instruction);
+  static void SubtractReverse(Emu& p_emu, const Instruction& p_instruction);
+  static void ShiftLeft(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipRegistersNotEqual(Emu& p_emu, const Instruction& p_instruction);
+  static void SetIndex(Emu& p_emu, const Instruction& p_instruction);
+  static void JumpOffset(Emu& p_emu, const Instruction& p_instruction);
+  static void Random(Emu& p_emu, const Instruction& p_instruction);
+  static void Draw(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipKeyPressed(Emu& p_emu, const Instruction& p_instruction);
+  static void SkipKeyNotPressed(Emu& p_emu, const Instruction& p_instruction);
+  static void GetDelay(Emu& p_emu, const Instruction& p_instruction);
+  static void WaitKey(Emu& p_emu, const Instruction& p_instruction);
+  static void SetDelay(Emu& p_emu, const Instruction& p_instruction);
+  static void SetSound(Emu& p_emu, const Instruction& p_instruction);
+  static void AddIndex(Emu& p_emu, const Instruction& p_instruction);
+  static void SetSprite(Emu& p_emu, const Instruction& p_instruction);
+  static void StoreBcd(Emu& p_emu, const Instruction& p_instruction);
+  static void StoreRegisters(Emu& p_emu, const Instruction& p_instruction);
+  static void ReadRegisters(Emu& p_emu, const Instruction& p_instruction);
+  static void Unknown(Emu& p_emu, const Instruction& p_instruction);
+};
+
+#endif
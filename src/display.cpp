@@ -5,89 +5,97 @@
 #include <iostream>
 
 Display::Display() {
-  for (int i = 0; i < pixels_.size(); i++) {
-    pixels_[i].fill(0);
+  generation_ = 0;
+  rows_.fill(0);
+}
+
+void Display::SetPixel(int p_row, int p_col, bool p_value) {
+  if (!(p_row < 0 || p_row >= PIXEL_HEIGHT || p_col < 0 || p_col >= PIXEL_WIDTH)) {
+    uint64_t mask = uint64_t(1) << (PIXEL_WIDTH - 1 - p_col);
+    uint64_t row = p_value ? (rows_[p_row] | mask) : (rows_[p_row] & ~mask);
+    if (row != rows_[p_row]) {
+      rows_[p_row] = row;
+      generation_++;
+    }
   }
 }
 
-Display::Display(SDL_Renderer* p_renderer) {
-  renderer_ = p_renderer;
-  for (int i = 0; i < pixels_.size(); i++) {
-    pixels_[i].fill(0);
+bool Display::GetPixel(int p_row, int p_col) const {
+  bool return_val = false;
+  if (!(p_row < 0 || p_col < 0 || p_row >= PIXEL_HEIGHT || p_col >= PIXEL_WIDTH)) {
+    return_val = (rows_[p_row] >> (PIXEL_WIDTH - 1 - p_col)) & 1;
   }
+  return return_val;
 }
 
-void Display::Render() {
-  SDL_SetRenderDrawColor(renderer_, 255, 255, 255, 255);
-  for (int i = 0; i < pixels_.size(); i++) {
-    std::array<bool, PIXEL_WIDTH> current_row = pixels_[i];
-    for (int j = 0; j < PIXEL_WIDTH; j++) {
-      if (current_row[j]) {
-        SDL_Rect rect{
-          j*10,
-          i*10,
-          10,
-          10
-        };
-        SDL_RenderFillRect(renderer_, &rect);
-      }
-    }
+bool Display::DrawSprite(int p_x, int p_y, const uint8_t* p_rows, int p_count) {
+  // Wrap the starting position around the screen, both dimensions are powers of two.
+  int x = p_x & (PIXEL_WIDTH - 1);
+  int y = p_y & (PIXEL_HEIGHT - 1);
+
+  uint64_t collisions = 0;
+  uint64_t drawn = 0;
+  for (int i = 0; i < p_count && y + i < PIXEL_HEIGHT; i++) {
+    // Line the sprite byte up with column x, anything past the right edge is shifted out.
+    uint64_t bits = (uint64_t(p_rows[i]) << (PIXEL_WIDTH - 8)) >> x;
+    collisions |= rows_[y + i] & bits;
+    rows_[y + i] ^= bits;
+    drawn |= bits;
   }
+
+  if (drawn != 0) {
+    generation_++;
+  }
+  return collisions != 0;
 }
 
-void Display::SetPixel(int p_row, int p_col, bool p_value) {
-  if (!(p_row < 0 || p_row > PIXEL_HEIGHT || p_col < 0 || p_col > PIXEL_WIDTH)) {
-    pixels_[p_row][p_col] = p_value;
+uint64_t Display::GetRow(int p_row) const {
+  uint64_t row = 0;
+  if (p_row >= 0 && p_row < PIXEL_HEIGHT) {
+    row = rows_[p_row];
   }
+  return row;
 }
 
-bool Display::GetPixel(int p_row, int p_col) {
-  bool return_val = false;
-  if (!(p_row < 0 || p_col < 0 || p_row >= PIXEL_HEIGHT || p_col >= PIXEL_WIDTH)) {
-    return_val = pixels_[p_row][p_col];
+void Display::SetRow(int p_row, uint64_t p_pixels) {
+  if (p_row >= 0 && p_row < PIXEL_HEIGHT && rows_[p_row] != p_pixels) {
+    rows_[p_row] = p_pixels;
+    generation_++;
   }
-  return return_val;
 }
 
-int Display::get_pixel_width() {
+int Display::get_pixel_width() const {
   return PIXEL_WIDTH;
 }
 
-int Display::get_pixel_height() {
+int Display::get_pixel_height() const {
   return PIXEL_HEIGHT;
 }
 
-void Display::Print() {
-  for (auto row : pixels_) {
-    for (bool value : row) {
-      std::cout << value;
+long long Display::get_generation() const {
+  return generation_;
+}
+
+void Display::Print() const {
+  for (int i = 0; i < PIXEL_HEIGHT; i++) {
+    for (int j = 0; j < PIXEL_WIDTH; j++) {
+      std::cout << GetPixel(i, j);
     }
     std::cout << std::endl;
   }
 }
 
 void Display::Clear() {
-  for (int i = 0; i < PIXEL_HEIGHT; i++) {
-    for (int j = 0; j < PIXEL_WIDTH; j++) {
-      SetPixel(i, j, 0);
-    }
+  if (!IsClear()) {
+    rows_.fill(0);
+    generation_++;
   }
 }
 
-bool Display::IsClear() {
-  bool is_clear = true;
-  for (int i = 0; i < pixels_.size(); i++) {
-    for (int j = 0; j < pixels_[i].size(); j++) {
-      // If a single pixel is found in any row, display isn't clear.
-      if (pixels_[i][j]) {
-        is_clear = false;
-        break;
-      }
-    }
-    // This is true only if a pixel has been found to be enabled, so stop searching and break.
-    if (!is_clear) {
-      break;
-    }
+bool Display::IsClear() const {
+  uint64_t pixels = 0;
+  for (int i = 0; i < PIXEL_HEIGHT; i++) {
+    pixels |= rows_[i];
   }
-  return is_clear;
-}
\ No newline at end of file
+  return pixels == 0;
+}
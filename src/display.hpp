@@ -3,12 +3,12 @@
 #ifndef DISPLAY_HPP
 #define DISPLAY_HPP
 
-#include <SDL.h>
-
 #include <array>
+#include <cstdint>
 
 /**
- * Class that represents the 64x32 pixel chip-8 display matrix. 
+ * Class that represents the 64x32 pixel chip-8 display matrix. The display only holds pixel state,
+ * drawing it is left to a VideoOutput supplied by the frontend.
  */
 class Display {
 
@@ -19,29 +19,38 @@ public:
   Display();
 
   /**
-   * Constructor with pointer to renderer to draw to.
+   * Sets the value of sets the value of the pixel at (p_col, p_row) = p_value.
    */
-  Display(SDL_Renderer* p_renderer);
+  void SetPixel(int p_row, int p_col, bool p_value);
 
   /**
-   * Renders the pixels in pixels_ to the sdl renderer being used.
-  */
-  void Render();
+   * Gets and returns the value of the pixel at (p_col, p_row)
+   */
+  bool GetPixel(int p_row, int p_col) const;
 
   /**
-   * Sets the value of sets the value of the pixel at (p_col, p_row) = p_value.
+   * Outputs the current pixels to the console.
    */
-  void SetPixel(int p_row, int p_col, bool p_value);
+  void Print() const;
 
   /**
-   * Gets and returns the value of the pixel at (p_col, p_row)
+   * XORs the p_count sprite rows in p_rows onto the display with their top left corner at 
+   * (p_x, p_y). The starting position wraps around the screen, but the sprite itself is clipped at
+   * the right and bottom edges. Returns true if any pixel that was on got turned off.
    */
-  bool GetPixel(int p_row, int p_col);
+  bool DrawSprite(int p_x, int p_y, const uint8_t* p_rows, int p_count);
 
   /**
-   * Outputs the current pixels to the console.
+   * Returns the pixels of row p_row packed into a word, column 0 in the most significant bit. Rows
+   * outside the display are returned as 0.
+   */
+  uint64_t GetRow(int p_row) const;
+
+  /**
+   * Replaces the pixels of row p_row with p_pixels, packed the same way GetRow returns them. Rows 
+   * outside the display are ignored.
    */
-  void Print();
+  void SetRow(int p_row, uint64_t p_pixels);
 
   /**
    * Sets all of the pixels in the pixel buffer to 0.
@@ -51,17 +60,23 @@ public:
   /**
    * Returns true if no pixels are enabled, false otherwise.
    */
-  bool IsClear();
+  bool IsClear() const;
 
   /**
    * Get the number of pixels the display width has.
    */
-  int get_pixel_width();
+  int get_pixel_width() const;
   
   /**
    * Get the number of pixels the display height has.
    */
-  int get_pixel_height(); 
+  int get_pixel_height() const;
+
+  /**
+   * Returns a counter that changes every time a pixel changes value. Frontends compare it against
+   * the value they last drew to find out if the display needs to be drawn again.
+   */
+  long long get_generation() const;
 private: 
 
   /**
@@ -71,15 +86,15 @@ private:
   const static int PIXEL_HEIGHT = 32;
 
   /**
-   * 2D array containing the pixel data for the display. A value of true means the pixel should be
-   * drawn, otherwise the pixel should not be drawn.
+   * The pixel data for the display, one 64-bit word per row with column 0 in the most significant 
+   * bit. A set bit means the pixel should be drawn, otherwise the pixel should not be drawn.
    */
-  std::array<std::array<bool, PIXEL_WIDTH>, PIXEL_HEIGHT> pixels_;
+  std::array<uint64_t, PIXEL_HEIGHT> rows_;
 
   /**
-   * The renderer used to draw on.
+   * Incremented every time a pixel changes value.
    */
-  SDL_Renderer* renderer_;
+  long long generation_;
 };
 
 #endif
\ No newline at end of file
@@ -1,78 +1,671 @@
 // Trent Julich ~ 27 March 2021
 
 #include "emu.hpp"
-#include "keyboard_input.hpp"
 
+#include <algorithm>
 #include <bitset>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
-Emu::Emu() {
-  InitializeFonts();
-  program_counter_ = PROGRAM_START;
-  set_index_register(0); 
-}
+const int Emu::TIMER_FREQUENCY;
+const int Emu::DEFAULT_CLOCK_SPEED;
+const int Emu::STACK_SIZE;
+const uint32_t Emu::DEFAULT_RANDOM_SEED;
+
+Emu::Emu() : Emu(nullptr) {}
 
-Emu::Emu(SDL_Renderer* p_renderer) {
-  renderer_ = p_renderer;
-  main_display_ = Display(renderer_);
+Emu::Emu(VideoOutput* p_video_output) {
+  video_output_ = p_video_output;
+  execution_engine_ = TABLE_ENGINE;
+  dispatch_table_ = DispatchTable::Get();
   InitializeFonts();
+  program_counter_ = PROGRAM_START;
   set_index_register(0);
   sound_timer_ = 0;
   delay_timer_ = 0;
-  program_counter_ = PROGRAM_START;
+  waiting_for_key_ = false;
+  wait_register_ = 0;
+  stack_size_ = 0;
+  ret_address_stack_.fill(0);
+  random_state_ = DEFAULT_RANDOM_SEED;
+  idle_loop_skipping_ = true;
+  skipped_cycles_ = 0;
+  profiler_ = nullptr;
+  trace_recorder_ = nullptr;
+  debugger_ = nullptr;
 }
 
 void Emu::LoadInstruction(int p_address, std::bitset<16> p_instruction) { 
-  // Grab the leftmost 8 bits of the instruction.
-  std::bitset<8> first_byte(p_instruction.to_string().substr(0, 8));
+  uint16_t instruction = p_instruction.to_ulong();
 
-  // Grab the rightmost 8 bits of the instruction.
-  std::bitset<8> second_byte(p_instruction.to_string().substr(8, 8));
+  // Write the leftmost 8 bits of the instruction followed by the rightmost 8 bits.
+  memory_.WriteByte(p_address, instruction >> 8);
+  memory_.WriteByte(p_address + 1, instruction & 0xFF);
+  MemoryWritten(p_address, 2);
+}
 
-  // Write both bytes back to back in memory.
-  memory_.Write(p_address, first_byte);
-  memory_.Write(p_address + 1, second_byte);
+int Emu::LoadRom(const uint8_t* p_rom, int p_length) {
+  int loaded = memory_.Write(PROGRAM_START, p_rom, p_length);
+  MemoryWritten(PROGRAM_START, loaded);
+  return loaded;
 }
 
-void PrintInstruction(std::bitset<16> p_instruction) {
-  int first_nibble = (p_instruction.to_ulong() & 0xF000) >> 12;
-  int second_nibble = (p_instruction.to_ulong() & 0xF00) >> 8;
-  int third_nibble = (p_instruction.to_ulong() & 0xF0) >> 4;
-  int fourth_nibble = (p_instruction.to_ulong() & 0xF);
+void PrintInstruction(uint16_t p_instruction) {
+  int first_nibble = (p_instruction & 0xF000) >> 12;
+  int second_nibble = (p_instruction & 0xF00) >> 8;
+  int third_nibble = (p_instruction & 0xF0) >> 4;
+  int fourth_nibble = (p_instruction & 0xF);
 
   std::cout << "Instruction: " << std::hex << first_nibble << second_nibble << third_nibble 
     << fourth_nibble << std::endl;
 }
 
 void Emu::Step() {
+#ifdef CHIP8_PROFILE
+  if (profiler_) {
+    ExecuteProfiled(1);
+    return;
+  }
+#endif
+  if (debugger_) {
+    ExecuteDebugged(1);
+    return;
+  }
+  if (trace_recorder_) {
+    ExecuteTraced(1);
+    return;
+  }
+
   // Grab the next instruction.
-  std::bitset<16> current_instruction = Fetch();
+  uint16_t current_instruction = Fetch();
 
   // PrintInstruction(current_instruction);
 
   // Pass the instruction to get decoded.
-  Decode(current_instruction);
+  if (execution_engine_ == SWITCH_ENGINE) {
+    Decode(current_instruction);
+  } else {
+    Dispatch(current_instruction);
+  }
+}
+
+int Emu::ExecuteBatch(int p_count) {
+  if (waiting_for_key_) {
+    return 0;
+  }
+#ifdef CHIP8_PROFILE
+  if (profiler_) {
+    return ExecuteProfiled(p_count);
+  }
+#endif
+  if (debugger_) {
+    return ExecuteDebugged(p_count);
+  }
+  if (trace_recorder_) {
+    return ExecuteTraced(p_count);
+  }
+
+  int executed = 0;
+  switch (execution_engine_) {
+    case SWITCH_ENGINE: {
+      for (; executed < p_count && !waiting_for_key_; executed++) {
+        Decode(Fetch());
+      }
+      break;
+    }
+    case TABLE_ENGINE: {
+      for (; executed < p_count && !waiting_for_key_; executed++) {
+        Dispatch(Fetch());
+      }
+      break;
+    }
+    case THREADED_ENGINE: {
+      executed = ExecuteThreaded(p_count);
+      break;
+    }
+    case BLOCK_ENGINE: {
+      executed = ExecuteBlocks(p_count);
+      break;
+    }
+    case JIT_ENGINE: {
+      executed = ExecuteJit(p_count);
+      break;
+    }
+  }
+  return executed;
+}
+
+int Emu::ExecuteProfiled(int p_count) {
+  int executed = 0;
+  for (; executed < p_count && !waiting_for_key_; executed++) {
+    int address = program_counter_;
+    uint16_t opcode = Fetch();
+    auto start = std::chrono::steady_clock::now();
+    if (execution_engine_ == SWITCH_ENGINE) {
+      Decode(opcode);
+    } else {
+      Dispatch(opcode);
+    }
+    auto end = std::chrono::steady_clock::now();
+    profiler_->Record(address, dispatch_table_[opcode].instruction.type, 
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  }
+  return executed;
+}
+
+int Emu::ExecuteTraced(int p_count) {
+  TraceRecord record;
+  std::memset(&record, 0, sizeof(record));
+  int executed = 0;
+  for (; executed < p_count && !waiting_for_key_; executed++) {
+    record.program_counter = program_counter_;
+    record.opcode = Fetch();
+    const DispatchEntry& entry = dispatch_table_[record.opcode];
+    if (execution_engine_ == SWITCH_ENGINE) {
+      Decode(record.opcode);
+    } else {
+      entry.handler(*this, entry.instruction);
+    }
+
+    int changed = traced_register(entry.instruction);
+    record.index_register = index_register_.Read().to_ulong();
+    record.changed_register = changed;
+    record.changed_value = changed != TraceRecord::NO_REGISTER 
+      ? variable_registers_[changed].Read().to_ulong() : 0;
+    record.flag_register = variable_registers_[0xF].Read().to_ulong();
+    trace_recorder_->Record(record);
+  }
+  return executed;
+}
+
+int Emu::ExecuteDebugged(int p_count) {
+  // Only pay for working out each instruction's memory accesses when something is watched.
+  return debugger_->has_watchpoints() ? RunDebugged<true>(p_count) : RunDebugged<false>(p_count);
+}
+
+template <bool CHECK_ACCESS>
+int Emu::RunDebugged(int p_count) {
+  Debugger& debugger = *debugger_;
+  uint16_t watched = debugger.get_watched_registers();
+  uint8_t registers[16];
+  int executed = 0;
+  while (executed < p_count && !waiting_for_key_) {
+    int address = program_counter_;
+    if (!debugger.BeforeInstruction(address)) {
+      break;
+    }
+    if (CHECK_ACCESS) {
+      MemoryAccess access;
+      if (instruction_memory_access(InstructionAt(address), index_register_.Read().to_ulong(),
+                                    access) && !debugger.BeforeAccess(address, access)) {
+        break;
+      }
+    }
+    for (int i = 0; watched && i < 16; i++) {
+      registers[i] = variable_registers_[i].Read().to_ulong();
+    }
+
+    if (trace_recorder_) {
+      ExecuteTraced(1);
+    } else if (execution_engine_ == SWITCH_ENGINE) {
+      Decode(Fetch());
+    } else {
+      Dispatch(Fetch());
+    }
+    executed++;
+
+    for (int i = 0; watched && i < 16; i++) {
+      if ((watched >> i & 1) && registers[i] != variable_registers_[i].Read().to_ulong()) {
+        debugger.RegisterChanged(address, i);
+        break;
+      }
+    }
+    debugger.AfterInstruction(address);
+  }
+  return executed;
+}
+
+RunSummary Emu::RunCycles(int p_cycles) {
+  long long display_generation = main_display_.get_generation();
+  long long skipped_cycles = skipped_cycles_;
+  int cycles = 0;
+  int executed = 0;
+
+  while (cycles < p_cycles && !DebuggerPaused()) {
+    // Run up to the next timer tick.
+    int budget = std::min(timer_scheduler_.CyclesUntilTick(), p_cycles - cycles);
+
+    // Waiting on Fx0A changes nothing but the timers, so skip straight over the cycles.
+    if (!waiting_for_key_) {
+      int used = CanSkipIdleLoops() ? SkipIdleLoop(budget) : 0;
+      int ran = used + ExecuteBatch(budget - used);
+      executed += ran;
+
+      // Time stops with execution when the debugger stops part way through.
+      if (DebuggerPaused()) {
+        budget = ran;
+      }
+    }
+    cycles += budget;
+
+    for (int ticks = timer_scheduler_.Advance(budget); ticks > 0; ticks--) {
+      DelayTick();
+      SoundTick();
+    }
+  }
+
+  RunSummary summary;
+  summary.instructions = cycles;
+  summary.display_changed = main_display_.get_generation() != display_generation;
+  summary.waiting_for_key = waiting_for_key_;
+  summary.skipped_cycles = skipped_cycles_ - skipped_cycles;
+  summary.executed = executed - summary.skipped_cycles;
+  return summary;
+}
+
+RunSummary Emu::RunFrame(int p_instructions_per_frame) {
+  long long display_generation = main_display_.get_generation();
+  long long skipped_cycles = skipped_cycles_;
+  int executed = 0;
+  int cycles = 0;
+
+  // While the debugger is paused time stands still, so nothing runs and the timers hold.
+  if (!DebuggerPaused()) {
+    cycles = p_instructions_per_frame;
+    if (!waiting_for_key_) {
+      int used = CanSkipIdleLoops() ? SkipIdleLoop(p_instructions_per_frame) : 0;
+      executed = used + ExecuteBatch(p_instructions_per_frame - used);
+    }
+
+    // A frame the debugger stops part way through ends without its timer tick.
+    if (DebuggerPaused()) {
+      cycles = executed;
+      timer_scheduler_.CountCycles(cycles);
+    } else {
+      timer_scheduler_.CountCycles(cycles);
+      DelayTick();
+      SoundTick();
+    }
+  }
+
+  RunSummary summary;
+  summary.instructions = cycles;
+  summary.display_changed = main_display_.get_generation() != display_generation;
+  summary.waiting_for_key = waiting_for_key_;
+  summary.skipped_cycles = skipped_cycles_ - skipped_cycles;
+  summary.executed = executed - summary.skipped_cycles;
+  return summary;
+}
+
+const Instruction& Emu::InstructionAt(int p_address) {
+  uint16_t opcode = (memory_.ReadByte(p_address) << 8) | memory_.ReadByte(p_address + 1);
+  return dispatch_table_[opcode].instruction;
+}
+
+int Emu::IdleLoopLength(int p_head) {
+  const Instruction& first = InstructionAt(p_head);
+
+  // 1NNN jumping to itself.
+  if (first.type == OP_JUMP && first.nnn == p_head) {
+    return 1;
+  }
+
+  // Ex9E or ExA1 skipping over a jump back to the key check.
+  const Instruction& second = InstructionAt(p_head + 2);
+  if ((first.type == OP_SKIP_KEY_PRESSED || first.type == OP_SKIP_KEY_NOT_PRESSED) 
+      && second.type == OP_JUMP && second.nnn == p_head) {
+    return 2;
+  }
+
+  // Fx07 loading the delay timer, 3xNN skipping over a jump back to the Fx07 once it reads NN.
+  const Instruction& third = InstructionAt(p_head + 4);
+  if (first.type == OP_GET_DELAY && second.type == OP_SKIP_EQUAL && second.x == first.x 
+      && third.type == OP_JUMP && third.nnn == p_head) {
+    return 3;
+  }
+  return 0;
+}
+
+bool Emu::FindIdleLoop(int& p_head, int& p_length) {
+  // The program counter can be on any instruction of the loop, so try each possible start.
+  for (int offset = 0; offset < 3; offset++) {
+    int head = program_counter_ - offset * 2;
+    int length = IdleLoopLength(head);
+    if (length > offset) {
+      p_head = head;
+      p_length = length;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Emu::IdleLoopContinues(int p_head, int p_length) {
+  const Instruction& first = InstructionAt(p_head);
+  bool continues = true;
+  if (p_length == 2) {
+    int key = get_register(first.x);
+    bool pressed = key <= 0xF && keyboard_.IsKeyDown(key);
+    bool released = key <= 0xF && !keyboard_.IsKeyDown(key);
+
+    // The jump back is only skipped over when the key check passes.
+    continues = first.type == OP_SKIP_KEY_PRESSED ? !pressed : !released;
+  } else if (p_length == 3) {
+    continues = delay_timer_ != InstructionAt(p_head + 2).nn;
+  }
+  return continues;
+}
+
+bool Emu::DebuggerPaused() const {
+  return debugger_ && debugger_->is_paused();
+}
+
+bool Emu::CanSkipIdleLoops() const {
+#ifdef CHIP8_PROFILE
+  if (profiler_) {
+    return false;
+  }
+#endif
+  return idle_loop_skipping_ && !debugger_ && !trace_recorder_;
+}
+
+int Emu::SkipIdleLoop(int p_budget) {
+  int head = 0;
+  int length = 0;
+  if (!FindIdleLoop(head, length)) {
+    return 0;
+  }
+
+  // Run to the top of the loop and then once round it for real, so the loop has made its one write
+  // (Fx07 loading the delay timer) before anything is skipped.
+  int lead_in = (length - (program_counter_ - head) / 2) % length;
+  if (lead_in + length * 2 > p_budget) {
+    return 0;
+  }
+
+  int used = ExecuteBatch(lead_in);
+  if (program_counter_ != head || !IdleLoopContinues(head, length)) {
+    return used;
+  }
+  used += ExecuteBatch(length);
+  if (program_counter_ != head) {
+    return used;
+  }
+
+  // Until the next timer tick or key event every pass round the loop is identical to the last, so 
+  // the remaining whole passes can be counted without running them.
+  int skipped = (p_budget - used) / length * length;
+  skipped_cycles_ += skipped;
+  return used + skipped;
+}
+
+void Emu::set_idle_loop_skipping(bool p_enabled) {
+  idle_loop_skipping_ = p_enabled;
+}
+
+bool Emu::get_idle_loop_skipping() {
+  return idle_loop_skipping_;
+}
+
+long long Emu::get_skipped_cycles() {
+  return skipped_cycles_;
+}
+
+void Emu::set_random_seed(uint32_t p_seed) {
+  random_state_ = p_seed;
+}
+
+void Emu::SaveState(EmuState& p_state) {
+  p_state.version = EmuState::VERSION;
+  p_state.clock_speed = timer_scheduler_.get_clock_speed();
+  p_state.cycle_count = timer_scheduler_.get_cycle_count();
+  p_state.timer_phase = timer_scheduler_.get_phase();
+  p_state.random_state = random_state_;
+  p_state.program_counter = program_counter_;
+  p_state.index_register = index_register_.Read().to_ulong();
+  std::copy(ret_address_stack_.begin(), ret_address_stack_.end(), p_state.stack);
+
+  std::array<bool, 16> keys = keyboard_.get_keys();
+  p_state.keys = 0;
+  for (int key = 0; key < 16; key++) {
+    p_state.keys |= keys[key] << key;
+  }
+
+  for (int i = 0; i < 16; i++) {
+    p_state.registers[i] = get_register(i);
+  }
+  p_state.stack_size = stack_size_;
+  p_state.delay_timer = delay_timer_;
+  p_state.sound_timer = sound_timer_;
+  p_state.waiting_for_key = waiting_for_key_;
+  p_state.wait_register = wait_register_;
+  std::memset(p_state.reserved, 0, sizeof(p_state.reserved));
+
+  for (int row = 0; row < 32; row++) {
+    p_state.display[row] = main_display_.GetRow(row);
+  }
+  ByteView memory = memory_.View();
+  std::memcpy(p_state.memory, memory.data, sizeof(p_state.memory));
+}
+
+bool Emu::LoadState(const EmuState& p_state) {
+  if (p_state.version != EmuState::VERSION || p_state.clock_speed == 0 
+      || p_state.timer_phase < 0 || p_state.timer_phase >= (int64_t)p_state.clock_speed
+      || p_state.stack_size > STACK_SIZE || p_state.wait_register > 0xF) {
+    return false;
+  }
+
+  timer_scheduler_.set_clock_speed(p_state.clock_speed);
+  timer_scheduler_.set_cycle_count(p_state.cycle_count);
+  timer_scheduler_.set_phase(p_state.timer_phase);
+  random_state_ = p_state.random_state;
+  program_counter_ = p_state.program_counter;
+  set_index_register(p_state.index_register);
+  std::copy(p_state.stack, p_state.stack + STACK_SIZE, ret_address_stack_.begin());
+
+  std::array<bool, 16> keys;
+  for (int key = 0; key < 16; key++) {
+    keys[key] = (p_state.keys >> key) & 1;
+  }
+  keyboard_.set_keys(keys);
+
+  for (int i = 0; i < 16; i++) {
+    set_register(i, p_state.registers[i]);
+  }
+  stack_size_ = p_state.stack_size;
+  delay_timer_ = p_state.delay_timer;
+  sound_timer_ = p_state.sound_timer;
+  waiting_for_key_ = p_state.waiting_for_key != 0;
+  wait_register_ = p_state.wait_register;
+
+  for (int row = 0; row < 32; row++) {
+    main_display_.SetRow(row, p_state.display[row]);
+  }
+
+  // Only the memory that actually differs is written, so blocks translated from the rest of memory
+  // stay in the cache.
+  const uint8_t* current = memory_.View().data;
+  if (std::memcmp(current, p_state.memory, Ram::ADDRESSES) == 0) {
+    return true;
+  }
+  int first = 0;
+  int last = Ram::ADDRESSES;
+  while (first < last && current[first] == p_state.memory[first]) {
+    first++;
+  }
+  while (last > first && current[last - 1] == p_state.memory[last - 1]) {
+    last--;
+  }
+  if (first < last) {
+    memory_.Write(first, p_state.memory + first, last - first);
+    MemoryWritten(first, last - first);
+  }
+  return true;
+}
+
+void Emu::set_clock_speed(int p_hertz) {
+  timer_scheduler_.set_clock_speed(p_hertz);
+}
+
+int Emu::get_clock_speed() {
+  return timer_scheduler_.get_clock_speed();
+}
+
+void Emu::set_timer_mode(TimerScheduler::Mode p_mode) {
+  timer_scheduler_.set_mode(p_mode);
+}
+
+TimerScheduler::Mode Emu::get_timer_mode() {
+  return timer_scheduler_.get_mode();
+}
+
+long long Emu::get_cycle_count() {
+  return timer_scheduler_.get_cycle_count();
+}
+
+bool Emu::is_waiting_for_key() {
+  return waiting_for_key_;
+}
+
+int Emu::ExecuteBlocks(int p_count) {
+  int executed = 0;
+  while (executed < p_count && !waiting_for_key_) {
+    const Block* block = block_cache_.GetBlock(program_counter_, memory_);
+
+    if (block == nullptr) {
+      // The program counter is outside of memory, so there is nothing to translate.
+      Dispatch(Fetch());
+      executed++;
+    } else {
+      executed += RunBlock(*block, p_count - executed);
+    }
+  }
+  return executed;
+}
+
+int Emu::RunBlock(const Block& p_block, int p_budget) {
+  long long generation = block_cache_.get_generation();
+  int size = p_block.entries.size();
+  int executed = 0;
+  for (int i = 0; i < size && executed < p_budget; i++) {
+    const DispatchEntry* entry = p_block.entries[i];
+    program_counter_ += 2;
+    executed++;
+    entry->handler(*this, entry->instruction);
+
+    // Stop if the instruction wrote over a cached block, it may have been this one.
+    if (block_cache_.get_generation() != generation) {
+      break;
+    }
+  }
+  return executed;
+}
+
+int Emu::ExecuteJit(int p_count) {
+  if (!jit_) {
+    jit_.reset(new JitCompiler());
+  }
+
+  int executed = 0;
+  while (executed < p_count && !waiting_for_key_) {
+    Block* block = block_cache_.GetBlock(program_counter_, memory_);
+
+    if (block == nullptr) {
+      Dispatch(Fetch());
+      executed++;
+      continue;
+    }
+
+    if (block->native_code == nullptr && ++block->executions == JitCompiler::HOT_THRESHOLD) {
+      CompileBlock(*block);
+    }
+
+    // Compiled blocks always run to completion, so only use them if they fit in the budget.
+    if (block->native_code != nullptr && block->native_length <= p_count - executed) {
+      reinterpret_cast<NativeBlock>(block->native_code)(this);
+      executed += block->native_length;
+    } else {
+      executed += RunBlock(*block, p_count - executed);
+    }
+  }
+  return executed;
+}
+
+void Emu::CompileBlock(Block& p_block) {
+  // Nothing can ever be compiled here, so leave the block to the interpreter. Flushing would only
+  // reset every block's count and come straight back here.
+  if (!JitCompiler::IsSupported() || !jit_->has_code_buffer()) {
+    return;
+  }
+  if (!jit_->Compile(*this, p_block)) {
+    // Out of room, start over with an empty buffer. Blocks that are still hot get recompiled.
+    block_cache_.ClearNativeCode();
+    jit_->Reset();
+    jit_->Compile(*this, p_block);
+  }
+}
+
+void Emu::set_profiler(Profiler* p_profiler) {
+  profiler_ = p_profiler;
+}
+
+Profiler* Emu::get_profiler() {
+  return profiler_;
+}
+
+void Emu::set_trace_recorder(TraceRecorder* p_recorder) {
+  trace_recorder_ = p_recorder;
+}
+
+TraceRecorder* Emu::get_trace_recorder() {
+  return trace_recorder_;
+}
+
+void Emu::set_debugger(Debugger* p_debugger) {
+  debugger_ = p_debugger;
+}
+
+Debugger* Emu::get_debugger() {
+  return debugger_;
+}
+
+BlockCacheStats Emu::get_block_cache_stats() {
+  return block_cache_.get_stats();
+}
+
+void Emu::MemoryWritten(int p_address, int p_length) {
+  block_cache_.Invalidate(p_address, p_length);
+}
 
-  Render();
+void Emu::set_execution_engine(ExecutionEngine p_engine) {
+  execution_engine_ = p_engine;
+}
+
+Emu::ExecutionEngine Emu::get_execution_engine() {
+  return execution_engine_;
 }
 
 void Emu::Render() {
-  // Draw the display
-  main_display_.Render();
+  // Hand the display to the frontend, if there is one.
+  if (video_output_ != nullptr) {
+    video_output_->Present(main_display_);
+  }
 }
 
 void Emu::PrintMemory(int p_address) {
   std::cout << "Mem[" << std::hex << p_address << "]: ";
 
   // Read the byte from memory
-  std::bitset<8> read_value = memory_.Read(p_address);
+  int read_value = memory_.ReadByte(p_address);
 
   // Split the byte into 4 bit nibbles.
-  std::bitset<4> first_nibble(read_value.to_string().substr(0, 4));
-  std::bitset<4> second_nibble(read_value.to_string().substr(4, 4));
+  int first_nibble = (read_value >> 4) & 0xF;
+  int second_nibble = read_value & 0xF;
 
   // Convert each value to hex and output to console.  
-  std::cout << std::hex << first_nibble.to_ulong() << second_nibble.to_ulong() << std::endl;
+  std::cout << std::hex << first_nibble << second_nibble << std::endl;
 }
 
 void Emu::PrintDisplay() {
@@ -99,6 +692,7 @@ Display& Emu::get_display() {
 
 void Emu::set_program_counter(int p_pc_value) {
   program_counter_ = p_pc_value;
+  waiting_for_key_ = false;
 }
 
 int Emu::get_program_counter() {
@@ -130,11 +724,16 @@ void Emu::set_register(int p_register, int p_new_value) {
 }
 
 int Emu::get_memory(int p_address) {
-  return memory_.Read(p_address).to_ulong();
+  return memory_.ReadByte(p_address);
 }
 
 void Emu::set_memory(int p_address, int p_value) {
-  memory_.Write(p_address, std::bitset<8>(p_value));
+  memory_.WriteByte(p_address, p_value);
+  MemoryWritten(p_address, 1);
+}
+
+ByteView Emu::get_memory_view() {
+  return memory_.View();
 }
 
 void Emu::set_sound_timer(int p_new_timer_value) {
@@ -157,26 +756,16 @@ std::array<Register<8>, 16>* Emu::get_variable_registers() {
   return &variable_registers_;
 }
 
-void Emu::Decode(std::bitset<16> p_instruction) {
-  std::bitset<16> first_mask(0xF000);
-  std::bitset<16> second_mask(0x0F00);
-  std::bitset<16> third_mask(0x00F0);
-  std::bitset<16> fourth_mask(0x000F);
-
-  int first_nibble = ((p_instruction & first_mask) >> 12).to_ulong();
-  int second_nibble = ((p_instruction & second_mask) >> 8).to_ulong();
-  int third_nibble = ((p_instruction & third_mask) >> 4).to_ulong();
-  int fourth_nibble = ((p_instruction & fourth_mask)).to_ulong();
+void Emu::Decode(uint16_t p_instruction) {
+  int first_nibble = (p_instruction & 0xF000) >> 12;
+  int second_nibble = (p_instruction & 0x0F00) >> 8;
+  int third_nibble = (p_instruction & 0x00F0) >> 4;
+  int fourth_nibble = (p_instruction & 0x000F);
 
-  int second_byte = (p_instruction & (third_mask | fourth_mask)).to_ulong();
+  int second_byte = p_instruction & 0x00FF;
 
-  std::bitset<4> first(p_instruction.to_string().substr(0, 4));
-  // Grab second nibble
-  std::bitset<4> second(p_instruction.to_string().substr(4, 4));
-  // Grab third nibble
-  std::bitset<4> third(p_instruction.to_string().substr(8, 4));
-  // Grab far right nibble
-  std::bitset<4> fourth(p_instruction.to_string().substr(12, 4));
+  // Lower 12 bits, used by instructions that take an address.
+  int address = p_instruction & 0x0FFF;
 
   switch(first_nibble) {
     case 0x0: {
@@ -196,13 +785,11 @@ void Emu::Decode(std::bitset<16> p_instruction) {
       break;
     }
     case 0x1: {
-      int new_program_counter = (p_instruction & std::bitset<16>(0x0FFF)).to_ullong();
-      Jump(new_program_counter);
+      Jump(address);
       break;
     }
     case 0x2: {
-      int routine_address = (p_instruction & (second_mask | third_mask | fourth_mask)).to_ulong();
-      ExecuteSubroutine(routine_address);
+      ExecuteSubroutine(address);
       break;
     }
     case 0x3: {
@@ -217,8 +804,7 @@ void Emu::Decode(std::bitset<16> p_instruction) {
       if (fourth_nibble == 0) {
         SkipIfRegistersEqual(second_nibble, third_nibble);
       } else {
-        std::cout << "-> Unknown instruction 0x" << std::hex << p_instruction.to_ulong() 
-          << std::endl;
+        std::cout << "-> Unknown instruction 0x" << std::hex << p_instruction << std::endl;
       }      
       break;
     }
@@ -238,19 +824,17 @@ void Emu::Decode(std::bitset<16> p_instruction) {
       if (fourth_nibble == 0) {
         SkipIfRegistersNotEqual(second_nibble, third_nibble);
       } else {
-        std::cout << "-> UNKNOWN INSTRUCTION: 0x" << std::hex << p_instruction.to_ulong() 
-          << std::endl;
+        std::cout << "-> UNKNOWN INSTRUCTION: 0x" << std::hex << p_instruction << std::endl;
       }
       
       break;
     }
     case 0xA: {
-      set_index_register((p_instruction & (second_mask | third_mask | fourth_mask)).to_ulong());
+      set_index_register(address);
       break;
     }
     case 0xB: {
-      int value = (p_instruction & (second_mask | third_mask | fourth_mask)).to_ulong();
-      Jump(get_register(0) + value);
+      Jump(get_register(0) + address);
       break;
     }
     case 0xC: {
@@ -264,23 +848,21 @@ void Emu::Decode(std::bitset<16> p_instruction) {
       break;
     }
     case 0xE: {
-      std::bitset<8> rest_of_instruction(second_byte);
-      DecodeKeyInstructions(second_nibble, rest_of_instruction);
+      DecodeKeyInstructions(second_nibble, second_byte);
       break;
     }
     case 0xF: {
-      std::bitset<8> last_bytes(second_byte);
-      DecodeRegisterOps(second_nibble, last_bytes);
+      DecodeRegisterOps(second_nibble, second_byte);
       break;
     }
     default: {
-      std::cout << "-> Instruction unknown: " << p_instruction.to_string() << std::endl;
+      std::cout << "-> Instruction unknown: 0x" << std::hex << p_instruction << std::endl;
     }
   }
 }
 
-void Emu::DecodeKeyInstructions(int p_register_num, std::bitset<8> p_rest_of_instruction) {
-  switch(p_rest_of_instruction.to_ulong()) {
+void Emu::DecodeKeyInstructions(int p_register_num, int p_rest_of_instruction) {
+  switch(p_rest_of_instruction) {
     case 0x9E:
       SkipIfKeyPressed(p_register_num);
       break;
@@ -289,53 +871,42 @@ void Emu::DecodeKeyInstructions(int p_register_num, std::bitset<8> p_rest_of_ins
       break;
     default:
       std::cout << "-> Instruction unknown E" << std::hex << p_register_num  
-        << p_rest_of_instruction.to_ulong() << std::endl;
+        << p_rest_of_instruction << std::endl;
   }
 }
 
-void Emu::HandleUserEvent(SDL_Event e) {
-  switch (e.user.code) {
-    case DELAY_TICK: {
-      if (delay_timer_ > 0) {
-        delay_timer_--;
-      }
-      break;
-    }
-    case SOUND_TICK: {
-      if (sound_timer_ > 0) {
-        sound_timer_--;
-      }
-      break;
-    }
-    case STEP_TICK: {
-      Step();
-      break;
-    }
-    default:
-      std::cout << "Unknown event: " << e.user.code << std::endl;
-  }
-}
+void Emu::KeyDown(int p_key) {
+  keyboard_.HandleKeyDown(p_key); 
 
-void Emu::KeyDown(SDL_Scancode p_code) {
-  keyboard_.HandleKeyDown(p_code); 
+  // Complete a pending Fx0A with the key and move past it.
+  if (waiting_for_key_ && keyboard_.IsValidKey(p_key)) {
+    set_register(wait_register_, p_key);
+    program_counter_ += 2;
+    waiting_for_key_ = false;
+  }
 }
 
-void Emu::KeyUp(SDL_Scancode p_code) {
-  keyboard_.HandleKeyUp(p_code);
+void Emu::KeyUp(int p_key) {
+  keyboard_.HandleKeyUp(p_key);
 }
 
-std::bitset<16> Emu::Fetch() {
+uint16_t Emu::Fetch() {
   // Grab leftmost byte of instruction
-  std::bitset<8> first_byte = memory_.Read(program_counter_);
+  uint16_t first_byte = memory_.ReadByte(program_counter_);
 
   // Grab rightmost byte of instruction.
-  std::bitset<8> second_byte = memory_.Read(program_counter_ + 1);
+  uint16_t second_byte = memory_.ReadByte(program_counter_ + 1);
 
   // Increment the program counter to point at start of next instruction.
   program_counter_ += 2;
 
-  // Return bitstring concatenating both bytes together.
-  return std::bitset<16>(first_byte.to_string() + second_byte.to_string());
+  // Return both bytes concatenated together, leftmost byte in the high bits.
+  return (first_byte << 8) | second_byte;
+}
+
+void Emu::Dispatch(uint16_t p_instruction) {
+  const DispatchEntry& entry = dispatch_table_[p_instruction];
+  entry.handler(*this, entry.instruction);
 }
 
 void Emu::ClearScreen() {
@@ -401,9 +972,9 @@ void Emu::SkipIfKeyNotPressed(int p_register) {
 
 void Emu::ExecuteSubroutine(int p_address) {
   // Ensure that the address is even, so its aligned with instruction boundaries.
-  if (p_address % 2 == 0) {
+  if (p_address % 2 == 0 && stack_size_ < STACK_SIZE) {
     // Store current program counter on stack.
-    ret_address_stack_.emplace_back(std::bitset<16>(program_counter_));
+    ret_address_stack_[stack_size_++] = program_counter_;
 
     // Set program counter to new address. 
     program_counter_ = p_address;
@@ -411,47 +982,30 @@ void Emu::ExecuteSubroutine(int p_address) {
 }
 
 void Emu::ReturnFromSubroutine() {
-  if (ret_address_stack_.size() != 0) {
-    program_counter_ = ret_address_stack_.back().to_ulong();
-    ret_address_stack_.pop_back();
+  if (stack_size_ != 0) {
+    program_counter_ = ret_address_stack_[--stack_size_];
   }
 }
 
 void Emu::DisplaySprite(int p_rows, int p_x_coord, int p_y_coord) {
-  // Wrap around if coordinates would place sprite off screen.
-  p_x_coord = p_x_coord % 64;
-  p_y_coord = p_y_coord % 32;
-
-  variable_registers_[0xF].Write(0);
-
-  for (int i = 0; i < p_rows; i++) { 
-    // Grab the current byte of the sprite from address stored in index register + i
-    std::bitset<8> sprite = memory_.Read(index_register_.Read().to_ulong() + i);
-    for (int j = 7; j > -1; j--) { // Iterate over each bit in the byte left to right.
-      // Check if a pixel would be drawn on an existing pixel
-      if (main_display_.GetPixel(p_y_coord + i, p_x_coord + (7-j)) && sprite[j]) {
-        // Write 1 to the flag register.
-        main_display_.SetPixel(p_y_coord + i, p_x_coord + (7-j), 0);
-        variable_registers_[0xF].Write(1); 
-      }
-      // If there wasn't a collision, check if the pixel should be drawn. 
-      else if (sprite[j]) {
-        main_display_.SetPixel(p_y_coord + i, p_x_coord + (7-j), 1);
-      } 
-      // Stop drawing row if it would go off right edge of screen.
-      if (p_x_coord + (7-j) >= main_display_.get_pixel_width()) {
-        break;
-      }
-    }
-    // Stop drawing entire sprite if the bottom of the sprite goes off screen.
-    if (p_y_coord + i >= main_display_.get_pixel_height()) {
-      break;
-    }
+  // The sprite bytes start at the address stored in the index register. They are read straight 
+  // out of memory, unless the sprite runs off the end of memory and has to be padded with zeros.
+  int address = index_register_.Read().to_ulong();
+  ByteView memory = memory_.View();
+  const uint8_t* sprite = memory.data + address;
+  uint8_t padded_sprite[16];
+  if (address + p_rows > memory.size) {
+    memory_.Read(address, padded_sprite, p_rows);
+    sprite = padded_sprite;
   }
+
+  // The display wraps the starting position and clips the sprite at the edges of the screen.
+  bool collision = main_display_.DrawSprite(p_x_coord, p_y_coord, sprite, p_rows);
+  variable_registers_[0xF].Write(collision ? 1 : 0);
 }
 
 void Emu::InitializeFonts() {
-  std::vector<int> font_bytes{
+  const uint8_t font_bytes[] = {
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
     0x20, 0x60, 0x20, 0x20, 0x70, // 1
     0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -469,36 +1023,25 @@ void Emu::InitializeFonts() {
     0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F  
   };
-  for (int i = 0; i < font_bytes.size(); i++) {
-    std::bitset<8> current_byte(font_bytes[i]);
-    memory_.Write(0x50 + i, current_byte);
-  }
+  memory_.Write(0x50, font_bytes, sizeof(font_bytes));
 }
 
 void Emu::GenerateRandom(int p_register, int p_mask) {
-  int start_value = rand() % 0x100;
+  // Linear congruential generator, the high bits of the state are the most random ones.
+  random_state_ = random_state_ * 1664525u + 1013904223u;
+  int start_value = random_state_ >> 24;
   start_value &= p_mask;
   set_register(p_register, start_value);
 }
 
 void Emu::DelayTick() {
-  SDL_Event event;
-  event.user.code = DELAY_TICK;
-  event.type = SDL_USEREVENT;
-  SDL_PushEvent(&event);
+  if (delay_timer_ > 0) {
+    delay_timer_--;
+  }
 }
 
 void Emu::SoundTick() {
-  SDL_Event event;
-  event.user.code = SOUND_TICK;
-  event.type = SDL_USEREVENT;
-  SDL_PushEvent(&event);
-}
-
-void Emu::StepTick() {
-  SDL_Event event;
-  event.user.code = STEP_TICK;
-  event.type = SDL_USEREVENT;
-  SDL_PushEvent(&event);
+  if (sound_timer_ > 0) {
+    sound_timer_--;
+  }
 }
-
@@ -3,37 +3,113 @@
 #ifndef EMU_HPP
 #define EMU_HPP
 
+#include "block_cache.hpp"
+#include "debugger.hpp"
+#include "dispatch_table.hpp"
 #include "display.hpp"
+#include "frontend.hpp"
+#include "jit_x64.hpp"
 #include "keyboard_input.hpp"
+#include "profiler.hpp"
 #include "ram.hpp"
 #include "register.hpp"
+#include "save_state.hpp"
+#include "timer_scheduler.hpp"
+#include "trace_recorder.hpp"
 
 #include <array>
 #include <bitset>
-#include <vector>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Summary of a RunCycles or RunFrame call.
+ */
+struct RunSummary {
+  /**
+   * Number of instruction cycles that were run, including cycles spent waiting on Fx0A.
+   */
+  int instructions;
+
+  /**
+   * True if any pixel of the display changed.
+   */
+  bool display_changed;
+
+  /**
+   * True if the emulator ended up waiting for a key press on Fx0A.
+   */
+  bool waiting_for_key;
+
+  /**
+   * Number of the instruction cycles that were skipped over instead of executed because the 
+   * program sat in an idle loop.
+   */
+  int skipped_cycles;
+
+  /**
+   * Number of instructions that were actually executed, leaving out the cycles spent waiting on 
+   * Fx0A and the skipped cycles.
+   */
+  int executed;
+};
 
 /**
  * Main emulator class. Contains all the emulated harware components (ram, display, registers), as 
- * well as methods to load and execute programs.
+ * well as methods to load and execute programs. The emulator has no dependency on SDL, frontends
+ * plug in through the VideoOutput interface, report keys with KeyDown and KeyUp, and drive 
+ * execution and the timers with RunFrame or RunCycles.
  */
 class Emu {
 
 public: 
 
+  /**
+   * The strategies that can be used to decode and execute instructions.
+   */
+  enum ExecutionEngine {
+    SWITCH_ENGINE,   // Masks each opcode and walks the nested switch statements in Decode.
+    TABLE_ENGINE,    // Looks each opcode up in the shared, predecoded DispatchTable.
+    THREADED_ENGINE, // Direct-threaded loop over the DispatchTable, used by ExecuteBatch.
+    BLOCK_ENGINE,    // Runs cached, predecoded basic blocks, used by ExecuteBatch.
+    JIT_ENGINE,      // Compiles hot blocks to native x86-64 code, used by ExecuteBatch.
+  };
+
   /**
    * The address that programs should start at.
    */
   const int PROGRAM_START = 0x200;
 
   /**
-   * Default constructor.
+   * Rate in hertz the delay and sound timers count down at.
+   */
+  const static int TIMER_FREQUENCY = TimerScheduler::TIMER_FREQUENCY;
+
+  /**
+   * Default number of instructions executed per second by RunCycles.
+   */
+  const static int DEFAULT_CLOCK_SPEED = TimerScheduler::DEFAULT_CLOCK_SPEED;
+
+  /**
+   * Number of return addresses the call stack holds.
+   */
+  const static int STACK_SIZE = EmuState::STACK_SIZE;
+
+  /**
+   * Seed the random number generator starts from.
+   */
+  const static uint32_t DEFAULT_RANDOM_SEED = 1;
+
+  /**
+   * Default constructor, for an emulator running headless.
    */
   Emu();
 
   /**
-   * Constructor that takes SDL_Renderer pointer that the emulator display should be rendered to.
+   * Constructor that takes the video output the emulator display should be rendered to. The output
+   * may be nullptr and is not owned by the emulator.
    */
-  Emu(SDL_Renderer* p_renderer);
+  Emu(VideoOutput* p_video_output);
 
   /**
    * Load the 16 bit instruction into memory starting at p_address. The left byte is stored in 
@@ -41,13 +117,173 @@ public:
    */
   void LoadInstruction(int p_address, std::bitset<16> p_instruction);
 
+  /**
+   * Copies the p_length byte rom image p_rom into memory starting at PROGRAM_START in a single 
+   * bulk write. Returns the number of bytes that fit into memory.
+   */
+  int LoadRom(const uint8_t* p_rom, int p_length);
+
   /**
    *  Fetches, decodes, and executes the next instruction pointed to by the program counter.
    */
   void Step();  
 
   /**
-   * Called to render the current display state to the renderer being used.
+   * Selects the engine Step uses to decode and execute instructions. Defaults to TABLE_ENGINE.
+   */
+  void set_execution_engine(ExecutionEngine p_engine);
+
+  /**
+   * Returns the engine currently used to decode and execute instructions.
+   */
+  ExecutionEngine get_execution_engine();
+
+  /**
+   * Fetches, decodes and executes up to p_count instructions back to back without rendering in 
+   * between. The batch ends early once Fx0A starts waiting for a key, and nothing is executed while
+   * waiting. Returns the number of instructions executed.
+   */
+  int ExecuteBatch(int p_count);
+
+  /**
+   * Runs p_cycles instruction cycles in a tight loop, ticking the delay and sound timers whenever 
+   * the timer scheduler says a tick is due. With the default virtual clock that is every time the 
+   * cycles run add up to 1/60th of a second at the current clock speed, and leftover cycles carry 
+   * over to the next call. While waiting on Fx0A for a key no instructions are executed, but the 
+   * cycles still count towards the timers. Idle loops are fast-forwarded to the next timer tick, see
+   * set_idle_loop_skipping. While an attached debugger is paused time stands still: the run ends
+   * once it stops, counting only the cycles executed, and nothing runs while it stays paused.
+   */
+  RunSummary RunCycles(int p_cycles);
+
+  /**
+   * Runs one 60hz frame: p_instructions_per_frame instruction cycles followed by a single tick of 
+   * the delay and sound timers. The caller paces the frames, so the timer scheduler only counts 
+   * the cycles. Like RunCycles nothing runs while an attached debugger is paused, and a frame it
+   * stops part way through ends after the cycles executed, without the timer tick.
+   */
+  RunSummary RunFrame(int p_instructions_per_frame);
+
+  /**
+   * Sets the number of instructions per second RunCycles emulates, used to decide when the timers
+   * tick. Values below 1 are ignored.
+   */
+  void set_clock_speed(int p_hertz);
+
+  /**
+   * Returns the number of instructions per second RunCycles emulates.
+   */
+  int get_clock_speed();
+
+  /**
+   * Selects whether RunCycles derives timer ticks from the instruction count (the default, fully
+   * reproducible) or from the host's wall clock (for interactive play).
+   */
+  void set_timer_mode(TimerScheduler::Mode p_mode);
+
+  /**
+   * Returns where RunCycles takes timer ticks from.
+   */
+  TimerScheduler::Mode get_timer_mode();
+
+  /**
+   * Returns the total number of instruction cycles run by RunCycles and RunFrame.
+   */
+  long long get_cycle_count();
+
+  /**
+   * Returns true while execution is suspended on Fx0A, waiting for KeyDown to deliver a key. 
+   * RunCycles and RunFrame only advance the timers in this state, so a frontend can sleep until 
+   * input arrives once the timers have run out.
+   */
+  bool is_waiting_for_key();
+
+  /**
+   * Selects whether RunCycles and RunFrame fast-forward through idle loops. A busy-wait on the 
+   * delay timer (Fx07, 3xNN, 1NNN back to the Fx07), a spin on a key (Ex9E or ExA1 followed by a 
+   * jump back to it) and a jump to self cannot change anything until the next timer tick or key 
+   * event, so the cycles they would spend looping are counted without executing them. The result
+   * is exactly the same as executing them. Enabled by default. Skipping is suspended while a 
+   * debugger, a trace recorder or, in profiling builds, a profiler is attached, since they have to
+   * see every instruction.
+   */
+  void set_idle_loop_skipping(bool p_enabled);
+
+  /**
+   * Returns true if RunCycles and RunFrame fast-forward through idle loops.
+   */
+  bool get_idle_loop_skipping();
+
+  /**
+   * Returns the total number of instruction cycles fast-forwarded over in idle loops.
+   */
+  long long get_skipped_cycles();
+
+  /**
+   * Restarts the random number generator used by Cxkk from p_seed. Every emulator has a generator
+   * of its own, so emulators with the same seed and input produce the same random numbers no 
+   * matter how many other emulators are running.
+   */
+  void set_random_seed(uint32_t p_seed);
+
+  /**
+   * Copies the complete machine state (memory, registers, stack, timers, keys, display and the
+   * timer scheduler's progress) into p_state. Cheap enough to call every frame.
+   */
+  void SaveState(EmuState& p_state);
+
+  /**
+   * Puts the emulator back into the state saved in p_state. Returns false and changes nothing if 
+   * p_state was saved with a different layout version or holds values no emulator could be in.
+   */
+  bool LoadState(const EmuState& p_state);
+
+  /**
+   * Returns the hit, miss and invalidation counters of the block cache used by BLOCK_ENGINE.
+   */
+  BlockCacheStats get_block_cache_stats();
+
+  /**
+   * Attaches p_profiler, or detaches the current one when null. While attached, cores built with 
+   * CHIP8_PROFILE run every engine one instruction at a time, timing each handler into the 
+   * profiler, since the threaded, block and jit engines can not be split into single instructions.
+   * Without CHIP8_PROFILE the profiler is never touched.
+   */
+  void set_profiler(Profiler* p_profiler);
+
+  /**
+   * Returns the attached profiler, or null if there is none.
+   */
+  Profiler* get_profiler();
+
+  /**
+   * Attaches p_recorder, or detaches the current one when null. While attached, every engine runs
+   * one instruction at a time and each executed instruction is added to the recorder's trace. Idle
+   * loops are executed rather than skipped, so the trace holds every cycle that ran.
+   */
+  void set_trace_recorder(TraceRecorder* p_recorder);
+
+  /**
+   * Returns the attached trace recorder, or null if there is none.
+   */
+  TraceRecorder* get_trace_recorder();
+
+  /**
+   * Attaches p_debugger, or detaches the current one when null. While attached, every engine runs
+   * one instruction at a time through a loop that checks the debugger's breakpoints, watchpoints 
+   * and register triggers, and idle loops are not skipped. Once the debugger stops, nothing is 
+   * executed until it is resumed, RunFrame and RunCycles then only advance the timers. Without a 
+   * debugger none of the checks are made.
+   */
+  void set_debugger(Debugger* p_debugger);
+
+  /**
+   * Returns the attached debugger, or null if there is none.
+   */
+  Debugger* get_debugger();
+
+  /**
+   * Called to render the current display state to the video output being used, if there is one.
    */
   void Render();
 
@@ -72,7 +308,8 @@ public:
   Display& get_display();
 
   /**
-   * Set the address pointed to by the program counter to p_pc_value.
+   * Set the address pointed to by the program counter to p_pc_value. Abandons any pending Fx0A 
+   * key wait.
    */
   void set_program_counter(int p_pc_value);
 
@@ -117,6 +354,11 @@ public:
    */
   void set_memory(int p_address, int p_value);
 
+  /**
+   * Returns a read-only, zero-copy view of the whole of memory.
+   */
+  ByteView get_memory_view();
+
   /**
    * Updates sound timer to new timer value.
    */ 
@@ -143,50 +385,37 @@ public:
   std::array<Register<8>, 16>* get_variable_registers();
 
   /**
-   * Function that on emulator start, is called 60 times a second to decrement delay counter.
+   * Decrements the delay timer if it is not already 0. Should be called 60 times a second.
    */
   void DelayTick();
 
   /**
-   * Function that on emulator start, is called 60 times a second to decrement sound counter.
+   * Decrements the sound timer if it is not already 0. Should be called 60 times a second.
    */
   void SoundTick();
 
   /**
-   * Function that on emulator start, is called at 500hz to cycle the emulator.
-   */
-  void StepTick();
-
-  /**
-   * Helper method used to handle user defined events.
-   */
-  void HandleUserEvent(SDL_Event p_e);
-
-  /**
-   * Method called when a key press occurs.
+   * Method called when keypad key p_key (0x0 -> 0xF) is pressed. If the emulator is waiting on 
+   * Fx0A, the key is stored in its register and execution resumes after it.
    */ 
-  void KeyDown(SDL_Scancode p_code);
+  void KeyDown(int p_key);
 
   /**
-   * Method called when a key is released.
+   * Method called when keypad key p_key (0x0 -> 0xF) is released.
    */
-  void KeyUp(SDL_Scancode p_code);
+  void KeyUp(int p_key);
 
 private:
 
   /**
-   * Enum used when 60hz timer events are added to the event queue.
+   * The dispatch table handlers call straight into the private instruction methods below.
    */
-  enum CustomEvents {
-    DELAY_TICK, 
-    SOUND_TICK,
-    STEP_TICK, 
-  };
+  friend class DispatchTable;
 
   /**
-   * Event handler used to handle input and timer events.
+   * Compiled code reads and writes the registers and program counter in place.
    */
-  SDL_Event event_handler_;
+  friend class JitCompiler;
 
   /**
    * Object used to handle keyboard inputs.
@@ -204,9 +433,9 @@ private:
   Display main_display_;
 
   /**
-   * The renderer that the emulator is rendering to.
+   * The video output that the emulator is rendering to, or nullptr when running headless.
    */
-  SDL_Renderer* renderer_;
+  VideoOutput* video_output_;
 
   /**
    * 4kB of simulated memory, with 4096 addressable 8-bit locations.
@@ -228,43 +457,221 @@ private:
    */
   int sound_timer_;
 
+  /**
+   * Decides when RunCycles ticks the delay and sound timers.
+   */
+  TimerScheduler timer_scheduler_;
+
+  /**
+   * Set while execution is suspended on Fx0A, cleared once KeyDown delivers a key.
+   */
+  bool waiting_for_key_;
+
+  /**
+   * The register the pending Fx0A stores the key in.
+   */
+  int wait_register_;
+
+  /**
+   * True if RunCycles and RunFrame fast-forward through idle loops.
+   */
+  bool idle_loop_skipping_;
+
+  /**
+   * Total number of instruction cycles fast-forwarded over in idle loops.
+   */
+  long long skipped_cycles_;
+
   /**
    * 16-Bit index register.
    */
   Register<16> index_register_;
 
   /**
-   * Vector serving as a stack to store 16 bit return addresses.
+   * Fixed size stack of 16 bit return addresses, the top is at ret_address_stack_[stack_size_ - 1].
+   */
+  std::array<uint16_t, STACK_SIZE> ret_address_stack_;
+
+  /**
+   * Number of return addresses on the stack.
+   */
+  int stack_size_;
+
+  /**
+   * State of the random number generator used by Cxkk.
+   */
+  uint32_t random_state_;
+
+  /**
+   * The engine used by Step to decode and execute instructions.
+   */
+  ExecutionEngine execution_engine_;
+
+  /**
+   * First entry of the shared dispatch table, cached so that dispatching is a single indexed load.
+   */
+  const DispatchEntry* dispatch_table_;
+
+  /**
+   * Translated basic blocks run by BLOCK_ENGINE.
+   */
+  BlockCache block_cache_;
+
+  /**
+   * Compiler used by JIT_ENGINE, created the first time it is needed.
+   */
+  std::unique_ptr<JitCompiler> jit_;
+
+  /**
+   * Profiler timing each instruction, null unless one is attached.
+   */
+  Profiler* profiler_;
+
+  /**
+   * Runs p_count instructions one at a time, recording each into the attached profiler. Returns 
+   * the number of instructions executed.
    */
-  std::vector<std::bitset<16>> ret_address_stack_;
+  int ExecuteProfiled(int p_count);
+
+  /**
+   * Trace recorder every executed instruction is added to, null unless one is attached.
+   */
+  TraceRecorder* trace_recorder_;
+
+  /**
+   * Runs p_count instructions one at a time, adding each to the attached trace recorder. Returns 
+   * the number of instructions executed.
+   */
+  int ExecuteTraced(int p_count);
+
+  /**
+   * Debugger checked before and after every instruction, null unless one is attached.
+   */
+  Debugger* debugger_;
+
+  /**
+   * Runs up to p_count instructions one at a time under the attached debugger, stopping early when
+   * it stops execution. Returns the number of instructions executed.
+   */
+  int ExecuteDebugged(int p_count);
+
+  /**
+   * The loop behind ExecuteDebugged, with the memory accesses of every instruction checked against
+   * the watchpoints only when CHECK_ACCESS is true.
+   */
+  template <bool CHECK_ACCESS>
+  int RunDebugged(int p_count);
 
   /**
    * Method used to grab and return the instruction pointed to by program counter. The program 
    * counter is then incremented to point to start of next instruction.
    */
-  std::bitset<16> Fetch();
+  uint16_t Fetch();
 
   /**
    * Decodes the instruction to determine what instruction and data values to use during execution. 
    * The data values are then passed to the corresponding instruction handler.
    */
-  void Decode(std::bitset<16> p_instruction);
+  void Decode(uint16_t p_instruction);
   
   /**
    * Helper method to decode instructions that only relate to a single register.
    */
-  void DecodeRegisterOps(int p_register_number, std::bitset<8> p_instruction);
+  void DecodeRegisterOps(int p_register_number, int p_instruction);
 
   /**
    * Helper method that decodes instructions that relate to arithmetic operations between registers.
    */
-  void DecodeRegisterArithmetic(std::bitset<16> p_instruction);
+  void DecodeRegisterArithmetic(uint16_t p_instruction);
 
   /**
    * Decodes the rest of instructions the correspond to instructions which handle checking key 
    * states.
    */
-  void DecodeKeyInstructions(int p_register_num, std::bitset<8> p_rest_of_instruction);
+  void DecodeKeyInstructions(int p_register_num, int p_rest_of_instruction);
+
+  /**
+   * Executes p_instruction by looking it up in the predecoded dispatch table.
+   */
+  void Dispatch(uint16_t p_instruction);
+
+  /**
+   * Executes p_count instructions with a direct-threaded loop, jumping straight from the end of 
+   * one instruction body to the start of the next. Falls back to a switch based loop when the 
+   * compiler does not support computed goto. Returns the number of instructions executed.
+   */
+  int ExecuteThreaded(int p_count);
+
+  /**
+   * Executes p_count instructions by running whole translated blocks out of the block cache. 
+   * Returns the number of instructions executed.
+   */
+  int ExecuteBlocks(int p_count);
+
+  /**
+   * Executes p_count instructions like ExecuteBlocks, but compiles blocks to native code once they
+   * have run JitCompiler::HOT_THRESHOLD times. Returns the number of instructions executed.
+   */
+  int ExecuteJit(int p_count);
+
+  /**
+   * Interprets the instructions of p_block, stopping early after p_budget instructions or when an
+   * instruction invalidates a cached block. Returns the number of instructions executed.
+   */
+  int RunBlock(const Block& p_block, int p_budget);
+
+  /**
+   * Compiles p_block, throwing away all previously compiled code if the code buffer is full. Does
+   * nothing when the JIT can not generate code on this host, so the block stays interpreted.
+   */
+  void CompileBlock(Block& p_block);
+
+  /**
+   * Returns the predecoded instruction stored at p_address.
+   */
+  const Instruction& InstructionAt(int p_address);
+
+  /**
+   * Returns the length in instructions of the idle loop whose first instruction is at p_head, or 0
+   * if the code at p_head does not have the shape of an idle loop.
+   */
+  int IdleLoopLength(int p_head);
+
+  /**
+   * Looks for an idle loop that the program counter is inside of. Stores the address of its first
+   * instruction in p_head and its length in p_length, returning false if there is none.
+   */
+  bool FindIdleLoop(int& p_head, int& p_length);
+
+  /**
+   * Returns true if the idle loop of p_length instructions at p_head goes round again when entered
+   * with the current timers and key states.
+   */
+  bool IdleLoopContinues(int p_head, int p_length);
+
+  /**
+   * Fast-forwards through the idle loop the program counter is in, if any, using up to p_budget 
+   * cycles. Whole passes through the loop are skipped, the program counter is left on the first 
+   * instruction of the loop. Returns the number of cycles used, executed and skipped together.
+   */
+  int SkipIdleLoop(int p_budget);
+
+  /**
+   * Returns true if RunCycles and RunFrame may fast-forward idle loops: skipping is enabled and no 
+   * attached hook has to see every instruction that runs.
+   */
+  bool CanSkipIdleLoops() const;
+
+  /**
+   * Returns true if a debugger is attached and has stopped execution.
+   */
+  bool DebuggerPaused() const;
+
+  /**
+   * Must be called after any write to memory, so cached blocks translated from the p_length bytes 
+   * starting at p_address are thrown away.
+   */
+  void MemoryWritten(int p_address, int p_length);
 
   /**
    * Used to reset the main display to all blank pixels.
@@ -282,6 +689,56 @@ private:
    */
   void AddValToRegister(int p_register, int p_val);
 
+  /**
+   * Stores the value of variable register p_y_register in variable register p_x_register.
+   */
+  void CopyRegister(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the bitwise OR of the values in p_x_register and p_y_register in p_x_register.
+   */
+  void OrRegisters(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the bitwise AND of the values in p_x_register and p_y_register in p_x_register.
+   */
+  void AndRegisters(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the bitwise XOR of the values in p_x_register and p_y_register in p_x_register.
+   */
+  void XorRegisters(int p_x_register, int p_y_register);
+
+  /**
+   * Adds the value in p_y_register to p_x_register. VF is set to 1 if the addition carried and 0 
+   * otherwise.
+   */
+  void AddRegisters(int p_x_register, int p_y_register);
+
+  /**
+   * Subtracts the value in p_y_register from p_x_register. VF is set to 0 if the subtraction 
+   * borrowed and 1 otherwise.
+   */
+  void SubtractRegisters(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the value in p_y_register shifted right by one in p_x_register. VF is set to the bit 
+   * that was shifted out.
+   */
+  void ShiftRight(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the value in p_y_register minus the value in p_x_register in p_x_register. VF is set to
+   * 0 if the subtraction borrowed and 1 otherwise.
+   */
+  void SubtractRegistersReverse(int p_x_register, int p_y_register);
+
+  /**
+   * Stores the value in p_y_register shifted left by one in p_x_register. VF is set to the least 
+   * significant bit of the value in p_y_register.
+   */
+  void ShiftLeft(int p_x_register, int p_y_register);
+
   /**
    * Stores register V0 -> Vp_register_number in memory starting at the address stored in the index
    * register.
@@ -341,14 +798,16 @@ private:
   void SkipIfKeyNotPressed(int p_register);
 
   /**
-   * Wait for a key to be pressed, and store that value in register p_register.
+   * Wait for a key to be pressed, and store that value in register p_register. Does not block, it
+   * puts the emulator into the waiting for key state and leaves the program counter on the 
+   * instruction, so running it again just keeps waiting. KeyDown completes the instruction.
    */
   void WaitForKeyPress(int p_register);
   
   /**
    * Stores the current address on the stack, and jumps to subroutine located at p_address. 
    * p_address must be an even integer, so that program counter can stay aligned with instruction 
-   * boundaries.
+   * boundaries. If the stack is already full the instruction is skipped.
    */
   void ExecuteSubroutine(int p_address);
 
@@ -379,27 +838,10 @@ private:
   void InitializeFonts();
 
   /**
-   * Generates a random number, AND masks it with p_mask, and stores in register p_register.
-   */
-  void GenerateRandom(int p_register, int p_mask);  
-
-  /**
-   * When an emulator is started, it uses this callback and SDL_AddTimer to register to have 
-   * DelayTick() method called every p_interval m.s.
-   */
-  static Uint32 delay_timer_callback(Uint32 p_interval, void* p_param);
-
-  /**
-   * When an emulator is started, it uses this callback and SDL_AddTimer to register to have 
-   * SoundTick() method called every p_interval m.s.
-   */
-  static Uint32 sound_timer_callback(Uint32 p_interval, void* p_param);
-
-  /**
-   * When an emulator is started, it uses this callback and SDL_AddTimer to register to have 
-   * StepTick() called every p_interval m.s.
+   * Generates a random number with the emulator's own generator, AND masks it with p_mask, and 
+   * stores in register p_register.
    */
-  static Uint32 step_timer_callback(Uint32 p_interval, void* p_param);
+  void GenerateRandom(int p_register, int p_mask);
 
 };
 
@@ -1,78 +1,119 @@
 #include "emu.hpp"
 
-#include <bitset>
+#include <iostream>
 
-void Emu::DecodeRegisterArithmetic(std::bitset<16> p_instruction) {
-  std::bitset<16> second_byte_mask = std::bitset<16>(0x0F00);
-  std::bitset<16> third_byte_mask = std::bitset<16>(0x00F0);
-  std::bitset<16> fourth_byte_mask = std::bitset<16>(0x000F);
+void Emu::DecodeRegisterArithmetic(uint16_t p_instruction) {
+  int y_register = (p_instruction & 0x00F0) >> 4;
+  int x_register = (p_instruction & 0x0F00) >> 8;
 
-  int first_register = ((p_instruction & third_byte_mask) >> 4).to_ulong();
-  int second_register = ((p_instruction & second_byte_mask) >> 8).to_ulong();
-
-  int first_value = get_register(first_register);
-  int second_value = get_register(second_register);
-
-  int last_nibble = (p_instruction & fourth_byte_mask).to_ulong();
+  int last_nibble = p_instruction & 0x000F;
 
   switch(last_nibble) {
     case 0: {
-      set_register(second_register, first_value);
+      CopyRegister(x_register, y_register);
       break;
     }
     case 1: {
-      set_register(second_register, first_value | second_value);
+      OrRegisters(x_register, y_register);
       break;
     }
     case 2: {
-      set_register(second_register, first_value & second_value);
+      AndRegisters(x_register, y_register);
       break;
     }
     case 3: {
-      set_register(second_register, first_value ^ second_value);
+      XorRegisters(x_register, y_register);
       break;
     }
     case 4: {
-      set_register(second_register, first_value + second_value);
-      if (first_value + second_value > 0xFF) {
-        set_register(0xF, 1);
-      } else {
-        set_register(0xF, 0);
-      }
+      AddRegisters(x_register, y_register);
       break;
     }  
     case 5: {
-      if (second_value < first_value) {
-        set_register(0xF, 0);
-      } else {
-        set_register(0xF, 1);
-      }
-      set_register(second_register, second_value - first_value);
+      SubtractRegisters(x_register, y_register);
       break;
     }
     case 6: { 
-      set_register(0xF, first_value & 1);
-      set_register(second_register, first_value >> 1);
+      ShiftRight(x_register, y_register);
       break;
     }
     case 7: {
-      if (first_value < second_value) {
-        set_register(0xF, 0);
-      } else {
-        set_register(0xF, 1);
-      }
-      set_register(second_register, first_value - second_value);
+      SubtractRegistersReverse(x_register, y_register);
       break;
     }
     case 0xE: {
-      set_register(0xF, first_value & 1); 
-      set_register(second_register, first_value << 1);
+      ShiftLeft(x_register, y_register);
       break;
     }
     default: {
-      std::cout << "Instruction unknown " << p_instruction << std::endl;
-      std::cout << "Last byte: " << std::hex << (p_instruction & fourth_byte_mask).to_string() 
-        << std::endl;
+      std::cout << "Instruction unknown 0x" << std::hex << p_instruction << std::endl;
+      std::cout << "Last byte: " << std::hex << last_nibble << std::endl;
     }
   }
+}
+
+void Emu::CopyRegister(int p_x_register, int p_y_register) {
+  set_register(p_x_register, get_register(p_y_register));
+}
+
+void Emu::OrRegisters(int p_x_register, int p_y_register) {
+  set_register(p_x_register, get_register(p_y_register) | get_register(p_x_register));
+}
+
+void Emu::AndRegisters(int p_x_register, int p_y_register) {
+  set_register(p_x_register, get_register(p_y_register) & get_register(p_x_register));
+}
+
+void Emu::XorRegisters(int p_x_register, int p_y_register) {
+  set_register(p_x_register, get_register(p_y_register) ^ get_register(p_x_register));
+}
+
+void Emu::AddRegisters(int p_x_register, int p_y_register) {
+  int first_value = get_register(p_y_register);
+  int second_value = get_register(p_x_register);
+
+  set_register(p_x_register, first_value + second_value);
+  if (first_value + second_value > 0xFF) {
+    set_register(0xF, 1);
+  } else {
+    set_register(0xF, 0);
+  }
+}
+
+void Emu::SubtractRegisters(int p_x_register, int p_y_register) {
+  int first_value = get_register(p_y_register);
+  int second_value = get_register(p_x_register);
+
+  if (second_value < first_value) {
+    set_register(0xF, 0);
+  } else {
+    set_register(0xF, 1);
+  }
+  set_register(p_x_register, second_value - first_value);
+}
+
+void Emu::ShiftRight(int p_x_register, int p_y_register) {
+  int first_value = get_register(p_y_register);
+
+  set_register(0xF, first_value & 1);
+  set_register(p_x_register, first_value >> 1);
+}
+
+void Emu::SubtractRegistersReverse(int p_x_register, int p_y_register) {
+  int first_value = get_register(p_y_register);
+  int second_value = get_register(p_x_register);
+
+  if (first_value < second_value) {
+    set_register(0xF, 0);
+  } else {
+    set_register(0xF, 1);
+  }
+  set_register(p_x_register, first_value - second_value);
+}
+
+void Emu::ShiftLeft(int p_x_register, int p_y_register) {
+  int first_value = get_register(p_y_register);
+
+  set_register(0xF, first_value & 1); 
+  set_register(p_x_register, first_value << 1);
 }
\ No newline at end of file
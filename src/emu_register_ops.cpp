@@ -2,8 +2,8 @@
 
 #include <iostream>
 
-void Emu::DecodeRegisterOps(int p_register_number, std::bitset<8> p_instruction) {
-  switch(p_instruction.to_ulong()) {
+void Emu::DecodeRegisterOps(int p_register_number, int p_instruction) {
+  switch(p_instruction) {
     case 0x7: {
       variable_registers_[p_register_number].Write(delay_timer_);
       break;
@@ -42,33 +42,16 @@ void Emu::DecodeRegisterOps(int p_register_number, std::bitset<8> p_instruction)
     }
     default:{
       std::cout << "Unknown instruction: 0xF" << std::hex << p_register_number << std::hex 
-        << p_instruction.to_ulong() << std::endl; 
+        << p_instruction << std::endl; 
     }
   }
 }
 
 void Emu::WaitForKeyPress(int p_register) {
-  bool waiting = true;
-  while (waiting) {
-    SDL_Event e;
-    while(SDL_PollEvent(&e) && waiting) {
-      switch (e.type) {
-        // If we get a quit event, push it back to the event queue and stop waiting for a key.
-        case SDL_QUIT:
-          SDL_PushEvent(&e);
-          waiting = false;
-          break;
-        // If we get a key press, check if its a recognized key and if so, save to register.
-        case SDL_KEYDOWN: {
-          SDL_Scancode code = e.key.keysym.scancode;
-          if (keyboard_.IsValidKey(code)) {
-            variable_registers_[p_register].Write(keyboard_.GetKeyValue(code));
-            waiting = false;
-          }
-        }
-      }
-    }
-  }
+  // Stay on this instruction until KeyDown delivers a key into the register.
+  program_counter_ -= 2;
+  waiting_for_key_ = true;
+  wait_register_ = p_register;
 }
 
 void Emu::AddRegisterToIndex(int p_register_number) {
@@ -96,24 +79,34 @@ void Emu::StoreBinaryCodedDecimal(int p_register_number) {
   int mem_start = index_register_.Read().to_ulong();
 
   // Store each digit in its own byte in memory.
-  memory_.Write(mem_start, std::bitset<8>(hundreds_place));
-  memory_.Write(mem_start + 1, std::bitset<8>(tens_place));
-  memory_.Write(mem_start + 2, std::bitset<8>(ones_place));
+  const uint8_t digits[] = {
+    static_cast<uint8_t>(hundreds_place), 
+    static_cast<uint8_t>(tens_place), 
+    static_cast<uint8_t>(ones_place)
+  };
+  memory_.Write(mem_start, digits, 3);
+  MemoryWritten(mem_start, 3);
 }
 
 void Emu::StoreRegistersToMem(int p_register_number) {
+  // Gather V0 -> Vp_register_number so they can be copied into memory in one write.
+  uint8_t values[16];
   for (int i = 0; i <= p_register_number; i++) {
-    int address_to_write = index_register_.Read().to_ulong() + i;
-    std::bitset<8> value_to_write = variable_registers_[i].Read();
-    memory_.Write(address_to_write, value_to_write);
+    values[i] = variable_registers_[i].Read().to_ulong();
   }
+  memory_.Write(index_register_.Read().to_ulong(), values, p_register_number + 1);
+  MemoryWritten(index_register_.Read().to_ulong(), p_register_number + 1);
   index_register_.Write(std::bitset<16>(index_register_.Read().to_ulong() + p_register_number + 1));
 }
 
 void Emu::ReadMemToRegisters(int p_register_number) {
   int start_mem = index_register_.Read().to_ulong();
+
+  // Bulk read the bytes, anything past the end of memory reads as 0.
+  uint8_t values[16];
+  memory_.Read(start_mem, values, p_register_number + 1);
   for (int i = 0; i <= p_register_number; i++) {
-    variable_registers_[i].Write(memory_.Read(start_mem + i));
+    variable_registers_[i].Write(values[i]);
   }
   index_register_.Write(start_mem + p_register_number + 1);
 }
\ No newline at end of file
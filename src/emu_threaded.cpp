@@ -0,0 +1,184 @@
+#include "emu.hpp"
+
+#include <iostream>
+
+// Labels-as-values is a GCC/Clang extension, every other compiler gets the portable switch loop.
+#if defined(__GNUC__) || defined(__clang__)
+#define CHIP8_COMPUTED_GOTO
+#endif
+
+/**
+ * Fetches the opcode at the program counter straight out of p_memory and advances the program 
+ * counter past it. Instructions that straddle the end of memory go through Fetch, which handles
+ * the out of bounds read.
+ */
+#define THREADED_FETCH(p_memory) \
+  ((program_counter_ >= 0 && program_counter_ < Ram::ADDRESSES - 1) \
+    ? (program_counter_ += 2, \
+      static_cast<uint16_t>((p_memory[program_counter_ - 2] << 8) | p_memory[program_counter_ - 1])) \
+    : Fetch())
+
+#ifdef CHIP8_COMPUTED_GOTO
+
+/**
+ * Ends the current instruction body by fetching the next opcode and jumping directly to the body 
+ * that executes it, or leaving the loop once p_count instructions have run.
+ */
+#define NEXT() \
+  do { \
+    if (executed == p_count) goto done; \
+    executed++; \
+    entry = &dispatch_table_[THREADED_FETCH(memory)]; \
+    goto *labels[entry->instruction.type]; \
+  } while (0)
+
+int Emu::ExecuteThreaded(int p_count) {
+  // Indexed by InstructionType, so the order here must match the enum.
+  static void* labels[INSTRUCTION_TYPE_COUNT] = {
+    &&clear_screen, &&return_from, &&jump, &&call, &&skip_equal, &&skip_not_equal, 
+    &&skip_registers_equal, &&set_register, &&add_value, &&copy_register, &&or_registers, 
+    &&and_registers, &&xor_registers, &&add_registers, &&subtract, &&shift_right, 
+    &&subtract_reverse, &&shift_left, &&skip_registers_not_equal, &&set_index, &&jump_offset, 
+    &&random, &&draw, &&skip_key_pressed, &&skip_key_not_pressed, &&get_delay, &&wait_key, 
+    &&set_delay, &&set_sound, &&add_index, &&set_sprite, &&store_bcd, &&store_registers, 
+    &&read_registers, &&unknown
+  };
+
+  const uint8_t* memory = memory_.View().data;
+  const DispatchEntry* entry;
+  int executed = 0;
+
+  NEXT();
+
+clear_screen:
+  ClearScreen();
+  NEXT();
+return_from:
+  ReturnFromSubroutine();
+  NEXT();
+jump:
+  Jump(entry->instruction.nnn);
+  NEXT();
+call:
+  ExecuteSubroutine(entry->instruction.nnn);
+  NEXT();
+skip_equal:
+  SkipIfEqual(entry->instruction.x, entry->instruction.nn);
+  NEXT();
+skip_not_equal:
+  SkipIfNotEqual(entry->instruction.x, entry->instruction.nn);
+  NEXT();
+skip_registers_equal:
+  SkipIfRegistersEqual(entry->instruction.x, entry->instruction.y);
+  NEXT();
+set_register:
+  set_register(entry->instruction.x, entry->instruction.nn);
+  NEXT();
+add_value:
+  AddValToRegister(entry->instruction.x, entry->instruction.nn);
+  NEXT();
+copy_register:
+  CopyRegister(entry->instruction.x, entry->instruction.y);
+  NEXT();
+or_registers:
+  OrRegisters(entry->instruction.x, entry->instruction.y);
+  NEXT();
+and_registers:
+  AndRegisters(entry->instruction.x, entry->instruction.y);
+  NEXT();
+xor_registers:
+  XorRegisters(entry->instruction.x, entry->instruction.y);
+  NEXT();
+add_registers:
+  AddRegisters(entry->instruction.x, entry->instruction.y);
+  NEXT();
+subtract:
+  SubtractRegisters(entry->instruction.x, entry->instruction.y);
+  NEXT();
+shift_right:
+  ShiftRight(entry->instruction.x, entry->instruction.y);
+  NEXT();
+subtract_reverse:
+  SubtractRegistersReverse(entry->instruction.x, entry->instruction.y);
+  NEXT();
+shift_left:
+  ShiftLeft(entry->instruction.x, entry->instruction.y);
+  NEXT();
+skip_registers_not_equal:
+  SkipIfRegistersNotEqual(entry->instruction.x, entry->instruction.y);
+  NEXT();
+set_index:
+  set_index_register(entry->instruction.nnn);
+  NEXT();
+jump_offset:
+  Jump(get_register(0) + entry->instruction.nnn);
+  NEXT();
+random:
+  GenerateRandom(entry->instruction.x, entry->instruction.nn);
+  NEXT();
+draw:
+  DisplaySprite(entry->instruction.n, get_register(entry->instruction.x), 
+    get_register(entry->instruction.y));
+  NEXT();
+skip_key_pressed:
+  SkipIfKeyPressed(entry->instruction.x);
+  NEXT();
+skip_key_not_pressed:
+  SkipIfKeyNotPressed(entry->instruction.x);
+  NEXT();
+get_delay:
+  set_register(entry->instruction.x, delay_timer_);
+  NEXT();
+wait_key:
+  WaitForKeyPress(entry->instruction.x);
+  if (waiting_for_key_) {
+    goto done;
+  }
+  NEXT();
+set_delay:
+  set_delay_timer(get_register(entry->instruction.x));
+  NEXT();
+set_sound:
+  set_sound_timer(get_register(entry->instruction.x));
+  NEXT();
+add_index:
+  AddRegisterToIndex(entry->instruction.x);
+  NEXT();
+set_sprite:
+  SetSpriteMemoryAddress(entry->instruction.x);
+  NEXT();
+store_bcd:
+  StoreBinaryCodedDecimal(entry->instruction.x);
+  NEXT();
+store_registers:
+  StoreRegistersToMem(entry->instruction.x);
+  NEXT();
+read_registers:
+  ReadMemToRegisters(entry->instruction.x);
+  NEXT();
+unknown:
+  entry->handler(*this, entry->instruction);
+  NEXT();
+
+done:
+  return executed;
+}
+
+#undef NEXT
+
+#else
+
+int Emu::ExecuteThreaded(int p_count) {
+  const uint8_t* memory = memory_.View().data;
+  int executed = 0;
+
+  for (; executed < p_count && !waiting_for_key_; executed++) {
+    const DispatchEntry& entry = dispatch_table_[THREADED_FETCH(memory)];
+    entry.handler(*this, entry.instruction);
+  }
+  return executed;
+}
+
+#endif
+
+#undef THREADED_FETCH
@@ -0,0 +1,22 @@
+#ifndef FRONTEND_HPP
+#define FRONTEND_HPP
+
+#include "display.hpp"
+
+/**
+ * Interface a frontend implements to show the emulator display. The core never draws anything
+ * itself, it only hands the display to the video output when Emu::Render is called.
+ */
+class VideoOutput {
+
+public:
+
+  virtual ~VideoOutput() {}
+
+  /**
+   * Shows the current contents of p_display.
+   */
+  virtual void Present(const Display& p_display) = 0;
+};
+
+#endif
@@ -0,0 +1,343 @@
+#include "jit_x64.hpp"
+
+#include "emu.hpp"
+
+#include <cstring>
+
+#ifdef CHIP8_JIT_X64
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+const int JitCompiler::CODE_BUFFER_SIZE;
+const int JitCompiler::HOT_THRESHOLD;
+
+namespace {
+
+// Upper bound on the code generated for a single block, checked before compiling one.
+const int MAX_BLOCK_CODE = (BlockCache::MAX_BLOCK_INSTRUCTIONS + 2) * 48;
+
+// x86 register numbers used in ModRM reg fields.
+const int EAX = 0;
+const int ECX = 1;
+const int EDX = 2;
+
+}
+
+JitCompiler::JitCompiler() {
+  code_ = nullptr;
+  code_used_ = 0;
+  cursor_ = nullptr;
+  registers_offset_ = 0;
+  index_offset_ = 0;
+  program_counter_offset_ = 0;
+
+#ifdef CHIP8_JIT_X64
+#ifdef _WIN32
+  code_ = static_cast<uint8_t*>(VirtualAlloc(nullptr, CODE_BUFFER_SIZE, MEM_COMMIT | MEM_RESERVE, 
+                                             PAGE_EXECUTE_READWRITE));
+#else
+  void* memory = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, 
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory != MAP_FAILED) {
+    code_ = static_cast<uint8_t*>(memory);
+  }
+#endif
+#endif
+}
+
+JitCompiler::~JitCompiler() {
+#ifdef CHIP8_JIT_X64
+  if (code_ != nullptr) {
+#ifdef _WIN32
+    VirtualFree(code_, 0, MEM_RELEASE);
+#else
+    munmap(code_, CODE_BUFFER_SIZE);
+#endif
+  }
+#endif
+}
+
+bool JitCompiler::IsSupported() {
+#ifdef CHIP8_JIT_X64
+  return true;
+#else
+  return false;
+#endif
+}
+
+void JitCompiler::Reset() {
+  code_used_ = 0;
+}
+
+bool JitCompiler::Compile(Emu& p_emu, Block& p_block) {
+  if (!IsSupported() || code_ == nullptr || code_used_ + MAX_BLOCK_CODE > CODE_BUFFER_SIZE) {
+    return false;
+  }
+
+  // Compiled code addresses the emulator state relative to the Emu pointer kept in rbx.
+  const char* base = reinterpret_cast<const char*>(&p_emu);
+  registers_offset_ = reinterpret_cast<const char*>(&p_emu.variable_registers_[0]) - base;
+  index_offset_ = reinterpret_cast<const char*>(&p_emu.index_register_) - base;
+  program_counter_offset_ = reinterpret_cast<const char*>(&p_emu.program_counter_) - base;
+
+  uint8_t* start = code_ + code_used_;
+  cursor_ = start;
+  EmitPrologue();
+
+  int address = p_block.start_address;
+  int compiled = 0;
+  bool exited = false;
+  int size = p_block.entries.size();
+
+  for (int i = 0; i < size && !exited; i++) {
+    const DispatchEntry* entry = p_block.entries[i];
+    const Instruction& instruction = entry->instruction;
+    compiled++;
+
+    switch (instruction.type) {
+      case OP_JUMP: {
+        EmitSetProgramCounter(instruction.nnn);
+        exited = true;
+        break;
+      }
+      case OP_SET_REGISTER: {
+        // mov byte [Vx], nn
+        EmitRbxOperand(0xC6, 0, registers_offset_ + instruction.x);
+        Emit8(instruction.nn);
+        break;
+      }
+      case OP_ADD_VALUE: {
+        // add byte [Vx], nn
+        EmitRbxOperand(0x80, 0, registers_offset_ + instruction.x);
+        Emit8(instruction.nn);
+        break;
+      }
+      case OP_SET_INDEX: {
+        // mov word [I], nnn
+        Emit8(0x66);
+        EmitRbxOperand(0xC7, 0, index_offset_);
+        Emit16(instruction.nnn);
+        break;
+      }
+      case OP_ADD_INDEX: {
+        // movzx eax, byte [Vx]; add word [I], ax
+        Emit8(0x0F);
+        EmitRbxOperand(0xB6, EAX, registers_offset_ + instruction.x);
+        Emit8(0x66);
+        EmitRbxOperand(0x01, EAX, index_offset_);
+        break;
+      }
+      case OP_SKIP_EQUAL:
+      case OP_SKIP_NOT_EQUAL:
+      case OP_SKIP_REGISTERS_EQUAL:
+      case OP_SKIP_REGISTERS_NOT_EQUAL: {
+        EmitSkip(address, instruction);
+        exited = true;
+        break;
+      }
+      case OP_STORE_BCD:
+      case OP_STORE_REGISTERS: {
+        // Memory writes may overwrite this very block, so the compiled code ends after them.
+        EmitHandlerCall(address, entry);
+        exited = true;
+        break;
+      }
+      case OP_RETURN:
+      case OP_CALL:
+      case OP_JUMP_OFFSET:
+      case OP_SKIP_KEY_PRESSED:
+      case OP_SKIP_KEY_NOT_PRESSED:
+      case OP_WAIT_KEY: {
+        EmitHandlerCall(address, entry);
+        exited = true;
+        break;
+      }
+      default: {
+        if (!EmitArithmetic(instruction)) {
+          EmitHandlerCall(address, entry);
+        }
+        break;
+      }
+    }
+    address += 2;
+  }
+
+  if (!exited) {
+    EmitSetProgramCounter(address);
+  }
+  EmitEpilogue();
+
+  p_block.native_code = start;
+  p_block.native_length = compiled;
+  code_used_ += cursor_ - start;
+  return true;
+}
+
+bool JitCompiler::EmitArithmetic(const Instruction& p_instruction) {
+  int32_t x = registers_offset_ + p_instruction.x;
+  int32_t y = registers_offset_ + p_instruction.y;
+  int32_t flag = registers_offset_ + 0xF;
+
+  switch (p_instruction.type) {
+    case OP_COPY_REGISTER:
+    case OP_OR:
+    case OP_AND:
+    case OP_XOR: {
+      // movzx eax, byte [Vy]; op al, byte [Vx]; mov byte [Vx], al
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, EAX, y);
+      if (p_instruction.type == OP_OR) {
+        EmitRbxOperand(0x0A, EAX, x);
+      } else if (p_instruction.type == OP_AND) {
+        EmitRbxOperand(0x22, EAX, x);
+      } else if (p_instruction.type == OP_XOR) {
+        EmitRbxOperand(0x32, EAX, x);
+      }
+      EmitRbxOperand(0x88, EAX, x);
+      return true;
+    }
+    case OP_ADD_REGISTERS: {
+      // eax = Vy + Vx; Vx = al; VF = carry out of the low byte.
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, EAX, y);
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, ECX, x);
+      Emit8(0x01); Emit8(0xC8);             // add eax, ecx
+      EmitRbxOperand(0x88, EAX, x);
+      Emit8(0xC1); Emit8(0xE8); Emit8(0x08); // shr eax, 8
+      EmitRbxOperand(0x88, EAX, flag);
+      return true;
+    }
+    case OP_SUBTRACT:
+    case OP_SUBTRACT_REVERSE: {
+      // VF = (minuend >= subtrahend) is written before the difference, like the interpreter.
+      bool reverse = p_instruction.type == OP_SUBTRACT_REVERSE;
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, EAX, reverse ? y : x);
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, ECX, reverse ? x : y);
+      Emit8(0x31); Emit8(0xD2);              // xor edx, edx
+      Emit8(0x39); Emit8(0xC8);              // cmp eax, ecx
+      Emit8(0x0F); Emit8(0x93); Emit8(0xC2); // setae dl
+      EmitRbxOperand(0x88, EDX, flag);
+      Emit8(0x29); Emit8(0xC8);              // sub eax, ecx
+      EmitRbxOperand(0x88, EAX, x);
+      return true;
+    }
+    case OP_SHIFT_RIGHT:
+    case OP_SHIFT_LEFT: {
+      // VF = Vy & 1 is written before the shifted value, like the interpreter.
+      Emit8(0x0F);
+      EmitRbxOperand(0xB6, EAX, y);
+      Emit8(0x89); Emit8(0xC1);              // mov ecx, eax
+      Emit8(0x83); Emit8(0xE1); Emit8(0x01); // and ecx, 1
+      EmitRbxOperand(0x88, ECX, flag);
+      Emit8(0xD1);
+      Emit8(p_instruction.type == OP_SHIFT_RIGHT ? 0xE8 : 0xE0); // shr / shl eax, 1
+      EmitRbxOperand(0x88, EAX, x);
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+void JitCompiler::EmitSkip(int p_address, const Instruction& p_instruction) {
+  // movzx eax, byte [Vx]; xor ecx, ecx
+  Emit8(0x0F);
+  EmitRbxOperand(0xB6, EAX, registers_offset_ + p_instruction.x);
+  Emit8(0x31); Emit8(0xC9);
+
+  bool registers = p_instruction.type == OP_SKIP_REGISTERS_EQUAL || 
+                   p_instruction.type == OP_SKIP_REGISTERS_NOT_EQUAL;
+  if (registers) {
+    // cmp al, byte [Vy]
+    EmitRbxOperand(0x3A, EAX, registers_offset_ + p_instruction.y);
+  } else {
+    // cmp al, nn
+    Emit8(0x3C);
+    Emit8(p_instruction.nn);
+  }
+
+  bool equal = p_instruction.type == OP_SKIP_EQUAL || 
+               p_instruction.type == OP_SKIP_REGISTERS_EQUAL;
+  // sete / setne cl
+  Emit8(0x0F); Emit8(equal ? 0x94 : 0x95); Emit8(0xC1);
+
+  // lea eax, [rcx * 2 + address + 2]; mov dword [pc], eax
+  Emit8(0x8D); Emit8(0x04); Emit8(0x4D);
+  Emit32(p_address + 2);
+  EmitRbxOperand(0x89, EAX, program_counter_offset_);
+}
+
+void JitCompiler::EmitHandlerCall(int p_address, const DispatchEntry* p_entry) {
+  EmitSetProgramCounter(p_address + 2);
+
+#ifdef _WIN32
+  Emit8(0x48); Emit8(0x89); Emit8(0xD9); // mov rcx, rbx
+  Emit8(0x48); Emit8(0xBA);              // mov rdx, &instruction
+#else
+  Emit8(0x48); Emit8(0x89); Emit8(0xDF); // mov rdi, rbx
+  Emit8(0x48); Emit8(0xBE);              // mov rsi, &instruction
+#endif
+  Emit64(reinterpret_cast<uint64_t>(&p_entry->instruction));
+
+  Emit8(0x48); Emit8(0xB8);              // mov rax, handler
+  Emit64(reinterpret_cast<uint64_t>(p_entry->handler));
+  Emit8(0xFF); Emit8(0xD0);              // call rax
+}
+
+void JitCompiler::EmitSetProgramCounter(int p_address) {
+  // mov dword [pc], address
+  EmitRbxOperand(0xC7, 0, program_counter_offset_);
+  Emit32(p_address);
+}
+
+void JitCompiler::EmitPrologue() {
+  Emit8(0x53);                                         // push rbx
+  Emit8(0x48); Emit8(0x83); Emit8(0xEC); Emit8(0x20);  // sub rsp, 32
+#ifdef _WIN32
+  Emit8(0x48); Emit8(0x89); Emit8(0xCB);               // mov rbx, rcx
+#else
+  Emit8(0x48); Emit8(0x89); Emit8(0xFB);               // mov rbx, rdi
+#endif
+}
+
+void JitCompiler::EmitEpilogue() {
+  Emit8(0x48); Emit8(0x83); Emit8(0xC4); Emit8(0x20);  // add rsp, 32
+  Emit8(0x5B);                                         // pop rbx
+  Emit8(0xC3);                                         // ret
+}
+
+void JitCompiler::EmitRbxOperand(uint8_t p_opcode, int p_reg, int32_t p_offset) {
+  Emit8(p_opcode);
+  // mod = 10 (disp32), rm = 011 (rbx)
+  Emit8(0x80 | (p_reg << 3) | 3);
+  Emit32(p_offset);
+}
+
+void JitCompiler::Emit8(uint8_t p_byte) {
+  *cursor_++ = p_byte;
+}
+
+void JitCompiler::Emit16(uint16_t p_value) {
+  std::memcpy(cursor_, &p_value, sizeof(p_value));
+  cursor_ += sizeof(p_value);
+}
+
+void JitCompiler::Emit32(uint32_t p_value) {
+  std::memcpy(cursor_, &p_value, sizeof(p_value));
+  cursor_ += sizeof(p_value);
+}
+
+void JitCompiler::Emit64(uint64_t p_value) {
+  std::memcpy(cursor_, &p_value, sizeof(p_value));
+  cursor_ += sizeof(p_value);
+}
@@ -0,0 +1,145 @@
+#ifndef JIT_X64_HPP
+#define JIT_X64_HPP
+
+#include "block_cache.hpp"
+
+#include <cstdint>
+
+// Native code is only emitted for x86-64, everywhere else the JIT engine runs on the interpreter.
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHIP8_JIT_X64
+#endif
+
+class Emu;
+
+/**
+ * Signature of a compiled block. Runs every instruction the block was compiled from on p_emu and
+ * leaves the program counter pointing at the next instruction to execute.
+ */
+typedef void (*NativeBlock)(Emu* p_emu);
+
+/**
+ * Dynamic recompiler that translates hot blocks from the block cache into x86-64 machine code.
+ * Register and arithmetic instructions, jumps and skips are compiled to native instructions that 
+ * work directly on the emulator's registers. Everything else, including Dxyn and the keypad 
+ * instructions, is compiled to a call into the instruction's dispatch table handler, so both 
+ * paths always leave the emulator in the same state as the interpreter.
+ */
+class JitCompiler {
+
+public:
+
+  /**
+   * Size in bytes of the executable buffer compiled code is written to.
+   */
+  const static int CODE_BUFFER_SIZE = 256 * 1024;
+
+  /**
+   * Number of times a block has to run before it is compiled.
+   */
+  const static int HOT_THRESHOLD = 4;
+
+  JitCompiler();
+
+  ~JitCompiler();
+
+  JitCompiler(const JitCompiler&) = delete;
+  JitCompiler& operator=(const JitCompiler&) = delete;
+
+  /**
+   * Returns true if the JIT can generate code for the target it was built for.
+   */
+  static bool IsSupported();
+
+  /**
+   * Returns true if the executable code buffer could be allocated. Hosts that refuse writable and
+   * executable mappings leave the compiler without one.
+   */
+  bool has_code_buffer() const { return code_ != nullptr; }
+
+  /**
+   * Compiles p_block for p_emu, filling in the block's native code and length. Returns false if 
+   * the block could not be compiled, either because the target is not supported or because the 
+   * code buffer is full.
+   */
+  bool Compile(Emu& p_emu, Block& p_block);
+
+  /**
+   * Throws away all compiled code so the buffer can be reused. Every block pointing into the 
+   * buffer must have its native code cleared first.
+   */
+  void Reset();
+
+private:
+
+  /**
+   * Start of the executable code buffer, or nullptr if it could not be allocated.
+   */
+  uint8_t* code_;
+
+  /**
+   * Number of bytes of the code buffer holding compiled blocks.
+   */
+  int code_used_;
+
+  /**
+   * Where the next emitted byte is written.
+   */
+  uint8_t* cursor_;
+
+  /**
+   * Byte offsets of V0, the index register and the program counter from the start of the Emu.
+   */
+  int32_t registers_offset_;
+  int32_t index_offset_;
+  int32_t program_counter_offset_;
+
+  /**
+   * Helpers that append raw bytes and little endian immediates to the code buffer.
+   */
+  void Emit8(uint8_t p_byte);
+  void Emit16(uint16_t p_value);
+  void Emit32(uint32_t p_value);
+  void Emit64(uint64_t p_value);
+
+  /**
+   * Emits p_opcode followed by a ModRM byte addressing [rbx + p_offset] with p_reg in its reg 
+   * field. rbx always holds the Emu pointer inside compiled code.
+   */
+  void EmitRbxOperand(uint8_t p_opcode, int p_reg, int32_t p_offset);
+
+  /**
+   * Saves rbx, reserves shadow space for calls and loads the Emu pointer argument into rbx.
+   */
+  void EmitPrologue();
+
+  /**
+   * Undoes the prologue and returns to the caller.
+   */
+  void EmitEpilogue();
+
+  /**
+   * Stores p_address into the program counter.
+   */
+  void EmitSetProgramCounter(int p_address);
+
+  /**
+   * Sets the program counter to p_address + 2 and calls the dispatch table handler of p_entry, 
+   * for instructions that are not compiled natively.
+   */
+  void EmitHandlerCall(int p_address, const DispatchEntry* p_entry);
+
+  /**
+   * Compiles the arithmetic and logic instruction p_instruction. Returns false if it has no native 
+   * translation.
+   */
+  bool EmitArithmetic(const Instruction& p_instruction);
+
+  /**
+   * Compiles the skip p_instruction found at p_address, setting the program counter to p_address 
+   * + 2, or p_address + 4 if the next instruction is skipped.
+   */
+  void EmitSkip(int p_address, const Instruction& p_instruction);
+};
+
+#endif
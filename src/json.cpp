@@ -0,0 +1,42 @@
+#include "json.hpp"
+
+#include <cstdio>
+
+std::string json_string(const std::string& p_text) {
+  std::string quoted = "\"";
+  for (char c : p_text) {
+    switch (c) {
+      case '"':
+        quoted += "\\\"";
+        break;
+      case '\\':
+        quoted += "\\\\";
+        break;
+      case '\b':
+        quoted += "\\b";
+        break;
+      case '\f':
+        quoted += "\\f";
+        break;
+      case '\n':
+        quoted += "\\n";
+        break;
+      case '\r':
+        quoted += "\\r";
+        break;
+      case '\t':
+        quoted += "\\t";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04X", (unsigned char)c);
+          quoted += escaped;
+        } else {
+          quoted += c;
+        }
+        break;
+    }
+  }
+  return quoted + "\"";
+}
@@ -0,0 +1,13 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+
+/**
+ * Returns p_text quoted for a JSON string. Quotes and backslashes are escaped, and so are control
+ * characters, so rom names and paths holding any byte still give valid JSON. Other bytes are 
+ * copied as they are.
+ */
+std::string json_string(const std::string& p_text);
+
+#endif
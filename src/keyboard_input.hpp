@@ -3,14 +3,11 @@
 #ifndef KEYBOARD_INPUT_HPP
 #define KEYBOARD_INPUT_HPP
 
-#include <SDL.h>
-#include <iostream>
-#include <map>
 #include <array>
 
 /**
  * Class designed to keep track of keyboard input for chip-8 simulator. Keeps track of the state of 
- * a 4x4 hex keypad, mapping to keys 1-4, q-r, a-f, z-v, on a qwerty keyboard.
+ * a 4x4 hex keypad with keys 0x0 -> 0xF. Mapping host keys to keypad keys is left to the frontend.
  */
 class KeyboardInput {
 
@@ -19,20 +16,14 @@ public:
   KeyboardInput();
 
   /**
-   * Checks if given scancode is mapped and if so sets the mapped key state to 1 (or pressed).
+   * Sets the state of keypad key p_key to 1 (or pressed). Keys outside 0x0 -> 0xF are ignored.
    */
-  void HandleKeyDown(SDL_Scancode p_code);
+  void HandleKeyDown(int p_key);
 
   /**
-   * Checks if given scancode is mapped and if so, sets the mapped key state to 0 (or released).
+   * Sets the state of keypad key p_key to 0 (or released). Keys outside 0x0 -> 0xF are ignored.
    */
-  void HandleKeyUp(SDL_Scancode p_code);
-
-  /**
-   * Checks if given scancode is mapped and if so returns true if mapped key is down, false 
-   * otherwise. Method also returns false if key does not have a mapping.
-   */
-  bool IsKeyDown(SDL_Scancode p_code);
+  void HandleKeyUp(int p_key);
 
   /**
    * Checks if the key corresponding to the given hex value is currently down.
@@ -40,26 +31,21 @@ public:
   bool IsKeyDown(int p_hex_value);
 
   /**
-   * Checks if the key with scancode p_code is recognized by the chip 8 emulator.
-   */
-  bool IsValidKey(SDL_Scancode p_code);
-
-  /**
-   * Returns the hex value associated with the given key (or -1 if not a valid key).
+   * Checks if p_key is one of the keypad keys 0x0 -> 0xF.
    */
-  int GetKeyValue(SDL_Scancode p_code);
+  bool IsValidKey(int p_key);
 
   /**
    * Returns array representing the state of keys 0x0 -> 0xF. 
    */
   std::array<bool, 16> get_keys();
 
-private:
-
   /**
-   * Map of scan codes to values of the keys.
+   * Replaces the state of keys 0x0 -> 0xF with p_keys.
    */
-  std::map<SDL_Scancode, int> key_mappings_;
+  void set_keys(const std::array<bool, 16>& p_keys);
+
+private:
   
   /**
    * Boolean array keeping track of pressed or released keys in hex keypad.
@@ -72,4 +58,4 @@ private:
   void SetKey(int p_key, bool p_value);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,766 @@
+#include "lockstep_emu.hpp"
+
+#include "emu.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+const int LockstepEmu::MAX_LANES;
+const int LockstepEmu::MEMORY_SIZE;
+const int LockstepEmu::MEMORY_STRIDE;
+const int LockstepEmu::STACK_SIZE;
+const int LockstepEmu::GROUP_SLOTS;
+const int LockstepEmu::SMALL_REMAINDER;
+const int LockstepEmu::BREAK_EVEN_LANES;
+const int LockstepEmu::WINDOW_STEPS;
+const int LockstepEmu::CHECK_INTERVAL;
+
+/**
+ * Lanes handled by one vector operation: a whole row in an AVX2 register, or half a row in an SSE2 
+ * register. Wider vectors than the target has get split into scalar code by GCC, so rows are always 
+ * processed in chunks of the native width.
+ */
+#if defined(__AVX2__)
+static const int VECTOR_LANES = 32;
+#else
+static const int VECTOR_LANES = 16;
+#endif
+
+/**
+ * One byte for each of VECTOR_LANES lanes, a chunk of a register row.
+ */
+typedef uint8_t LaneVector __attribute__((vector_size(VECTOR_LANES)));
+
+static inline LaneVector load_lanes(const uint8_t* p_row) {
+  LaneVector lanes;
+  std::memcpy(&lanes, p_row, sizeof(lanes));
+  return lanes;
+}
+
+static inline void store_lanes(uint8_t* p_row, const LaneVector& p_value) {
+  std::memcpy(p_row, &p_value, sizeof(p_value));
+}
+
+/**
+ * Stores p_value into the lanes of p_row selected by p_mask, leaving the other lanes alone.
+ */
+static inline void blend_lanes(uint8_t* p_row, const LaneVector& p_value, const LaneVector& p_mask) {
+  store_lanes(p_row, (load_lanes(p_row) & ~p_mask) | (p_value & p_mask));
+}
+
+/**
+ * Expands the lowest VECTOR_LANES bits of p_lanes, one bit per lane, into a mask holding 0xFF for 
+ * every set bit and 0 otherwise.
+ */
+static inline LaneVector expand_lanes(uint32_t p_lanes) {
+  // Eight lanes at a time through a table of every byte value spread over eight bytes.
+  static const std::array<uint64_t, 256> spread = [] {
+    std::array<uint64_t, 256> table;
+    table.fill(0);
+    for (int bits = 0; bits < 256; bits++) {
+      for (int i = 0; i < 8; i++) {
+        if (bits & (1 << i)) {
+          table[bits] |= 0xFFull << (i * 8);
+        }
+      }
+    }
+    return table;
+  }();
+
+  uint64_t words[VECTOR_LANES / 8];
+  for (int i = 0; i < VECTOR_LANES / 8; i++) {
+    words[i] = spread[(p_lanes >> (i * 8)) & 0xFF];
+  }
+  LaneVector mask;
+  std::memcpy(&mask, words, sizeof(mask));
+  return mask;
+}
+
+/**
+ * Calls p_kernel(first, mask) for every chunk of VECTOR_LANES lanes holding a lane of p_lanes, 
+ * where first is the first lane of the chunk and mask selects the chunk's lanes in p_lanes.
+ */
+template <typename Kernel>
+static inline void for_each_chunk(uint32_t p_lanes, Kernel p_kernel) {
+  for (int first = 0; first < LockstepEmu::MAX_LANES; first += VECTOR_LANES) {
+    uint32_t chunk = (uint32_t)((uint64_t)p_lanes >> first);
+    if (chunk != 0) {
+      p_kernel(first, expand_lanes(chunk));
+    }
+  }
+}
+
+/**
+ * Returns the number of lanes in p_lanes. Counted with shifts and masks, because without -mpopcnt 
+ * __builtin_popcount is a library call.
+ */
+static inline int count_lanes(uint32_t p_lanes) {
+  p_lanes = p_lanes - ((p_lanes >> 1) & 0x55555555u);
+  p_lanes = (p_lanes & 0x33333333u) + ((p_lanes >> 2) & 0x33333333u);
+  return (((p_lanes + (p_lanes >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+/**
+ * Returns the lowest lane in p_lanes. p_lanes must not be 0.
+ */
+static inline int first_lane(uint32_t p_lanes) {
+  return __builtin_ctz(p_lanes);
+}
+
+LockstepEmu::LockstepEmu(int p_lanes) {
+  lanes_ = std::max(1, std::min(p_lanes, MAX_LANES));
+  lane_mask_ = lanes_ == 32 ? 0xFFFFFFFFu : (1u << lanes_) - 1;
+  waiting_mask_ = 0;
+  cycle_count_ = 0;
+  stats_.lane_instructions = 0;
+  stats_.groups = 0;
+  stats_.scalar_instructions = 0;
+  grouping_ = true;
+  window_steps_ = 0;
+  window_lanes_ = 0;
+  window_groups_ = 0;
+  scalar_steps_ = 0;
+  dispatch_table_ = DispatchTable::Get();
+
+  std::memset(registers_, 0, sizeof(registers_));
+  std::memset(slot_lanes_, 0, sizeof(slot_lanes_));
+  std::memset(delay_timer_, 0, sizeof(delay_timer_));
+  std::memset(sound_timer_, 0, sizeof(sound_timer_));
+  memory_.resize(lanes_ * MEMORY_STRIDE);
+  displays_.resize(lanes_);
+
+  // Start every lane off exactly like a new emulator, fonts and all.
+  Emu fresh;
+  EmuState state;
+  fresh.SaveState(state);
+  for (int lane = 0; lane < lanes_; lane++) {
+    LoadState(lane, state);
+  }
+}
+
+int LockstepEmu::get_lane_count() const {
+  return lanes_;
+}
+
+int LockstepEmu::LoadRom(const uint8_t* p_rom, int p_length) {
+  int loaded = std::max(0, std::min(p_length, MEMORY_SIZE - 0x200));
+  for (int lane = 0; lane < lanes_; lane++) {
+    std::memcpy(LaneMemory(lane) + 0x200, p_rom, loaded);
+  }
+  return loaded;
+}
+
+void LockstepEmu::set_random_seed(int p_lane, uint32_t p_seed) {
+  if (p_lane >= 0 && p_lane < lanes_) {
+    random_state_[p_lane] = p_seed;
+  }
+}
+
+void LockstepEmu::KeyDown(int p_lane, int p_key) {
+  if (p_lane < 0 || p_lane >= lanes_ || p_key < 0 || p_key > 0xF) {
+    return;
+  }
+  keys_[p_lane] |= 1 << p_key;
+
+  // Complete a pending Fx0A with the key and move past it.
+  if (waiting_mask_ & (1u << p_lane)) {
+    registers_[wait_register_[p_lane]][p_lane] = p_key;
+    program_counter_[p_lane] += 2;
+    waiting_mask_ &= ~(1u << p_lane);
+  }
+}
+
+void LockstepEmu::KeyUp(int p_lane, int p_key) {
+  if (p_lane >= 0 && p_lane < lanes_ && p_key >= 0 && p_key <= 0xF) {
+    keys_[p_lane] &= ~(1 << p_key);
+  }
+}
+
+void LockstepEmu::ExecuteBatch(int p_count) {
+  for (int i = 0; i < p_count;) {
+    uint32_t active = lane_mask_ & ~waiting_mask_;
+    if (active == 0) {
+      break;
+    }
+
+    // Diverged lanes run on their own, checking every so often whether they came back together.
+    if (!grouping_) {
+      int count = std::min(p_count - i, CHECK_INTERVAL - scalar_steps_);
+      RunLanes(count);
+      i += count;
+      scalar_steps_ += count;
+      if (scalar_steps_ == CHECK_INTERVAL) {
+        scalar_steps_ = 0;
+        grouping_ = LanesConverged();
+      }
+      continue;
+    }
+
+    long long groups = stats_.groups;
+    Step();
+    int lanes = count_lanes(active);
+    stats_.lane_instructions += lanes;
+    window_lanes_ += lanes;
+    window_groups_ += stats_.groups - groups;
+    i++;
+
+    // Once a window is complete, keep grouping only if the groups were big enough to pay off.
+    if (++window_steps_ == WINDOW_STEPS) {
+      grouping_ = window_lanes_ >= BREAK_EVEN_LANES * window_groups_;
+      window_steps_ = 0;
+      window_lanes_ = 0;
+      window_groups_ = 0;
+    }
+  }
+}
+
+void LockstepEmu::RunFrame(int p_instructions_per_frame) {
+  ExecuteBatch(p_instructions_per_frame);
+  cycle_count_ += p_instructions_per_frame;
+
+  for (int first = 0; first < MAX_LANES; first += VECTOR_LANES) {
+    LaneVector delay = load_lanes(delay_timer_ + first);
+    LaneVector sound = load_lanes(sound_timer_ + first);
+    store_lanes(delay_timer_ + first, delay - ((LaneVector)(delay != 0) & 1));
+    store_lanes(sound_timer_ + first, sound - ((LaneVector)(sound != 0) & 1));
+  }
+}
+
+void LockstepEmu::SaveState(int p_lane, EmuState& p_state) {
+  p_state.version = EmuState::VERSION;
+  p_state.clock_speed = Emu::DEFAULT_CLOCK_SPEED;
+  p_state.cycle_count = cycle_count_;
+  p_state.timer_phase = 0;
+  p_state.random_state = random_state_[p_lane];
+  p_state.program_counter = program_counter_[p_lane];
+  p_state.index_register = index_register_[p_lane];
+  std::copy(stack_[p_lane], stack_[p_lane] + STACK_SIZE, p_state.stack);
+  p_state.keys = keys_[p_lane];
+  for (int i = 0; i < 16; i++) {
+    p_state.registers[i] = registers_[i][p_lane];
+  }
+  p_state.stack_size = stack_size_[p_lane];
+  p_state.delay_timer = delay_timer_[p_lane];
+  p_state.sound_timer = sound_timer_[p_lane];
+  p_state.waiting_for_key = (waiting_mask_ >> p_lane) & 1;
+  p_state.wait_register = wait_register_[p_lane];
+  std::memset(p_state.reserved, 0, sizeof(p_state.reserved));
+  for (int row = 0; row < 32; row++) {
+    p_state.display[row] = displays_[p_lane].GetRow(row);
+  }
+  std::memcpy(p_state.memory, LaneMemory(p_lane), MEMORY_SIZE);
+}
+
+bool LockstepEmu::LoadState(int p_lane, const EmuState& p_state) {
+  if (p_lane < 0 || p_lane >= lanes_ || p_state.version != EmuState::VERSION 
+      || p_state.stack_size > STACK_SIZE || p_state.wait_register > 0xF) {
+    return false;
+  }
+
+  random_state_[p_lane] = p_state.random_state;
+  program_counter_[p_lane] = p_state.program_counter;
+  index_register_[p_lane] = p_state.index_register;
+  std::copy(p_state.stack, p_state.stack + STACK_SIZE, stack_[p_lane]);
+  keys_[p_lane] = p_state.keys;
+  for (int i = 0; i < 16; i++) {
+    registers_[i][p_lane] = p_state.registers[i];
+  }
+  stack_size_[p_lane] = p_state.stack_size;
+  delay_timer_[p_lane] = p_state.delay_timer;
+  sound_timer_[p_lane] = p_state.sound_timer;
+  waiting_mask_ = (waiting_mask_ & ~(1u << p_lane)) | ((p_state.waiting_for_key != 0) << p_lane);
+  wait_register_[p_lane] = p_state.wait_register;
+  for (int row = 0; row < 32; row++) {
+    displays_[p_lane].SetRow(row, p_state.display[row]);
+  }
+  std::memcpy(LaneMemory(p_lane), p_state.memory, MEMORY_SIZE);
+  return true;
+}
+
+int LockstepEmu::get_register(int p_lane, int p_register) const {
+  return registers_[p_register & 0xF][p_lane];
+}
+
+int LockstepEmu::get_program_counter(int p_lane) const {
+  return program_counter_[p_lane];
+}
+
+const Display& LockstepEmu::get_display(int p_lane) const {
+  return displays_[p_lane];
+}
+
+bool LockstepEmu::is_waiting_for_key(int p_lane) const {
+  return (waiting_mask_ >> p_lane) & 1;
+}
+
+LockstepStats LockstepEmu::get_stats() const {
+  return stats_;
+}
+
+uint8_t* LockstepEmu::LaneMemory(int p_lane) {
+  return memory_.data() + p_lane * MEMORY_STRIDE;
+}
+
+inline uint16_t LockstepEmu::Fetch(int p_lane, int p_address) {
+  const uint8_t* memory = LaneMemory(p_lane);
+  if ((unsigned)p_address < MEMORY_SIZE - 1) {
+    return (memory[p_address] << 8) | memory[p_address + 1];
+  }
+
+  // Like Ram::ReadByte, addresses outside of memory read as 0.
+  int high = p_address >= 0 && p_address < MEMORY_SIZE ? memory[p_address] : 0;
+  int low = p_address + 1 >= 0 && p_address + 1 < MEMORY_SIZE ? memory[p_address + 1] : 0;
+  return (high << 8) | low;
+}
+
+void LockstepEmu::Step() {
+  uint32_t active = lane_mask_ & ~waiting_mask_;
+  int leader = first_lane(active);
+  uint16_t leader_opcode = Fetch(leader, program_counter_[leader]);
+
+  // Fetch every lane's opcode and move the program counters of the running lanes past it. The loop
+  // runs over every lane so it never branches on the lane mask. Most of the time the lanes agree, 
+  // so the lanes that fetched the same opcode as the first running lane are collected on the way.
+  uint16_t opcodes[MAX_LANES];
+  uint32_t group = 0;
+  for (int lane = 0; lane < lanes_; lane++) {
+    int pc = program_counter_[lane];
+    uint16_t opcode = Fetch(lane, pc);
+    opcodes[lane] = opcode;
+    group |= (uint32_t)(opcode == leader_opcode) << lane;
+    program_counter_[lane] = pc + (((active >> lane) & 1) << 1);
+  }
+  group &= active;
+  ExecuteGroupOrLane(dispatch_table_[leader_opcode].instruction, group);
+  stats_.groups++;
+  active &= ~group;
+
+  // The lanes that went their own way are grouped by opcode. A handful of lanes are simply 
+  // compared with each other, more go through a small hash table of opcodes.
+  if (active != 0 && count_lanes(active) <= SMALL_REMAINDER) {
+    while (active != 0) {
+      uint16_t opcode = opcodes[first_lane(active)];
+      group = 0;
+      for (uint32_t lanes = active; lanes != 0; lanes &= lanes - 1) {
+        int lane = first_lane(lanes);
+        group |= (uint32_t)(opcodes[lane] == opcode) << lane;
+      }
+      ExecuteGroupOrLane(dispatch_table_[opcode].instruction, group);
+      stats_.groups++;
+      active &= ~group;
+    }
+  } else if (active != 0) {
+    uint16_t slot_opcodes[GROUP_SLOTS];
+    uint8_t slots[MAX_LANES];
+    int slot_count = 0;
+    for (uint32_t lanes = active; lanes != 0; lanes &= lanes - 1) {
+      int lane = first_lane(lanes);
+      uint16_t opcode = opcodes[lane];
+      int slot = (opcode ^ (opcode >> 7)) & (GROUP_SLOTS - 1);
+      while (slot_lanes_[slot] != 0 && slot_opcodes[slot] != opcode) {
+        slot = (slot + 1) & (GROUP_SLOTS - 1);
+      }
+      if (slot_lanes_[slot] == 0) {
+        slot_opcodes[slot] = opcode;
+        slots[slot_count++] = slot;
+      }
+      slot_lanes_[slot] |= 1u << lane;
+    }
+
+    // Run the groups in the order they were found, emptying the table again on the way.
+    for (int i = 0; i < slot_count; i++) {
+      int slot = slots[i];
+      ExecuteGroupOrLane(dispatch_table_[slot_opcodes[slot]].instruction, slot_lanes_[slot]);
+      slot_lanes_[slot] = 0;
+    }
+    stats_.groups += slot_count;
+  }
+}
+
+void LockstepEmu::RunLanes(int p_count) {
+  long long executed = 0;
+  for (uint32_t lanes = lane_mask_ & ~waiting_mask_; lanes != 0; lanes &= lanes - 1) {
+    int lane = first_lane(lanes);
+    uint32_t bit = 1u << lane;
+    for (int i = 0; i < p_count && !(waiting_mask_ & bit); i++) {
+      int pc = program_counter_[lane];
+      uint16_t opcode = Fetch(lane, pc);
+      program_counter_[lane] = pc + 2;
+      ExecuteLane(dispatch_table_[opcode].instruction, lane);
+      executed++;
+    }
+  }
+  stats_.lane_instructions += executed;
+  stats_.groups += executed;
+  stats_.scalar_instructions += executed;
+}
+
+bool LockstepEmu::LanesConverged() const {
+  int program_counters[MAX_LANES];
+  int distinct = 0;
+  int running = 0;
+  for (uint32_t lanes = lane_mask_ & ~waiting_mask_; lanes != 0; lanes &= lanes - 1) {
+    int pc = program_counter_[first_lane(lanes)];
+    running++;
+    if (std::find(program_counters, program_counters + distinct, pc) 
+        == program_counters + distinct) {
+      program_counters[distinct++] = pc;
+    }
+  }
+  return running >= BREAK_EVEN_LANES * distinct;
+}
+
+inline void LockstepEmu::ExecuteGroupOrLane(const Instruction& p_instruction, uint32_t p_lanes) {
+  // Groups of a single lane are cheaper to run on their own than through vectors.
+  if ((p_lanes & (p_lanes - 1)) == 0) {
+    ExecuteLane(p_instruction, first_lane(p_lanes));
+  } else {
+    ExecuteGroup(p_instruction, p_lanes);
+  }
+}
+
+void LockstepEmu::ExecuteGroup(const Instruction& p_instruction, uint32_t p_lanes) {
+  uint8_t* vx = registers_[p_instruction.x];
+  uint8_t* vy = registers_[p_instruction.y];
+  uint8_t* vf = registers_[0xF];
+  uint8_t nn = p_instruction.nn;
+
+  // Both operands are loaded before anything is stored, and flags are written before or after the 
+  // result in the same order as Emu, which decides what VF ends up holding when x is F.
+  switch (p_instruction.type) {
+    case OP_SET_REGISTER: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, (LaneVector){} + nn, p_mask);
+      });
+      break;
+    }
+    case OP_ADD_VALUE: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(vx + p_first) + nn, p_mask);
+      });
+      break;
+    }
+    case OP_COPY_REGISTER: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(vy + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_OR: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(vx + p_first) | load_lanes(vy + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_AND: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(vx + p_first) & load_lanes(vy + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_XOR: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(vx + p_first) ^ load_lanes(vy + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_ADD_REGISTERS: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector x = load_lanes(vx + p_first);
+        LaneVector sum = x + load_lanes(vy + p_first);
+        blend_lanes(vx + p_first, sum, p_mask);
+        blend_lanes(vf + p_first, (LaneVector)(sum < x) & 1, p_mask);
+      });
+      break;
+    }
+    case OP_SUBTRACT: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector x = load_lanes(vx + p_first);
+        LaneVector y = load_lanes(vy + p_first);
+        blend_lanes(vf + p_first, (LaneVector)(x >= y) & 1, p_mask);
+        blend_lanes(vx + p_first, x - y, p_mask);
+      });
+      break;
+    }
+    case OP_SUBTRACT_REVERSE: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector x = load_lanes(vx + p_first);
+        LaneVector y = load_lanes(vy + p_first);
+        blend_lanes(vf + p_first, (LaneVector)(y >= x) & 1, p_mask);
+        blend_lanes(vx + p_first, y - x, p_mask);
+      });
+      break;
+    }
+    case OP_SHIFT_RIGHT: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector y = load_lanes(vy + p_first);
+        blend_lanes(vf + p_first, y & 1, p_mask);
+        blend_lanes(vx + p_first, y >> 1, p_mask);
+      });
+      break;
+    }
+    case OP_SHIFT_LEFT: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector y = load_lanes(vy + p_first);
+        blend_lanes(vf + p_first, y & 1, p_mask);
+        blend_lanes(vx + p_first, y + y, p_mask);
+      });
+      break;
+    }
+    case OP_GET_DELAY: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(vx + p_first, load_lanes(delay_timer_ + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_SET_DELAY: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(delay_timer_ + p_first, load_lanes(vx + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_SET_SOUND: {
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        blend_lanes(sound_timer_ + p_first, load_lanes(vx + p_first), p_mask);
+      });
+      break;
+    }
+    case OP_JUMP: {
+      for (int lane = 0; lane < lanes_; lane++) {
+        program_counter_[lane] = (p_lanes >> lane) & 1 ? p_instruction.nnn : program_counter_[lane];
+      }
+      break;
+    }
+    case OP_SET_INDEX: {
+      for (uint32_t lanes = p_lanes; lanes != 0; lanes &= lanes - 1) {
+        index_register_[first_lane(lanes)] = p_instruction.nnn;
+      }
+      break;
+    }
+    case OP_SKIP_EQUAL:
+    case OP_SKIP_NOT_EQUAL:
+    case OP_SKIP_REGISTERS_EQUAL:
+    case OP_SKIP_REGISTERS_NOT_EQUAL: {
+      // Compare whole chunks at once, then only move the program counters of the lanes that skip.
+      bool immediate = p_instruction.type == OP_SKIP_EQUAL 
+        || p_instruction.type == OP_SKIP_NOT_EQUAL;
+      bool equal = p_instruction.type == OP_SKIP_EQUAL 
+        || p_instruction.type == OP_SKIP_REGISTERS_EQUAL;
+      uint8_t skips[MAX_LANES];
+      for_each_chunk(p_lanes, [&](int p_first, const LaneVector& p_mask) {
+        LaneVector x = load_lanes(vx + p_first);
+        LaneVector other = immediate ? (LaneVector){} + nn : load_lanes(vy + p_first);
+        LaneVector skip = (LaneVector)(x == other);
+        store_lanes(skips + p_first, equal ? skip : ~skip);
+      });
+      for (uint32_t lanes = p_lanes; lanes != 0; lanes &= lanes - 1) {
+        int lane = first_lane(lanes);
+        program_counter_[lane] += skips[lane] & 2;
+      }
+      break;
+    }
+    default: {
+      for (uint32_t lanes = p_lanes; lanes != 0; lanes &= lanes - 1) {
+        ExecuteLane(p_instruction, first_lane(lanes));
+      }
+      break;
+    }
+  }
+}
+
+inline void LockstepEmu::ExecuteLane(const Instruction& p_instruction, int p_lane) {
+  uint8_t* memory = LaneMemory(p_lane);
+  int& pc = program_counter_[p_lane];
+  uint16_t& index = index_register_[p_lane];
+  int x = registers_[p_instruction.x][p_lane];
+
+  uint8_t& vx = registers_[p_instruction.x][p_lane];
+  uint8_t& vf = registers_[0xF][p_lane];
+  int y = registers_[p_instruction.y][p_lane];
+
+  switch (p_instruction.type) {
+    case OP_JUMP: {
+      pc = p_instruction.nnn;
+      break;
+    }
+    case OP_SKIP_EQUAL: {
+      pc += x == p_instruction.nn ? 2 : 0;
+      break;
+    }
+    case OP_SKIP_NOT_EQUAL: {
+      pc += x != p_instruction.nn ? 2 : 0;
+      break;
+    }
+    case OP_SKIP_REGISTERS_EQUAL: {
+      pc += x == y ? 2 : 0;
+      break;
+    }
+    case OP_SKIP_REGISTERS_NOT_EQUAL: {
+      pc += x != y ? 2 : 0;
+      break;
+    }
+    case OP_SET_REGISTER: {
+      vx = p_instruction.nn;
+      break;
+    }
+    case OP_ADD_VALUE: {
+      vx = x + p_instruction.nn;
+      break;
+    }
+    case OP_COPY_REGISTER: {
+      vx = y;
+      break;
+    }
+    case OP_OR: {
+      vx = x | y;
+      break;
+    }
+    case OP_AND: {
+      vx = x & y;
+      break;
+    }
+    case OP_XOR: {
+      vx = x ^ y;
+      break;
+    }
+    case OP_ADD_REGISTERS: {
+      vx = x + y;
+      vf = x + y > 0xFF ? 1 : 0;
+      break;
+    }
+    case OP_SUBTRACT: {
+      vf = x >= y ? 1 : 0;
+      vx = x - y;
+      break;
+    }
+    case OP_SUBTRACT_REVERSE: {
+      vf = y >= x ? 1 : 0;
+      vx = y - x;
+      break;
+    }
+    case OP_SHIFT_RIGHT: {
+      vf = y & 1;
+      vx = y >> 1;
+      break;
+    }
+    case OP_SHIFT_LEFT: {
+      vf = y & 1;
+      vx = y << 1;
+      break;
+    }
+    case OP_SET_INDEX: {
+      index = p_instruction.nnn;
+      break;
+    }
+    case OP_GET_DELAY: {
+      vx = delay_timer_[p_lane];
+      break;
+    }
+    case OP_SET_DELAY: {
+      delay_timer_[p_lane] = x;
+      break;
+    }
+    case OP_SET_SOUND: {
+      sound_timer_[p_lane] = x;
+      break;
+    }
+    case OP_CLEAR_SCREEN: {
+      displays_[p_lane].Clear();
+      break;
+    }
+    case OP_RETURN: {
+      if (stack_size_[p_lane] != 0) {
+        pc = stack_[p_lane][--stack_size_[p_lane]];
+      }
+      break;
+    }
+    case OP_CALL: {
+      if (p_instruction.nnn % 2 == 0 && stack_size_[p_lane] < STACK_SIZE) {
+        stack_[p_lane][stack_size_[p_lane]++] = pc;
+        pc = p_instruction.nnn;
+      }
+      break;
+    }
+    case OP_JUMP_OFFSET: {
+      pc = registers_[0][p_lane] + p_instruction.nnn;
+      break;
+    }
+    case OP_RANDOM: {
+      random_state_[p_lane] = random_state_[p_lane] * 1664525u + 1013904223u;
+      vx = (random_state_[p_lane] >> 24) & p_instruction.nn;
+      break;
+    }
+    case OP_DRAW: {
+      // Same as Emu::DisplaySprite, sprites running off the end of memory are padded with zeros.
+      int rows = p_instruction.n;
+      const uint8_t* sprite = memory + index;
+      uint8_t padded_sprite[16] = { 0 };
+      if (index + rows > MEMORY_SIZE) {
+        for (int i = 0; i < rows; i++) {
+          padded_sprite[i] = index + i < MEMORY_SIZE ? memory[index + i] : 0;
+        }
+        sprite = padded_sprite;
+      }
+      bool collision = displays_[p_lane].DrawSprite(x, y, sprite, rows);
+      vf = collision ? 1 : 0;
+      break;
+    }
+    case OP_SKIP_KEY_PRESSED: {
+      if (x <= 0xF && (keys_[p_lane] >> x) & 1) {
+        pc += 2;
+      }
+      break;
+    }
+    case OP_SKIP_KEY_NOT_PRESSED: {
+      if (x <= 0xF && !((keys_[p_lane] >> x) & 1)) {
+        pc += 2;
+      }
+      break;
+    }
+    case OP_WAIT_KEY: {
+      pc -= 2;
+      waiting_mask_ |= 1u << p_lane;
+      wait_register_[p_lane] = p_instruction.x;
+      break;
+    }
+    case OP_ADD_INDEX: {
+      index += x;
+      break;
+    }
+    case OP_SET_SPRITE: {
+      if (x <= 0xF) {
+        index = 0x50 + x * 5;
+      }
+      break;
+    }
+    case OP_STORE_BCD: {
+      const uint8_t digits[] = { 
+        static_cast<uint8_t>(x / 100), static_cast<uint8_t>((x / 10) % 10), 
+        static_cast<uint8_t>(x % 10) 
+      };
+      for (int i = 0; i < 3 && index + i < MEMORY_SIZE; i++) {
+        memory[index + i] = digits[i];
+      }
+      break;
+    }
+    case OP_STORE_REGISTERS: {
+      for (int i = 0; i <= p_instruction.x && index + i < MEMORY_SIZE; i++) {
+        memory[index + i] = registers_[i][p_lane];
+      }
+      index += p_instruction.x + 1;
+      break;
+    }
+    case OP_READ_REGISTERS: {
+      for (int i = 0; i <= p_instruction.x; i++) {
+        registers_[i][p_lane] = index + i < MEMORY_SIZE ? memory[index + i] : 0;
+      }
+      index += p_instruction.x + 1;
+      break;
+    }
+    default: {
+      // Unknown opcodes do nothing. Emu prints a message for them, lanes stay quiet.
+      break;
+    }
+  }
+}
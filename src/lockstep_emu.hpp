@@ -0,0 +1,301 @@
+#ifndef LOCKSTEP_EMU_HPP
+#define LOCKSTEP_EMU_HPP
+
+#include "dispatch_table.hpp"
+#include "display.hpp"
+#include "save_state.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Counters describing how well the lanes of a LockstepEmu stay together.
+ */
+struct LockstepStats {
+  /**
+   * Instructions executed, summed over all lanes.
+   */
+  long long lane_instructions;
+
+  /**
+   * Groups of lanes that executed an opcode together. lane_instructions / groups is the average 
+   * number of lanes sharing each opcode.
+   */
+  long long groups;
+
+  /**
+   * Instructions executed lane by lane, without grouping, while the lanes were too far apart for 
+   * grouping to pay off. Each one also counts as a group of one lane.
+   */
+  long long scalar_instructions;
+};
+
+/**
+ * Runs up to 32 Chip-8 machines side by side, for workloads that step many copies of a program 
+ * with different seeds or input. The machine state is stored as a structure of arrays, so the 
+ * value of a register across all lanes sits in one 32 byte row. Every step the lanes are grouped 
+ * by the opcode they fetched, and each group is executed once: register and timer instructions 
+ * update the whole row with vector operations under a lane mask, everything else runs lane by lane
+ * for the lanes in the group. Lanes that branch differently simply end up in different groups.
+ * Once the lanes have drifted so far apart that the groups average fewer than BREAK_EVEN_LANES 
+ * lanes, grouping costs more than it saves, so every lane runs on its own through the same scalar 
+ * code until the lanes come back together.
+ *
+ * The vector operations use GCC vector extensions. Built with -mavx2 each row is a single AVX2 
+ * register, on plain x86-64 it is a pair of SSE2 registers, and other targets use whatever 16 byte
+ * vectors they have. Every lane behaves exactly like an Emu running the same program with the same seed and 
+ * input, and its state can be saved and loaded in the same EmuState format.
+ */
+class LockstepEmu {
+
+public:
+
+  /**
+   * The most lanes a LockstepEmu can run.
+   */
+  const static int MAX_LANES = 32;
+
+  /**
+   * Average lanes per group below which running each lane on its own is faster than grouping.
+   */
+  const static int BREAK_EVEN_LANES = 4;
+
+  /**
+   * Creates p_lanes lanes (clamped to 1 -> MAX_LANES), each set up like a freshly constructed Emu.
+   */
+  explicit LockstepEmu(int p_lanes);
+
+  /**
+   * Returns the number of lanes.
+   */
+  int get_lane_count() const;
+
+  /**
+   * Copies the p_length byte rom image p_rom into the memory of every lane starting at 0x200. 
+   * Returns the number of bytes that fit into memory.
+   */
+  int LoadRom(const uint8_t* p_rom, int p_length);
+
+  /**
+   * Restarts the random number generator of lane p_lane from p_seed, like Emu::set_random_seed.
+   */
+  void set_random_seed(int p_lane, uint32_t p_seed);
+
+  /**
+   * Presses keypad key p_key on lane p_lane, completing a pending Fx0A like Emu::KeyDown.
+   */
+  void KeyDown(int p_lane, int p_key);
+
+  /**
+   * Releases keypad key p_key on lane p_lane.
+   */
+  void KeyUp(int p_lane, int p_key);
+
+  /**
+   * Executes p_count instructions on every lane that is not waiting on Fx0A.
+   */
+  void ExecuteBatch(int p_count);
+
+  /**
+   * Runs one 60hz frame on every lane: p_instructions_per_frame instructions followed by a tick of
+   * the delay and sound timers, the same as Emu::RunFrame.
+   */
+  void RunFrame(int p_instructions_per_frame);
+
+  /**
+   * Copies the state of lane p_lane into p_state. The timer scheduler fields describe the default 
+   * clock, which is the one RunFrame runs at.
+   */
+  void SaveState(int p_lane, EmuState& p_state);
+
+  /**
+   * Puts lane p_lane into the state saved in p_state. Returns false and changes nothing if p_state
+   * was saved with a different layout version or holds values no emulator could be in. The timer 
+   * scheduler fields are ignored.
+   */
+  bool LoadState(int p_lane, const EmuState& p_state);
+
+  /**
+   * Returns the value of variable register p_register of lane p_lane.
+   */
+  int get_register(int p_lane, int p_register) const;
+
+  /**
+   * Returns the program counter of lane p_lane.
+   */
+  int get_program_counter(int p_lane) const;
+
+  /**
+   * Returns the display of lane p_lane.
+   */
+  const Display& get_display(int p_lane) const;
+
+  /**
+   * Returns true while lane p_lane is suspended on Fx0A.
+   */
+  bool is_waiting_for_key(int p_lane) const;
+
+  /**
+   * Returns the lane and group counters.
+   */
+  LockstepStats get_stats() const;
+
+private:
+
+  const static int MEMORY_SIZE = 4096;
+
+  /**
+   * Distance between the memories of neighbouring lanes. The extra cache line keeps the lanes' 
+   * copies of the same address out of the same cache set, so fetching one address on every lane 
+   * does not evict itself.
+   */
+  const static int MEMORY_STRIDE = MEMORY_SIZE + 64;
+
+  const static int STACK_SIZE = EmuState::STACK_SIZE;
+
+  /**
+   * Size of the hash table Step groups diverged lanes with, twice the lanes so probes stay short.
+   */
+  const static int GROUP_SLOTS = 2 * MAX_LANES;
+
+  /**
+   * Up to this many diverged lanes are grouped by comparing them with each other instead.
+   */
+  const static int SMALL_REMAINDER = 6;
+
+  /**
+   * Steps grouped lanes run before the lanes per group are checked against BREAK_EVEN_LANES.
+   */
+  const static int WINDOW_STEPS = 64;
+
+  /**
+   * Instructions every lane runs on its own before checking whether the lanes came back together.
+   */
+  const static int CHECK_INTERVAL = 256;
+
+  int lanes_;
+
+  /**
+   * One bit per lane that exists.
+   */
+  uint32_t lane_mask_;
+
+  /**
+   * One bit per lane suspended on Fx0A.
+   */
+  uint32_t waiting_mask_;
+
+  /**
+   * Variable registers, registers_[x][lane] is Vx of lane.
+   */
+  alignas(32) uint8_t registers_[16][MAX_LANES];
+
+  alignas(32) uint8_t delay_timer_[MAX_LANES];
+
+  alignas(32) uint8_t sound_timer_[MAX_LANES];
+
+  /**
+   * Kept as int like Emu::program_counter_, so running off the end of memory behaves the same.
+   */
+  int program_counter_[MAX_LANES];
+
+  uint16_t index_register_[MAX_LANES];
+
+  uint32_t random_state_[MAX_LANES];
+
+  /**
+   * Key states of each lane, key n in bit n.
+   */
+  uint16_t keys_[MAX_LANES];
+
+  uint8_t wait_register_[MAX_LANES];
+
+  uint16_t stack_[MAX_LANES][STACK_SIZE];
+
+  uint8_t stack_size_[MAX_LANES];
+
+  /**
+   * The memory of every lane, MEMORY_SIZE bytes each, MEMORY_STRIDE bytes apart.
+   */
+  std::vector<uint8_t> memory_;
+
+  std::vector<Display> displays_;
+
+  /**
+   * Instruction cycles counted by RunFrame, the same for every lane.
+   */
+  long long cycle_count_;
+
+  LockstepStats stats_;
+
+  /**
+   * True while lanes are grouped by opcode, false while every lane runs on its own.
+   */
+  bool grouping_;
+
+  /**
+   * Steps, lane instructions and groups in the current window of grouped steps.
+   */
+  int window_steps_;
+  int window_lanes_;
+  int window_groups_;
+
+  /**
+   * Instructions each lane has run on its own since the last check for lanes coming together.
+   */
+  int scalar_steps_;
+
+  /**
+   * The lanes in each slot of Step's hash table, all 0 outside of Step.
+   */
+  uint32_t slot_lanes_[GROUP_SLOTS];
+
+  const DispatchEntry* dispatch_table_;
+
+  /**
+   * Returns the memory of lane p_lane.
+   */
+  uint8_t* LaneMemory(int p_lane);
+
+  /**
+   * Reads the opcode at p_address in the memory of lane p_lane, the same way Emu::Fetch does.
+   */
+  uint16_t Fetch(int p_lane, int p_address);
+
+  /**
+   * Executes one instruction on every lane that is not waiting on Fx0A.
+   */
+  void Step();
+
+  /**
+   * Executes p_count instructions on every lane that is not waiting on Fx0A, one lane after the 
+   * other without grouping. A lane stops early once it starts waiting on Fx0A.
+   */
+  void RunLanes(int p_count);
+
+  /**
+   * Returns true if the running lanes share few enough program counters that grouping them would 
+   * pay off again.
+   */
+  bool LanesConverged() const;
+
+  /**
+   * Executes p_instruction on the lanes in p_lanes through ExecuteLane if there is only one of them,
+   * otherwise through ExecuteGroup.
+   */
+  void ExecuteGroupOrLane(const Instruction& p_instruction, uint32_t p_lanes);
+
+  /**
+   * Executes p_instruction on every lane in p_lanes, whose program counters have already been 
+   * moved past it.
+   */
+  void ExecuteGroup(const Instruction& p_instruction, uint32_t p_lanes);
+
+  /**
+   * Executes p_instruction on the single lane p_lane. Used for groups of one lane and for the 
+   * instructions that touch memory, the stack, the display or the keys.
+   */
+  void ExecuteLane(const Instruction& p_instruction, int p_lane);
+};
+
+#endif
@@ -1,11 +1,17 @@
 // Trent Julich ~ 23 March 2021
 
+#include "debugger.hpp"
 #include "emu.hpp"
-#include "keyboard_input.hpp"
 #include "emulator_panel.hpp"
 #include "pc_panel.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "rewind_buffer.hpp"
+#include "sdl_frontend.hpp"
 #include "var_register_panel.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <SDL.h>
@@ -15,6 +21,19 @@
 
 const int PIXEL_SIZE = 10;
 
+// Default instructions run per 60hz frame, the same 540hz clock the emulator uses by default.
+const int INSTRUCTIONS_PER_FRAME = Emu::DEFAULT_CLOCK_SPEED / Emu::TIMER_FREQUENCY;
+
+// Default number of frames that may be emulated without being presented when the host falls behind.
+const int MAX_FRAME_SKIP = 5;
+
+// Default number of seconds of play kept for rewinding.
+const int REWIND_SECONDS = 10;
+
+// Bytes of rewind history budgeted per frame. Frames are stored as deltas that average well below
+// this, with a whole 4kB keyframe once a second.
+const int REWIND_BYTES_PER_FRAME = 512;
+
 const int REGISTER_WIDTH = 200;
 const int PROGRAM_COUNTER_HEIGHT = 50;
 const int EMULATOR_WIDTH = 64*PIXEL_SIZE;
@@ -23,34 +42,147 @@ const int EMULATOR_HEIGHT = 32*PIXEL_SIZE;
 const int WINDOW_HEIGHT = EMULATOR_HEIGHT + PROGRAM_COUNTER_HEIGHT;
 const int WINDOW_WIDTH = EMULATOR_WIDTH + REGISTER_WIDTH; 
 
-static Uint32 sound_timer_callback(Uint32 p_interval, void* p_param);
-static Uint32 delay_timer_callback(Uint32 p_interval, void* p_param);
-static Uint32 step_timer_callback(Uint32 p_interval, void* p_param);
+/**
+ * Settings read from the command line.
+ */
+struct EmulatorOptions {
+  std::string input_file;
+  int instructions_per_frame = INSTRUCTIONS_PER_FRAME;
+  int max_frame_skip = MAX_FRAME_SKIP;
+  bool vsync = false;
+  int rewind_seconds = REWIND_SECONDS;
+  std::string record_file;
+  std::string profile_file;
+  std::string flamegraph_file;
+  std::string trace_file;
+  bool trace_memory_map = false;
+  bool debug = false;
+  std::vector<int> breakpoints;
+  std::vector<std::string> watchpoints;
+  std::vector<int> watched_registers;
+};
+
+const char* USAGE = "chip-8 -i <filename> [-f <instructions per frame>] [-s <max frame skip>] [-vsync] "
+  "[-rewind <seconds>] [-record <replay file>] [-profile <report file>] "
+  "[-flamegraph <collapsed stack file>] [-trace <trace file>] [-trace-mmap] [-debug] "
+  "[-break <address>] [-watch <address>[-<address>][:r|w|rw]] [-watch-reg <register>]";
+
 bool init_sdl();
 
 /**
- * Looks for input file flag in argv, and if found, stores the input file path in the input_file 
- * string.
+ * Looks for input file flag in argv, and if found, stores the input file path in p_options along
+ * with the optional frame pacing flags. Returns false if there is no input file or the flags can not
+ * be used together.
  */
-bool parse_args(int p_argc, char* p_argv[], std::string& p_input_file) {
+bool parse_args(int p_argc, char* p_argv[], EmulatorOptions& p_options) {
   bool rom_found = true;
 
-  // Check for input file flag ("-i") from command line
   for (int i = 0; i < p_argc; i++) {
-    if ((std::string(p_argv[i]) == "-i") && (i + 1 < p_argc)) {
-      p_input_file = p_argv[i+1];
-      break;
+    std::string arg(p_argv[i]);
+    if ((arg == "-i") && (i + 1 < p_argc)) {
+      // Input file flag.
+      p_options.input_file = p_argv[++i];
+    } else if ((arg == "-f") && (i + 1 < p_argc)) {
+      p_options.instructions_per_frame = std::max(1, std::atoi(p_argv[++i]));
+    } else if ((arg == "-s") && (i + 1 < p_argc)) {
+      p_options.max_frame_skip = std::max(0, std::atoi(p_argv[++i]));
+    } else if (arg == "-vsync") {
+      p_options.vsync = true;
+    } else if ((arg == "-rewind") && (i + 1 < p_argc)) {
+      p_options.rewind_seconds = std::max(0, std::atoi(p_argv[++i]));
+    } else if ((arg == "-record") && (i + 1 < p_argc)) {
+      p_options.record_file = p_argv[++i];
+    } else if ((arg == "-profile") && (i + 1 < p_argc)) {
+      p_options.profile_file = p_argv[++i];
+    } else if ((arg == "-flamegraph") && (i + 1 < p_argc)) {
+      p_options.flamegraph_file = p_argv[++i];
+    } else if ((arg == "-trace") && (i + 1 < p_argc)) {
+      p_options.trace_file = p_argv[++i];
+    } else if (arg == "-trace-mmap") {
+      p_options.trace_memory_map = true;
+    } else if (arg == "-debug") {
+      p_options.debug = true;
+    } else if ((arg == "-break") && (i + 1 < p_argc)) {
+      p_options.breakpoints.push_back(std::strtol(p_argv[++i], nullptr, 16));
+      p_options.debug = true;
+    } else if ((arg == "-watch") && (i + 1 < p_argc)) {
+      p_options.watchpoints.push_back(p_argv[++i]);
+      p_options.debug = true;
+    } else if ((arg == "-watch-reg") && (i + 1 < p_argc)) {
+      p_options.watched_registers.push_back(std::strtol(p_argv[++i], nullptr, 16));
+      p_options.debug = true;
     }
   }
 
-  if (p_input_file.empty()) {
-    std::cout << "chip-8 -i <filename>" << std::endl;
+  if (p_options.input_file.empty()) {
+    std::cout << USAGE << std::endl;
+    rom_found = false;
+  }
+
+  // Debugger steps and stops part way through a frame change the state outside the whole frames a
+  // replay is made of, so a debugged run could not be played back the same.
+  if (!p_options.record_file.empty() && p_options.debug) {
+    std::cout << "-record can not be combined with -debug, -break, -watch or -watch-reg" 
+      << std::endl;
     rom_found = false;
   }
 
+#ifndef CHIP8_PROFILE
+  if (!p_options.profile_file.empty() || !p_options.flamegraph_file.empty()) {
+    std::cout << "Built without the profiler, rebuild with make PROFILE_FLAGS=-DCHIP8_PROFILE to " 
+      "use -profile and -flamegraph" << std::endl;
+  }
+#endif
+
   return rom_found;
 }
 
+/**
+ * Writes the report and collapsed stacks of p_profiler to the files named in p_options, if any.
+ */
+void write_profile(Profiler& p_profiler, const EmulatorOptions& p_options) {
+  if (!p_options.profile_file.empty()) {
+    std::ofstream report(p_options.profile_file);
+    p_profiler.WriteReport(report);
+    if (!report) {
+      std::cout << "Unable to write profile " << p_options.profile_file << std::endl;
+    }
+  }
+  if (!p_options.flamegraph_file.empty()) {
+    std::ofstream collapsed(p_options.flamegraph_file);
+    p_profiler.WriteCollapsed(collapsed);
+    if (!collapsed) {
+      std::cout << "Unable to write profile " << p_options.flamegraph_file << std::endl;
+    }
+  }
+}
+
+/**
+ * Sets up p_debugger with the breakpoints, watchpoints and register triggers in p_options. 
+ * Watchpoints are written <address>[-<address>][:r|w|rw] in hex, watching reads and writes when 
+ * no access is given.
+ */
+void setup_debugger(Debugger& p_debugger, const EmulatorOptions& p_options) {
+  for (int address : p_options.breakpoints) {
+    p_debugger.SetBreakpoint(address, true);
+  }
+  for (const std::string& watchpoint : p_options.watchpoints) {
+    char* end = nullptr;
+    int first = std::strtol(watchpoint.c_str(), &end, 16);
+    int last = *end == '-' ? std::strtol(end + 1, &end, 16) : first;
+    uint8_t flags = Debugger::WATCH_READ | Debugger::WATCH_WRITE;
+    if (*end == ':') {
+      std::string access(end + 1);
+      flags = (access.find('r') != std::string::npos ? Debugger::WATCH_READ : 0)
+        | (access.find('w') != std::string::npos ? Debugger::WATCH_WRITE : 0);
+    }
+    p_debugger.SetWatchpoint(first, last, flags);
+  }
+  for (int watched : p_options.watched_registers) {
+    p_debugger.WatchRegister(watched, true);
+  }
+}
+
 /**
  * Takes the given ifstream and returns the length in bytes.
  */
@@ -68,27 +200,87 @@ int find_rom_length(std::ifstream& p_rom_buffer) {
 }
 
 /**
- * Loads each byte from p_rom_buffer into the virtual memory of p_emu.
+ * Reads the whole of p_rom_buffer in one go and copies it into the virtual memory of p_emu. 
+ * Returns the bytes that were read.
  */
-void load_rom(Emu* p_emu, std::ifstream& p_rom_buffer, int p_rom_length) {
-  int address_start = 0x200;
+std::vector<uint8_t> load_rom(Emu* p_emu, std::ifstream& p_rom_buffer, int p_rom_length) {
+  std::vector<uint8_t> rom(p_rom_length);
+  p_rom_buffer.read(reinterpret_cast<char*>(rom.data()), p_rom_length);
+  rom.resize(p_rom_buffer.gcount());
 
-  for (int i = 0; i < p_rom_length; i++) {
-    p_emu->set_memory(address_start + i, p_rom_buffer.get());
-  }
+  p_emu->LoadRom(rom.data(), rom.size());
 
   p_rom_buffer.close();
+  return rom;
 }
 
 /**
- * Called to start emulation of the selected rom. Also registers emulator for timing events for 
- * the delay counter, sound timer, and main execution loop timing. 
+ * Handles all pending SDL events. p_rewinding is set while the rewind key (backspace) is held. Keys
+ * go through p_recorder when the run is being recorded, or straight to p_emu when it is null. When
+ * debugging, F5 pauses and resumes p_debugger and F10 steps a single instruction. Returns false 
+ * once the window has been closed.
  */
-void start_emulator(Emu* p_emu, SDL_Renderer* p_renderer, FontAtlas* p_font_atlas) {
-  SDL_AddTimer(1000 / 60, delay_timer_callback, p_emu);
-  SDL_AddTimer(1000 / 60, sound_timer_callback, p_emu);
-  SDL_AddTimer(2, step_timer_callback, p_emu);
+bool handle_events(Emu* p_emu, ReplayRecorder* p_recorder, Debugger* p_debugger, 
+                   bool& p_rewinding) {
+  bool running = true;
+  SDL_Event e;
+  while(SDL_PollEvent(&e)) {
+    switch (e.type) {
+      case SDL_QUIT: {
+        running = false;
+        break;
+      }
+      case SDL_KEYDOWN: {
+        if (e.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+          p_rewinding = true;
+        }
+        if (p_debugger && e.key.keysym.scancode == SDL_SCANCODE_F5) {
+          if (p_debugger->is_paused()) {
+            p_debugger->Resume();
+          } else {
+            p_debugger->Pause(p_emu->get_program_counter());
+          }
+        } else if (p_debugger && e.key.keysym.scancode == SDL_SCANCODE_F10) {
+          // The step runs on its own, outside any frame, so the timers and rewind history hold.
+          p_debugger->StepInstruction();
+          p_emu->ExecuteBatch(1);
+        }
+        if (p_recorder) {
+          p_recorder->KeyDown(keypad_value(e.key.keysym.scancode));
+        } else {
+          p_emu->KeyDown(keypad_value(e.key.keysym.scancode));
+        }
+        break;
+      }
+      case SDL_KEYUP: {
+        if (e.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+          p_rewinding = false;
+        }
+        if (p_recorder) {
+          p_recorder->KeyUp(keypad_value(e.key.keysym.scancode));
+        } else {
+          p_emu->KeyUp(keypad_value(e.key.keysym.scancode));
+        }
+        break;
+      }
+    }
+  }
+  return running;
+}
 
+/**
+ * Called to start emulation of the selected rom. Runs a frame paced loop: every 1/60th of a second
+ * one frame of instructions is run, which also ticks the delay and sound timers, and then the 
+ * window is composited and presented once. When the host falls behind, up to max_frame_skip 
+ * frames are emulated without being presented, and anything beyond that is dropped. The state at 
+ * the start of every frame goes into a rewind buffer, and while the rewind key is held frames are 
+ * taken back out of it instead of being run, playing the program backwards. Key events are recorded
+ * into p_recorder unless it is null. While p_debugger is paused no frames are run, but events are 
+ * still handled and the panels drawn every frame, so the registers can be inspected.
+ */
+void start_emulator(Emu* p_emu, SDL_Renderer* p_renderer, FontAtlas* p_font_atlas, 
+                    const EmulatorOptions& p_options, ReplayRecorder* p_recorder,
+                    Debugger* p_debugger) {
   std::vector<Panel*> components;
   
   components.emplace_back(new EmulatorPanel(0, 0, EMULATOR_WIDTH, EMULATOR_HEIGHT, p_emu));
@@ -97,34 +289,78 @@ void start_emulator(Emu* p_emu, SDL_Renderer* p_renderer, FontAtlas* p_font_atla
   components.emplace_back(new ProgramCounterPanel(0, EMULATOR_HEIGHT, WINDOW_WIDTH, 
     PROGRAM_COUNTER_HEIGHT, p_font_atlas, p_emu));
 
+  Uint64 frequency = SDL_GetPerformanceFrequency();
+  Uint64 frame_length = frequency / Emu::TIMER_FREQUENCY;
+  Uint64 next_frame = SDL_GetPerformanceCounter();
+
+  int rewind_frames = p_options.rewind_seconds * Emu::TIMER_FREQUENCY;
+  RewindBuffer rewind_buffer(rewind_frames * REWIND_BYTES_PER_FRAME, rewind_frames);
+  EmuState state;
+
   bool running = true;
+  bool rewinding = false;
+  long long stop_count = 0;
 
   while (running) {
-    SDL_Event e;
-    while(SDL_PollEvent(&e)) {
-      switch (e.type) {
-        case SDL_QUIT: {
-          running = false;
-          break;
-        }
-        case SDL_USEREVENT: {
-          p_emu->HandleUserEvent(e);
-          SDL_SetRenderDrawColor(p_renderer, 0, 0, 0, 255);
-          SDL_RenderClear(p_renderer);
-          for (int i = 0; i < components.size(); i++) {
-            components[i]->Render(p_renderer);
+    running = handle_events(p_emu, p_recorder, p_debugger, rewinding);
+
+    // Run every frame that is due, up to the frame skip limit.
+    Uint64 now = SDL_GetPerformanceCounter();
+    int frames = 0;
+    while (now >= next_frame && frames <= p_options.max_frame_skip) {
+      if (rewinding) {
+        // Step back a frame, or stay put once the history runs out.
+        if (rewind_buffer.Pop(state)) {
+          p_emu->LoadState(state);
+          if (p_recorder) {
+            p_recorder->Rewind();
           }
-          p_emu->Render();
-          SDL_RenderPresent(p_renderer);
-          break;
         }
-        case SDL_KEYDOWN: {
-          p_emu->KeyDown(e.key.keysym.scancode);
-          break;
+      } else if (!p_debugger || !p_debugger->is_paused()) {
+        if (rewind_frames > 0) {
+          p_emu->SaveState(state);
+          rewind_buffer.Push(state);
         }
-        case SDL_KEYUP: {
-          p_emu->KeyUp(e.key.keysym.scancode);
-          break;
+        p_emu->RunFrame(p_options.instructions_per_frame);
+      }
+      next_frame += frame_length;
+      frames++;
+    }
+
+    if (p_debugger && p_debugger->get_stop_count() != stop_count) {
+      stop_count = p_debugger->get_stop_count();
+      std::cout << "Stopped: " << describe_stop(p_debugger->get_stop()) 
+        << " (F5 to resume, F10 to step)" << std::endl;
+    }
+
+    // Too far behind to catch up, so drop the missed frames instead of running them in a burst.
+    if (now >= next_frame) {
+      next_frame = now + frame_length;
+    }
+
+    if (frames > 0) {
+      SDL_SetRenderDrawColor(p_renderer, 0, 0, 0, 255);
+      SDL_RenderClear(p_renderer);
+      // The emulator panel renders the display itself.
+      for (int i = 0; i < components.size(); i++) {
+        components[i]->Render(p_renderer);
+      }
+      // With vsync this also waits for the display refresh.
+      SDL_RenderPresent(p_renderer);
+    }
+
+    if (!rewinding && p_emu->is_waiting_for_key() && p_emu->get_delay_timer() == 0 
+        && p_emu->get_sound_timer() == 0) {
+      // Nothing can change until a key is pressed, so sleep until input arrives.
+      SDL_WaitEvent(nullptr);
+      next_frame = SDL_GetPerformanceCounter();
+    } else {
+      // Sleep until the next frame is due, waking up early if input arrives.
+      now = SDL_GetPerformanceCounter();
+      if (next_frame > now) {
+        int milliseconds = (next_frame - now) * 1000 / frequency;
+        if (milliseconds > 0) {
+          SDL_WaitEventTimeout(nullptr, milliseconds);
         }
       }
     }
@@ -133,12 +369,12 @@ void start_emulator(Emu* p_emu, SDL_Renderer* p_renderer, FontAtlas* p_font_atla
 
 int main(int argc, char* argv[]) {
 
-  std::string input_file;
+  EmulatorOptions options;
 
   // If input file was provided
-  if (parse_args(argc, argv, input_file)) {
+  if (parse_args(argc, argv, options)) {
     // Attempt to open file stream.
-    std::ifstream input(input_file, std::ifstream::binary);
+    std::ifstream input(options.input_file, std::ifstream::binary);
 
     int length = find_rom_length(input);
 
@@ -148,17 +384,67 @@ int main(int argc, char* argv[]) {
           SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
 
         if (window) {
-          SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+          Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+          if (options.vsync) {
+            renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+          }
+          SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, renderer_flags);
 
           if (renderer) {
-            Emu* emu = new Emu(renderer);
+            SdlVideoOutput video_output(renderer, PIXEL_SIZE);
+            Emu* emu = new Emu(&video_output);
             std::string font_path = "../fonts/OpenSans-Regular.ttf";
             std::string characters = "0123456789abcdf Index:PV";
             FontAtlas* font_atlas = new FontAtlas(font_path, 24, characters, renderer);
 
-            load_rom(emu, input, length);
-
-            start_emulator(emu, renderer, font_atlas);
+            std::vector<uint8_t> rom = load_rom(emu, input, length);
+
+            // Frames are only ever run whole and timers follow the instruction count, so the key
+            // events stamped with their cycle are all a replay needs to repeat the run exactly.
+            ReplayRecorder* recorder = nullptr;
+            if (!options.record_file.empty()) {
+              recorder = new ReplayRecorder(emu, rom.data(), rom.size(), Emu::DEFAULT_RANDOM_SEED,
+                                            options.instructions_per_frame);
+            }
+
+#ifdef CHIP8_PROFILE
+            Profiler profiler;
+            emu->set_profiler(&profiler);
+#endif
+
+            TraceRecorder trace_recorder;
+            if (!options.trace_file.empty()) {
+              if (trace_recorder.Open(options.trace_file, options.trace_memory_map)) {
+                emu->set_trace_recorder(&trace_recorder);
+              } else {
+                std::cout << "Unable to create trace " << options.trace_file << std::endl;
+              }
+            }
+
+            // The debugger is only attached when asked for, so normal runs keep the fast engines.
+            Debugger debugger;
+            if (options.debug) {
+              setup_debugger(debugger, options);
+              emu->set_debugger(&debugger);
+            }
+
+            start_emulator(emu, renderer, font_atlas, options, recorder, 
+                           options.debug ? &debugger : nullptr);
+
+            if (!trace_recorder.Close()) {
+              std::cout << "Unable to write trace " << options.trace_file << std::endl;
+            }
+
+#ifdef CHIP8_PROFILE
+            write_profile(profiler, options);
+#endif
+
+            if (recorder) {
+              if (!write_replay_file(options.record_file, recorder->Finish())) {
+                std::cout << "Unable to write replay " << options.record_file << std::endl;
+              }
+              delete recorder;
+            }
       
             delete emu;
           } else {
@@ -172,7 +458,7 @@ int main(int argc, char* argv[]) {
       }
       SDL_Quit();
     } else {
-      std::cout << "chip-8 -i <filename>" << std::endl;
+      std::cout << USAGE << std::endl;
     }
   }
   return 0;
@@ -192,24 +478,3 @@ bool init_sdl() {
 
   return success;
 }
-
-Uint32 delay_timer_callback(Uint32 p_interval, void* param) {
-  // Cast the void pointer to a pointer to the emulator we are wanting to call DelayTick on.
-  Emu* emu = static_cast<Emu*>(param);
-  emu->DelayTick();
-  return p_interval;
-}
-
-Uint32 sound_timer_callback(Uint32 p_interval, void* param) {
-  // Cast the void pointer to a pointer to the emulator we are wanting to call DelayTick on.
-  Emu* emu = static_cast<Emu*>(param);
-  emu->SoundTick();
-  return p_interval;
-}
-
-Uint32 step_timer_callback(Uint32 p_interval, void* p_param) {
-  // Cast void pointer to a pointer to the emulator we are wanting to call Step on.
-  Emu* emu = static_cast<Emu*>(p_param);
-  emu->StepTick();
-  return p_interval;
-}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "opcode.hpp"
+
+Instruction decode_instruction(uint16_t p_opcode) {
+  Instruction instruction;
+  instruction.prefix = (p_opcode & 0xF000) >> 12;
+  instruction.x = (p_opcode & 0x0F00) >> 8;
+  instruction.y = (p_opcode & 0x00F0) >> 4;
+  instruction.n = p_opcode & 0x000F;
+  instruction.nn = p_opcode & 0x00FF;
+  instruction.nnn = p_opcode & 0x0FFF;
+  instruction.type = OP_UNKNOWN;
+
+  switch (instruction.prefix) {
+    case 0x0: {
+      if (p_opcode == 0x00E0) {
+        instruction.type = OP_CLEAR_SCREEN;
+      } else if (p_opcode == 0x00EE) {
+        instruction.type = OP_RETURN;
+      }
+      break;
+    }
+    case 0x1: {
+      instruction.type = OP_JUMP;
+      break;
+    }
+    case 0x2: {
+      instruction.type = OP_CALL;
+      break;
+    }
+    case 0x3: {
+      instruction.type = OP_SKIP_EQUAL;
+      break;
+    }
+    case 0x4: {
+      instruction.type = OP_SKIP_NOT_EQUAL;
+      break;
+    }
+    case 0x5: {
+      if (instruction.n == 0) {
+        instruction.type = OP_SKIP_REGISTERS_EQUAL;
+      }
+      break;
+    }
+    case 0x6: {
+      instruction.type = OP_SET_REGISTER;
+      break;
+    }
+    case 0x7: {
+      instruction.type = OP_ADD_VALUE;
+      break;
+    }
+    case 0x8: {
+      switch (instruction.n) {
+        case 0x0: instruction.type = OP_COPY_REGISTER; break;
+        case 0x1: instruction.type = OP_OR; break;
+        case 0x2: instruction.type = OP_AND; break;
+        case 0x3: instruction.type = OP_XOR; break;
+        case 0x4: instruction.type = OP_ADD_REGISTERS; break;
+        case 0x5: instruction.type = OP_SUBTRACT; break;
+        case 0x6: instruction.type = OP_SHIFT_RIGHT; break;
+        case 0x7: instruction.type = OP_SUBTRACT_REVERSE; break;
+        case 0xE: instruction.type = OP_SHIFT_LEFT; break;
+      }
+      break;
+    }
+    case 0x9: {
+      if (instruction.n == 0) {
+        instruction.type = OP_SKIP_REGISTERS_NOT_EQUAL;
+      }
+      break;
+    }
+    case 0xA: {
+      instruction.type = OP_SET_INDEX;
+      break;
+    }
+    case 0xB: {
+      instruction.type = OP_JUMP_OFFSET;
+      break;
+    }
+    case 0xC: {
+      instruction.type = OP_RANDOM;
+      break;
+    }
+    case 0xD: {
+      instruction.type = OP_DRAW;
+      break;
+    }
+    case 0xE: {
+      if (instruction.nn == 0x9E) {
+        instruction.type = OP_SKIP_KEY_PRESSED;
+      } else if (instruction.nn == 0xA1) {
+        instruction.type = OP_SKIP_KEY_NOT_PRESSED;
+      }
+      break;
+    }
+    case 0xF: {
+      switch (instruction.nn) {
+        case 0x07: instruction.type = OP_GET_DELAY; break;
+        case 0x0A: instruction.type = OP_WAIT_KEY; break;
+        case 0x15: instruction.type = OP_SET_DELAY; break;
+        case 0x18: instruction.type = OP_SET_SOUND; break;
+        case 0x1E: instruction.type = OP_ADD_INDEX; break;
+        case 0x29: instruction.type = OP_SET_SPRITE; break;
+        case 0x33: instruction.type = OP_STORE_BCD; break;
+        case 0x55: instruction.type = OP_STORE_REGISTERS; break;
+        case 0x65: instruction.type = OP_READ_REGISTERS; break;
+      }
+      break;
+    }
+  }
+  return instruction;
+}
+
+const char* instruction_name(int p_type) {
+  // Indexed by InstructionType, so the order here must match the enum.
+  static const char* names[INSTRUCTION_TYPE_COUNT] = {
+    "CLS", "RET", "JP", "CALL", "SE", "SNE", "SE_REG", "LD", "ADD", "LD_REG", "OR", "AND", "XOR",
+    "ADD_REG", "SUB", "SHR", "SUBN", "SHL", "SNE_REG", "LD_I", "JP_V0", "RND", "DRW", "SKP", 
+    "SKNP", "LD_DT_GET", "LD_K", "LD_DT", "LD_ST", "ADD_I", "LD_F", "LD_B", "LD_STORE", "LD_READ",
+    "UNKNOWN"
+  };
+
+  const char* name = "UNKNOWN";
+  if (p_type >= 0 && p_type < INSTRUCTION_TYPE_COUNT) {
+    name = names[p_type];
+  }
+  return name;
+}
@@ -0,0 +1,105 @@
+#ifndef OPCODE_HPP
+#define OPCODE_HPP
+
+#include <cstdint>
+
+/**
+ * Every instruction in the original Chip-8 instruction set, plus OP_UNKNOWN for opcodes that do 
+ * not decode to any of them.
+ */
+enum InstructionType {
+  OP_CLEAR_SCREEN,             // 00E0
+  OP_RETURN,                   // 00EE
+  OP_JUMP,                     // 1NNN
+  OP_CALL,                     // 2NNN
+  OP_SKIP_EQUAL,               // 3XNN
+  OP_SKIP_NOT_EQUAL,           // 4XNN
+  OP_SKIP_REGISTERS_EQUAL,     // 5XY0
+  OP_SET_REGISTER,             // 6XNN
+  OP_ADD_VALUE,                // 7XNN
+  OP_COPY_REGISTER,            // 8XY0
+  OP_OR,                       // 8XY1
+  OP_AND,                      // 8XY2
+  OP_XOR,                      // 8XY3
+  OP_ADD_REGISTERS,            // 8XY4
+  OP_SUBTRACT,                 // 8XY5
+  OP_SHIFT_RIGHT,              // 8XY6
+  OP_SUBTRACT_REVERSE,         // 8XY7
+  OP_SHIFT_LEFT,               // 8XYE
+  OP_SKIP_REGISTERS_NOT_EQUAL, // 9XY0
+  OP_SET_INDEX,                // ANNN
+  OP_JUMP_OFFSET,              // BNNN
+  OP_RANDOM,                   // CXNN
+  OP_DRAW,                     // DXYN
+  OP_SKIP_KEY_PRESSED,         // EX9E
+  OP_SKIP_KEY_NOT_PRESSED,     // EXA1
+  OP_GET_DELAY,                // FX07
+  OP_WAIT_KEY,                 // FX0A
+  OP_SET_DELAY,                // FX15
+  OP_SET_SOUND,                // FX18
+  OP_ADD_INDEX,                // FX1E
+  OP_SET_SPRITE,               // FX29
+  OP_STORE_BCD,                // FX33
+  OP_STORE_REGISTERS,          // FX55
+  OP_READ_REGISTERS,           // FX65
+  OP_UNKNOWN,
+  INSTRUCTION_TYPE_COUNT
+};
+
+/**
+ * A decoded 16-bit opcode. Every operand field is extracted up front, whether or not the 
+ * instruction type uses it, so executing an instruction never has to mask the opcode again.
+ */
+struct Instruction {
+  /**
+   * Lowest 12 bits, the address operand of 1NNN, 2NNN, ANNN and BNNN.
+   */
+  uint16_t nnn;
+
+  /**
+   * The InstructionType the opcode decodes to.
+   */
+  uint8_t type;
+
+  /**
+   * Highest nibble of the opcode, which selects the instruction group.
+   */
+  uint8_t prefix;
+
+  /**
+   * Second nibble, the first register operand.
+   */
+  uint8_t x;
+
+  /**
+   * Third nibble, the second register operand.
+   */
+  uint8_t y;
+
+  /**
+   * Lowest nibble, the row count of DXYN.
+   */
+  uint8_t n;
+
+  /**
+   * Lowest byte, the immediate value of 3XNN, 4XNN, 6XNN, 7XNN and CXNN.
+   */
+  uint8_t nn;
+
+  /**
+   * Rebuilds the raw 16-bit opcode this instruction was decoded from.
+   */
+  uint16_t Opcode() const { return (prefix << 12) | nnn; }
+};
+
+/**
+ * Decodes the 16-bit opcode p_opcode into its instruction type and operands.
+ */
+Instruction decode_instruction(uint16_t p_opcode);
+
+/**
+ * Returns a short mnemonic naming the given instruction type, e.g. "DRW" for OP_DRAW.
+ */
+const char* instruction_name(int p_type);
+
+#endif
@@ -0,0 +1,109 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+const int Profiler::ADDRESS_COUNT;
+
+Profiler::Profiler() {
+  Reset();
+}
+
+void Profiler::Reset() {
+  types_.fill({ 0, 0 });
+  addresses_.fill({ 0, 0 });
+  address_types_.fill(OP_UNKNOWN);
+}
+
+ProfileCounter Profiler::get_type(int p_type) {
+  return types_[p_type];
+}
+
+ProfileCounter Profiler::get_address(int p_address) {
+  return addresses_[p_address & (ADDRESS_COUNT - 1)];
+}
+
+ProfileCounter Profiler::get_total() {
+  ProfileCounter total = { 0, 0 };
+  for (const ProfileCounter& type : types_) {
+    total.count += type.count;
+    total.nanoseconds += type.nanoseconds;
+  }
+  return total;
+}
+
+/**
+ * Writes the column headings of a report table whose first column is headed p_first.
+ */
+static void write_heading(std::ostream& p_out, const char* p_first) {
+  p_out << std::endl << std::left << std::setw(12) << p_first << std::right << std::setw(12)
+    << "count" << std::setw(14) << "ns" << std::setw(9) << "share" << std::setw(13) << "average"
+    << std::endl;
+}
+
+/**
+ * Writes one report line for p_counter, with its share of p_total.
+ */
+static void write_counter(std::ostream& p_out, const ProfileCounter& p_counter,
+                          const ProfileCounter& p_total) {
+  double share = 0;
+  if (p_total.nanoseconds > 0) {
+    share = 100.0 * p_counter.nanoseconds / p_total.nanoseconds;
+  }
+  double average = p_counter.count > 0 ? (double)p_counter.nanoseconds / p_counter.count : 0;
+  p_out << std::setw(12) << p_counter.count << std::setw(14) << p_counter.nanoseconds
+    << std::setw(8) << std::fixed << std::setprecision(1) << share << "%"
+    << std::setw(10) << average << " ns" << std::defaultfloat << std::endl;
+}
+
+void Profiler::WriteReport(std::ostream& p_out, int p_addresses) {
+  ProfileCounter total = get_total();
+  p_out << total.count << " instructions, " << total.nanoseconds << " ns" << std::endl;
+
+  std::vector<int> types;
+  for (int type = 0; type < INSTRUCTION_TYPE_COUNT; type++) {
+    if (types_[type].count > 0) {
+      types.push_back(type);
+    }
+  }
+  std::sort(types.begin(), types.end(), [this](int a, int b) {
+    return types_[a].nanoseconds > types_[b].nanoseconds;
+  });
+
+  write_heading(p_out, "instruction");
+  for (int type : types) {
+    p_out << std::left << std::setw(12) << instruction_name(type) << std::right;
+    write_counter(p_out, types_[type], total);
+  }
+
+  std::vector<int> addresses;
+  for (int address = 0; address < ADDRESS_COUNT; address++) {
+    if (addresses_[address].count > 0) {
+      addresses.push_back(address);
+    }
+  }
+  int shown = std::min<int>(p_addresses, addresses.size());
+  std::partial_sort(addresses.begin(), addresses.begin() + shown, addresses.end(),
+    [this](int a, int b) { return addresses_[a].nanoseconds > addresses_[b].nanoseconds; });
+
+  write_heading(p_out, "address");
+  for (int i = 0; i < shown; i++) {
+    int address = addresses[i];
+    p_out << std::hex << std::setfill('0') << std::setw(3) << address << std::dec
+      << std::setfill(' ') << " " << std::left << std::setw(8)
+      << instruction_name(address_types_[address]) << std::right;
+    write_counter(p_out, addresses_[address], total);
+  }
+}
+
+void Profiler::WriteCollapsed(std::ostream& p_out) {
+  for (int address = 0; address < ADDRESS_COUNT; address++) {
+    const ProfileCounter& counter = addresses_[address];
+    if (counter.count > 0) {
+      p_out << "chip8;" << instruction_name(address_types_[address]) << ";0x" << std::hex
+        << std::setfill('0') << std::setw(3) << address << std::dec << std::setfill(' ') << " "
+        << counter.nanoseconds << std::endl;
+    }
+  }
+}
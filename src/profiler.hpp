@@ -0,0 +1,96 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "opcode.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Executions of, and host time spent in, one instruction type or one address.
+ */
+struct ProfileCounter {
+  long long count;
+  long long nanoseconds;
+};
+
+/**
+ * Counts how often each instruction type and each Chip-8 address is executed and how many host
+ * nanoseconds its handler took. Filled in by an Emu it is attached to with set_profiler, which only
+ * records anything when the core is built with CHIP8_PROFILE defined. Without it the hooks are
+ * compiled out and cost nothing.
+ */
+class Profiler {
+
+public:
+
+  /**
+   * Number of addresses tracked, one for every byte of memory.
+   */
+  const static int ADDRESS_COUNT = 4096;
+
+  Profiler();
+
+  /**
+   * Counts one execution of an instruction of type p_type at p_address that took p_nanoseconds.
+   */
+  void Record(int p_address, int p_type, long long p_nanoseconds) {
+    ProfileCounter& type = types_[p_type];
+    type.count++;
+    type.nanoseconds += p_nanoseconds;
+
+    int address = p_address & (ADDRESS_COUNT - 1);
+    ProfileCounter& counter = addresses_[address];
+    counter.count++;
+    counter.nanoseconds += p_nanoseconds;
+    address_types_[address] = p_type;
+  }
+
+  /**
+   * Zeroes every counter.
+   */
+  void Reset();
+
+  /**
+   * Returns the counter of instruction type p_type.
+   */
+  ProfileCounter get_type(int p_type);
+
+  /**
+   * Returns the counter of the instruction at p_address.
+   */
+  ProfileCounter get_address(int p_address);
+
+  /**
+   * Returns the counter summed over every instruction executed.
+   */
+  ProfileCounter get_total();
+
+  /**
+   * Writes a readable report to p_out: every instruction type that ran, most time first, then the
+   * p_addresses hottest addresses.
+   */
+  void WriteReport(std::ostream& p_out, int p_addresses = 20);
+
+  /**
+   * Writes the time spent at each address in the collapsed stack format read by flamegraph.pl and
+   * speedscope, one "chip8;<instruction>;<address> <nanoseconds>" line per address, so the graph
+   * splits time by handler first and by address within it.
+   */
+  void WriteCollapsed(std::ostream& p_out);
+
+private:
+
+  std::array<ProfileCounter, INSTRUCTION_TYPE_COUNT> types_;
+
+  std::array<ProfileCounter, ADDRESS_COUNT> addresses_;
+
+  /**
+   * Type of the last instruction run at each address, which only changes if the program rewrites
+   * itself.
+   */
+  std::array<uint8_t, ADDRESS_COUNT> address_types_;
+};
+
+#endif
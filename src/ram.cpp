@@ -2,27 +2,88 @@
 
 #include "ram.hpp"
 
+#include <cstring>
+
+const int Ram::ADDRESSES;
+
+Ram::Ram() {
+  memory_.fill(0);
+}
+
 void Ram::Write(int p_address, std::bitset<8> p_value) {
-  // Check that the address given is within bounds.
-  if (!(p_address < 0 || p_address >= ADDRESSES)) {
-    memory_[p_address] = p_value;
-  }
+  WriteByte(p_address, p_value.to_ulong());
 }
 
-void Ram::Write(int p_address, std::vector<std::bitset<8>> p_values) {
+void Ram::Write(int p_address, const std::vector<std::bitset<8>>& p_values) {
   for (int i = 0; i < p_values.size(); i++) {
     if ( (p_address + i < ADDRESSES) && (p_address >= 0) ) {
-      memory_[p_address + i] = p_values[i];
+      memory_[p_address + i] = p_values[i].to_ulong();
     } else {
       break;
     }
   }
 }
 
+int Ram::Write(int p_address, const uint8_t* p_bytes, int p_length) {
+  int written = 0;
+  if (p_address >= 0 && p_address < ADDRESSES && p_length > 0) {
+    // Clip the copy so it stops at the last address.
+    written = p_length;
+    if (p_address + written > ADDRESSES) {
+      written = ADDRESSES - p_address;
+    }
+    std::memcpy(memory_.data() + p_address, p_bytes, written);
+  }
+  return written;
+}
+
+void Ram::WriteByte(int p_address, uint8_t p_value) {
+  // Check that the address given is within bounds.
+  if (!(p_address < 0 || p_address >= ADDRESSES)) {
+    memory_[p_address] = p_value;
+  }
+}
+
 std::bitset<8> Ram::Read(int p_address) {
-  std::bitset<8> ret_val("00000000");
+  return std::bitset<8>(ReadByte(p_address));
+}
+
+int Ram::Read(int p_address, uint8_t* p_destination, int p_length) {
+  int copied = 0;
+  if (p_length > 0) {
+    std::memset(p_destination, 0, p_length);
+
+    // Only the part of the range that overlaps memory is copied, the rest stays 0.
+    int first = p_address < 0 ? 0 : p_address;
+    int last = p_address + p_length > ADDRESSES ? ADDRESSES : p_address + p_length;
+    if (first < last) {
+      copied = last - first;
+      std::memcpy(p_destination + (first - p_address), memory_.data() + first, copied);
+    }
+  }
+  return copied;
+}
+
+uint8_t Ram::ReadByte(int p_address) {
+  uint8_t ret_val = 0;
   if (!(p_address < 0 || p_address >= ADDRESSES)) {
     ret_val = memory_[p_address];
   }
   return ret_val;
-}
\ No newline at end of file
+}
+
+ByteView Ram::View(int p_address, int p_length) {
+  ByteView view{memory_.data(), 0};
+  if (p_address >= 0 && p_address < ADDRESSES && p_length > 0) {
+    view.data = memory_.data() + p_address;
+    view.size = p_length;
+    if (p_address + p_length > ADDRESSES) {
+      view.size = ADDRESSES - p_address;
+    }
+  }
+  return view;
+}
+
+ByteView Ram::View() {
+  return ByteView{memory_.data(), ADDRESSES};
+}
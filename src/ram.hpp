@@ -4,8 +4,22 @@
 #define RAM_HPP
 
 #include <array>
-#include <vector>
 #include <bitset>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Read-only view over a contiguous run of bytes, in the style of std::span. The view does not own
+ * the bytes it points to, and is only valid for as long as the memory it was taken from.
+ */
+struct ByteView {
+  const uint8_t* data;
+  int size;
+
+  const uint8_t& operator[](int p_index) const { return data[p_index]; }
+  const uint8_t* begin() const { return data; }
+  const uint8_t* end() const { return data + size; }
+};
 
 /**
  * This class represents the RAM of the Chip-8 emulator, containing 4096 addresses holding 8-bit
@@ -14,6 +28,16 @@
 class Ram {
 
 public:
+  /*
+  * The number of memory addresses that can be accessed.
+  */  
+  const static int ADDRESSES = 4096;
+
+  /*
+  * Default constructor, all addresses start out holding 0.
+  */
+  Ram();
+
   /*
   * Writes the value p_value into memory at p_address.
   */
@@ -22,23 +46,51 @@ public:
   /*
   * Writes the values stored in p_values into memory, starting at p_address.
   */
-  void Write(int p_address, std::vector<std::bitset<8>> p_values);
+  void Write(int p_address, const std::vector<std::bitset<8>>& p_values);
+
+  /*
+  * Copies p_length bytes from p_bytes into memory starting at p_address. Bytes that would land 
+  * past the last address are dropped. Returns the number of bytes actually written.
+  */
+  int Write(int p_address, const uint8_t* p_bytes, int p_length);
+
+  /*
+  * Writes the byte p_value into memory at p_address, ignoring out of bounds addresses.
+  */
+  void WriteByte(int p_address, uint8_t p_value);
 
   /*
   * Returns the value that is stored in memory_[p_address]. If ADDRESSES < p_address < 0 Read will
   * return an array containing all 0.
   */
   std::bitset<8> Read(int p_address);
-private:
+
   /*
-  * The number of memory addresses that can be accessed.
-  */  
-  const static int ADDRESSES = 4096;
+  * Copies p_length bytes starting at p_address into p_destination. Addresses that are out of
+  * bounds read as 0. Returns the number of in bounds bytes that were copied.
+  */
+  int Read(int p_address, uint8_t* p_destination, int p_length);
 
   /*
-  * Each element of the memory_ array is a boolean array, representing an 8-bit binary string 
+  * Returns the byte stored at p_address, or 0 if the address is out of bounds.
+  */
+  uint8_t ReadByte(int p_address);
+
+  /*
+  * Returns a zero-copy view of memory starting at p_address and spanning at most p_length bytes. 
+  * The view is clipped to the end of memory, and is empty if p_address is out of bounds.
+  */
+  ByteView View(int p_address, int p_length);
+
+  /*
+  * Returns a zero-copy view of the entire address space.
+  */
+  ByteView View();
+private:
+  /*
+  * Contiguous buffer holding one byte per address.
   */  
-  std::array<std::bitset<8>, ADDRESSES> memory_;
+  std::array<uint8_t, ADDRESSES> memory_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include <bitset>
+#include <cstdint>
+#include <type_traits>
 
 /*
 * Class representing an 8-bit register. 8 bits can be written and read from 
@@ -15,6 +17,11 @@ class Register {
 
 public:
 
+  /**
+   * Default constructor, the register starts out holding 0.
+   */
+  Register();
+
   /**
    * Stores the bits p_bits in the register.
    */
@@ -31,27 +38,36 @@ public:
   void Print();
 private: 
 
+  static_assert(register_size_ <= 16, "Registers hold at most 16 bits");
+
   /**
-   * The array of bits stored in register.
+   * The bits stored in register, kept in the smallest unsigned integer that fits them. This keeps
+   * an 8-bit register exactly one byte wide, so an array of them is a plain run of bytes.
    */
-  std::bitset<register_size_> bits_; 
+  typename std::conditional<(register_size_ <= 8), uint8_t, uint16_t>::type bits_; 
 };
 
+template<int register_size_>
+Register<register_size_>::Register() {
+  bits_ = 0;
+}
+
 template<int register_size_>
 void Register<register_size_>::Write(std::bitset<register_size_> p_bits) {
-  bits_ = p_bits;
+  bits_ = p_bits.to_ulong();
 }
 
 template<int register_size_>
 std::bitset<register_size_> Register<register_size_>::Read() {
-  return bits_;
+  return std::bitset<register_size_>(bits_);
 }
 
 template<int register_size_>
 void Register<register_size_>::Print() {
+  std::bitset<register_size_> bits = Read();
   std::cout << "Register: ";
-  for (int i = bits_.size() - 1; i > -1; i--) {
-    std::cout << bits_[i];
+  for (int i = bits.size() - 1; i > -1; i--) {
+    std::cout << bits[i];
 
     if ((i % 4) == 3) {
       std::cout << ' ';
@@ -0,0 +1,202 @@
+#include "replay.hpp"
+
+#include "save_state.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+const uint32_t Replay::VERSION;
+
+/**
+ * Header written in front of the events in a replay file.
+ */
+struct ReplayFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t rom_hash;
+  uint32_t seed;
+  uint32_t instructions_per_frame;
+  uint32_t event_count;
+  int64_t end_cycle;
+  uint32_t final_state_hash;
+
+  /**
+   * state_checksum of the encoded events.
+   */
+  uint32_t checksum;
+};
+
+static const char REPLAY_FILE_MAGIC[4] = { 'C', '8', 'R', 'P' };
+
+/**
+ * Bit set in an event's key byte for a press.
+ */
+static const uint8_t KEY_DOWN_BIT = 0x10;
+
+/**
+ * Returns true if p_key is one of the keypad keys 0x0 -> 0xF.
+ */
+static bool is_keypad_key(int p_key) {
+  return p_key >= 0 && p_key <= 0xF;
+}
+
+ReplayRecorder::ReplayRecorder(Emu* p_emu, const uint8_t* p_rom, int p_rom_size, uint32_t p_seed,
+                               int p_instructions_per_frame) {
+  emu_ = p_emu;
+  emu_->set_random_seed(p_seed);
+  replay_.rom_hash = state_checksum(p_rom, p_rom_size);
+  replay_.seed = p_seed;
+  replay_.instructions_per_frame = p_instructions_per_frame;
+  replay_.end_cycle = 0;
+  replay_.final_state_hash = 0;
+}
+
+void ReplayRecorder::KeyDown(int p_key) {
+  Record(p_key, true);
+  emu_->KeyDown(p_key);
+}
+
+void ReplayRecorder::KeyUp(int p_key) {
+  Record(p_key, false);
+  emu_->KeyUp(p_key);
+}
+
+void ReplayRecorder::Rewind() {
+  long long cycle = emu_->get_cycle_count();
+  while (!replay_.events.empty() && replay_.events.back().cycle > cycle) {
+    replay_.events.pop_back();
+  }
+}
+
+const Replay& ReplayRecorder::Finish() {
+  replay_.end_cycle = emu_->get_cycle_count();
+  replay_.final_state_hash = replay_state_hash(*emu_);
+  return replay_;
+}
+
+void ReplayRecorder::Record(int p_key, bool p_down) {
+  if (is_keypad_key(p_key)) {
+    replay_.events.push_back({ emu_->get_cycle_count(), static_cast<uint8_t>(p_key), p_down });
+  }
+}
+
+bool play_replay(Emu& p_emu, const Replay& p_replay, const uint8_t* p_rom, int p_rom_size) {
+  if (state_checksum(p_rom, p_rom_size) != p_replay.rom_hash
+      || p_replay.instructions_per_frame < 1) {
+    return false;
+  }
+
+  p_emu.LoadRom(p_rom, p_rom_size);
+  p_emu.set_random_seed(p_replay.seed);
+
+  // Keys were delivered between frames, so hand over every event that is due before each one.
+  size_t next_event = 0;
+  while (true) {
+    long long cycle = p_emu.get_cycle_count();
+    for (; next_event < p_replay.events.size() && p_replay.events[next_event].cycle <= cycle;
+         next_event++) {
+      const ReplayEvent& event = p_replay.events[next_event];
+      if (event.down) {
+        p_emu.KeyDown(event.key);
+      } else {
+        p_emu.KeyUp(event.key);
+      }
+    }
+    if (cycle >= p_replay.end_cycle) {
+      break;
+    }
+    p_emu.RunFrame(p_replay.instructions_per_frame);
+  }
+  return true;
+}
+
+uint32_t replay_state_hash(Emu& p_emu) {
+  EmuState state;
+  p_emu.SaveState(state);
+  return state_checksum(&state, sizeof(state));
+}
+
+bool write_replay_file(const std::string& p_path, const Replay& p_replay) {
+  std::vector<uint8_t> events;
+  int64_t cycle = 0;
+  for (const ReplayEvent& event : p_replay.events) {
+    // Cycles since the previous event, 7 bits at a time with the top bit set on all but the last.
+    uint64_t delta = event.cycle - cycle;
+    cycle = event.cycle;
+    while (delta >= 0x80) {
+      events.push_back(static_cast<uint8_t>(delta | 0x80));
+      delta >>= 7;
+    }
+    events.push_back(static_cast<uint8_t>(delta));
+    events.push_back(event.key | (event.down ? KEY_DOWN_BIT : 0));
+  }
+
+  ReplayFileHeader header;
+  std::memcpy(header.magic, REPLAY_FILE_MAGIC, sizeof(header.magic));
+  header.version = Replay::VERSION;
+  header.rom_hash = p_replay.rom_hash;
+  header.seed = p_replay.seed;
+  header.instructions_per_frame = p_replay.instructions_per_frame;
+  header.event_count = p_replay.events.size();
+  header.end_cycle = p_replay.end_cycle;
+  header.final_state_hash = p_replay.final_state_hash;
+  header.checksum = state_checksum(events.data(), events.size());
+
+  std::ofstream file(p_path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(events.data()), events.size());
+  return static_cast<bool>(file);
+}
+
+bool read_replay_file(const std::string& p_path, Replay& p_replay) {
+  std::ifstream file(p_path, std::ios::binary);
+  ReplayFileHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || std::memcmp(header.magic, REPLAY_FILE_MAGIC, sizeof(header.magic)) != 0
+      || header.version != Replay::VERSION) {
+    return false;
+  }
+
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+  if (state_checksum(bytes.data(), bytes.size()) != header.checksum) {
+    return false;
+  }
+
+  // Decode into a temporary so a bad file leaves p_replay alone.
+  Replay replay;
+  replay.rom_hash = header.rom_hash;
+  replay.seed = header.seed;
+  replay.instructions_per_frame = header.instructions_per_frame;
+  replay.end_cycle = header.end_cycle;
+  replay.final_state_hash = header.final_state_hash;
+  replay.events.reserve(header.event_count);
+
+  size_t position = 0;
+  int64_t cycle = 0;
+  for (uint32_t i = 0; i < header.event_count; i++) {
+    uint64_t delta = 0;
+    for (int shift = 0; ; shift += 7) {
+      if (position >= bytes.size() || shift > 56) {
+        return false;
+      }
+      uint8_t byte = bytes[position++];
+      delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    if (position >= bytes.size() || (bytes[position] & ~(KEY_DOWN_BIT | 0xF)) != 0) {
+      return false;
+    }
+    uint8_t key = bytes[position++];
+    cycle += delta;
+    replay.events.push_back({ cycle, static_cast<uint8_t>(key & 0xF), (key & KEY_DOWN_BIT) != 0 });
+  }
+  if (position != bytes.size()) {
+    return false;
+  }
+  p_replay = replay;
+  return true;
+}
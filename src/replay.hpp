@@ -0,0 +1,128 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "emu.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A key press or release, stamped with the emulated cycle count it was delivered at.
+ */
+struct ReplayEvent {
+  int64_t cycle;
+  uint8_t key;
+  bool down;
+};
+
+/**
+ * Everything needed to play a recorded run again and end up in exactly the same state: the rom
+ * and seed it started from, how it was run and every key delivered along the way.
+ */
+struct Replay {
+  /**
+   * Layout version of replay files. Bumped every time the file layout changes.
+   */
+  const static uint32_t VERSION = 1;
+
+  /**
+   * state_checksum of the rom the run started from.
+   */
+  uint32_t rom_hash;
+
+  uint32_t seed;
+
+  uint32_t instructions_per_frame;
+
+  /**
+   * Cycle count the run ended at.
+   */
+  int64_t end_cycle;
+
+  /**
+   * replay_state_hash of the emulator at the end of the run.
+   */
+  uint32_t final_state_hash;
+
+  /**
+   * Key events in the order they were delivered, never going back in cycles.
+   */
+  std::vector<ReplayEvent> events;
+};
+
+/**
+ * Records the key events delivered to an emulator run a frame at a time with RunFrame. Keys go
+ * through the recorder's KeyDown and KeyUp in place of the emulator's, which stamps them with the
+ * cycle count before passing them on.
+ */
+class ReplayRecorder {
+
+public:
+
+  /**
+   * Starts recording p_emu, which has just loaded the p_rom_size bytes at p_rom and is run with
+   * p_instructions_per_frame instructions a frame. Seeds its random number generator with p_seed.
+   */
+  ReplayRecorder(Emu* p_emu, const uint8_t* p_rom, int p_rom_size, uint32_t p_seed,
+                 int p_instructions_per_frame);
+
+  /**
+   * Records and delivers a press of keypad key p_key. Keys outside 0x0 -> 0xF are ignored.
+   */
+  void KeyDown(int p_key);
+
+  /**
+   * Records and delivers a release of keypad key p_key. Keys outside 0x0 -> 0xF are ignored.
+   */
+  void KeyUp(int p_key);
+
+  /**
+   * Forgets the events after the emulator's cycle count, called after loading an earlier state so
+   * the replay follows the history that is played from then on.
+   */
+  void Rewind();
+
+  /**
+   * Ends the recording at the emulator's current state and returns the replay.
+   */
+  const Replay& Finish();
+
+private:
+
+  Emu* emu_;
+
+  Replay replay_;
+
+  void Record(int p_key, bool p_down);
+};
+
+/**
+ * Loads the p_rom_size bytes at p_rom into p_emu, a freshly made emulator, and plays p_replay on
+ * it headless, running frames back to back as fast as the host allows until the recorded end
+ * cycle. Returns false without running anything if p_rom is not the rom the replay was recorded
+ * on.
+ */
+bool play_replay(Emu& p_emu, const Replay& p_replay, const uint8_t* p_rom, int p_rom_size);
+
+/**
+ * Returns the checksum of the whole saved state of p_emu, for checking a replay ended up where the
+ * recording did.
+ */
+uint32_t replay_state_hash(Emu& p_emu);
+
+/**
+ * Writes p_replay to the file p_path. Events take a varint of the cycles since the previous
+ * event and a byte holding the key and direction, so most take two or three bytes. Returns false
+ * if the file can not be written.
+ */
+bool write_replay_file(const std::string& p_path, const Replay& p_replay);
+
+/**
+ * Reads a replay written by write_replay_file from p_path into p_replay. Returns false, leaving
+ * p_replay untouched, if the file can not be read, is not a replay file, was written with a
+ * different layout version or fails the checksum.
+ */
+bool read_replay_file(const std::string& p_path, Replay& p_replay);
+
+#endif
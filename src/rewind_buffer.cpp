@@ -0,0 +1,216 @@
+#include "rewind_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const int RewindBuffer::DEFAULT_KEYFRAME_INTERVAL;
+const int RewindBuffer::STATE_WORDS;
+
+static_assert(sizeof(EmuState) % sizeof(uint64_t) == 0, "EmuState must be a whole number of words");
+
+/**
+ * Header in front of every run of a delta: the number of unchanged words to skip, followed by the
+ * number of XORed words that come after the header.
+ */
+struct DeltaRun {
+  uint16_t unchanged;
+  uint16_t changed;
+};
+
+RewindBuffer::RewindBuffer(int p_capacity, int p_max_frames, int p_keyframe_interval) {
+  ring_.resize(std::max<int>(p_capacity, 2 * sizeof(EmuState)));
+  max_frames_ = std::max(1, p_max_frames);
+
+  // Keep at least two keyframes within the frame limit, so evicting the oldest one never throws
+  // away the newest frames.
+  keyframe_interval_ = std::max(1, std::min(p_keyframe_interval, max_frames_ / 2));
+
+  // Worst case every other word changed, so every changed word needs its own header.
+  scratch_.resize(sizeof(EmuState) + (STATE_WORDS + 1) * sizeof(DeltaRun));
+  Clear();
+}
+
+void RewindBuffer::Push(const EmuState& p_state) {
+  bool keyframe = entries_.empty() || frames_since_keyframe_ + 1 >= keyframe_interval_;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(&p_state);
+  int length = sizeof(EmuState);
+
+  if (!keyframe) {
+    int delta_length = EncodeDelta(p_state);
+    if (delta_length < length) {
+      data = scratch_.data();
+      length = delta_length;
+    } else {
+      // Too much changed for the delta to pay off.
+      keyframe = true;
+    }
+  }
+
+  int offset = Allocate(length);
+  if (!keyframe && entries_.empty()) {
+    // Making room evicted the keyframe the delta was encoded against, start over with a keyframe.
+    keyframe = true;
+    data = reinterpret_cast<const uint8_t*>(&p_state);
+    length = sizeof(EmuState);
+    offset = Allocate(length);
+  }
+
+  std::memcpy(ring_.data() + offset, data, length);
+  entries_.push_back({ offset, length, keyframe });
+  if (keyframe) {
+    keyframe_ = p_state;
+    frames_since_keyframe_ = 0;
+  } else {
+    frames_since_keyframe_++;
+  }
+
+  while ((int)entries_.size() > max_frames_) {
+    EvictOldest();
+  }
+}
+
+bool RewindBuffer::Pop(EmuState& p_state) {
+  if (entries_.empty()) {
+    return false;
+  }
+
+  RewindEntry entry = entries_.back();
+  entries_.pop_back();
+  write_offset_ = entry.offset;
+
+  if (!entry.keyframe) {
+    DecodeDelta(ring_.data() + entry.offset, entry.length, p_state);
+    frames_since_keyframe_--;
+    return true;
+  }
+
+  std::memcpy(&p_state, ring_.data() + entry.offset, sizeof(EmuState));
+
+  // Deltas further back were encoded against the keyframe before this one.
+  frames_since_keyframe_ = 0;
+  for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+    if (it->keyframe) {
+      std::memcpy(&keyframe_, ring_.data() + it->offset, sizeof(EmuState));
+      break;
+    }
+    frames_since_keyframe_++;
+  }
+  return true;
+}
+
+void RewindBuffer::Clear() {
+  entries_.clear();
+  write_offset_ = 0;
+  frames_since_keyframe_ = 0;
+}
+
+int RewindBuffer::get_frame_count() const {
+  return entries_.size();
+}
+
+int RewindBuffer::get_used_bytes() const {
+  int used = 0;
+  for (const RewindEntry& entry : entries_) {
+    used += entry.length;
+  }
+  return used;
+}
+
+int RewindBuffer::get_capacity() const {
+  return ring_.size();
+}
+
+int RewindBuffer::Allocate(int p_length) {
+  if (entries_.empty()) {
+    write_offset_ = 0;
+  }
+
+  // Frames are stored in one piece, so if the frame does not fit before the end of the ring it 
+  // goes at the start and the end of the ring is left unused.
+  int offset = write_offset_;
+  int wrapped_from = ring_.size();
+  if (offset + p_length > (int)ring_.size()) {
+    wrapped_from = offset;
+    offset = 0;
+  }
+
+  // The frames directly after the write offset are the oldest ones.
+  while (!entries_.empty()) {
+    const RewindEntry& oldest = entries_.front();
+    bool overlaps = oldest.offset < offset + p_length && oldest.offset + oldest.length > offset;
+    if (!overlaps && oldest.offset < wrapped_from) {
+      break;
+    }
+    EvictOldest();
+  }
+
+  write_offset_ = offset + p_length;
+  return offset;
+}
+
+void RewindBuffer::EvictOldest() {
+  entries_.pop_front();
+  while (!entries_.empty() && !entries_.front().keyframe) {
+    entries_.pop_front();
+  }
+}
+
+int RewindBuffer::EncodeDelta(const EmuState& p_state) {
+  const uint8_t* state = reinterpret_cast<const uint8_t*>(&p_state);
+  const uint8_t* keyframe = reinterpret_cast<const uint8_t*>(&keyframe_);
+  uint8_t* out = scratch_.data();
+
+  int word = 0;
+  while (word < STATE_WORDS) {
+    uint64_t a;
+    uint64_t b;
+    DeltaRun run = { 0, 0 };
+
+    for (; word < STATE_WORDS; word++, run.unchanged++) {
+      std::memcpy(&a, state + word * 8, 8);
+      std::memcpy(&b, keyframe + word * 8, 8);
+      if (a != b) {
+        break;
+      }
+    }
+
+    uint8_t* header = out;
+    out += sizeof(DeltaRun);
+    for (; word < STATE_WORDS; word++, run.changed++) {
+      std::memcpy(&a, state + word * 8, 8);
+      std::memcpy(&b, keyframe + word * 8, 8);
+      if (a == b) {
+        break;
+      }
+      a ^= b;
+      std::memcpy(out, &a, 8);
+      out += 8;
+    }
+    std::memcpy(header, &run, sizeof(DeltaRun));
+  }
+  return out - scratch_.data();
+}
+
+void RewindBuffer::DecodeDelta(const uint8_t* p_delta, int p_length, EmuState& p_state) {
+  p_state = keyframe_;
+  uint8_t* state = reinterpret_cast<uint8_t*>(&p_state);
+  const uint8_t* end = p_delta + p_length;
+
+  int word = 0;
+  while (p_delta < end) {
+    DeltaRun run;
+    std::memcpy(&run, p_delta, sizeof(DeltaRun));
+    p_delta += sizeof(DeltaRun);
+    word += run.unchanged;
+
+    for (int i = 0; i < run.changed; i++, word++) {
+      uint64_t a;
+      uint64_t x;
+      std::memcpy(&a, state + word * 8, 8);
+      std::memcpy(&x, p_delta, 8);
+      a ^= x;
+      std::memcpy(state + word * 8, &a, 8);
+      p_delta += 8;
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#ifndef REWIND_BUFFER_HPP
+#define REWIND_BUFFER_HPP
+
+#include "save_state.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * Where a frame is stored in the rewind buffer.
+ */
+struct RewindEntry {
+  /**
+   * Offset of the frame's bytes in the ring.
+   */
+  int offset;
+
+  /**
+   * Number of bytes the frame takes up.
+   */
+  int length;
+
+  /**
+   * True if the frame is stored as a whole EmuState, false if it is a delta against the keyframe
+   * before it.
+   */
+  bool keyframe;
+};
+
+/**
+ * Bounded history of emulator states used to play a program backwards. Every keyframe_interval 
+ * frames a whole EmuState is stored as a keyframe. The frames in between only store the words that
+ * differ from that keyframe: the state is XORed with the keyframe and the runs of zero words are 
+ * squeezed out. Frames live in a fixed size ring of bytes allocated up front. When the ring or the
+ * frame limit is full the oldest keyframe is thrown away together with the deltas that depend on
+ * it, so memory use never grows past the capacity.
+ */
+class RewindBuffer {
+
+public:
+
+  /**
+   * Default number of frames from one keyframe to the next, one second at 60 frames per second.
+   */
+  const static int DEFAULT_KEYFRAME_INTERVAL = 60;
+
+  /**
+   * Creates a buffer holding at most p_max_frames frames in p_capacity bytes. The capacity is 
+   * raised to fit at least two keyframes, and the keyframe interval is lowered to fit at least two
+   * keyframes within p_max_frames.
+   */
+  RewindBuffer(int p_capacity, int p_max_frames, 
+               int p_keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+  /**
+   * Adds p_state as the newest frame, evicting the oldest frames if there is no room.
+   */
+  void Push(const EmuState& p_state);
+
+  /**
+   * Removes the newest frame and stores it in p_state. Returns false if the buffer is empty.
+   */
+  bool Pop(EmuState& p_state);
+
+  /**
+   * Throws away every frame.
+   */
+  void Clear();
+
+  /**
+   * Returns the number of frames held.
+   */
+  int get_frame_count() const;
+
+  /**
+   * Returns the number of bytes of the ring used by the frames held.
+   */
+  int get_used_bytes() const;
+
+  /**
+   * Returns the size in bytes of the ring.
+   */
+  int get_capacity() const;
+
+private:
+
+  /**
+   * Number of 64-bit words in an EmuState, the unit deltas are encoded in.
+   */
+  const static int STATE_WORDS = sizeof(EmuState) / sizeof(uint64_t);
+
+  /**
+   * The ring the frames are stored in.
+   */
+  std::vector<uint8_t> ring_;
+
+  /**
+   * Where each frame is stored, oldest first. The oldest frame is always a keyframe.
+   */
+  std::deque<RewindEntry> entries_;
+
+  /**
+   * Offset in the ring the next frame is written at.
+   */
+  int write_offset_;
+
+  /**
+   * Most frames held at once.
+   */
+  int max_frames_;
+
+  /**
+   * Number of frames from one keyframe to the next.
+   */
+  int keyframe_interval_;
+
+  /**
+   * Number of delta frames stored after the newest keyframe.
+   */
+  int frames_since_keyframe_;
+
+  /**
+   * Copy of the newest keyframe, deltas are encoded and decoded against it.
+   */
+  EmuState keyframe_;
+
+  /**
+   * Space a delta is encoded into before it is copied into the ring.
+   */
+  std::vector<uint8_t> scratch_;
+
+  /**
+   * Finds room for p_length bytes in the ring, evicting the oldest frames that are in the way. 
+   * Returns the offset of the room.
+   */
+  int Allocate(int p_length);
+
+  /**
+   * Throws away the oldest keyframe and the deltas stored against it.
+   */
+  void EvictOldest();
+
+  /**
+   * Encodes p_state as a delta against keyframe_ into scratch_. Returns the length of the delta.
+   */
+  int EncodeDelta(const EmuState& p_state);
+
+  /**
+   * Decodes the p_length byte delta at p_delta against keyframe_ into p_state.
+   */
+  void DecodeDelta(const uint8_t* p_delta, int p_length, EmuState& p_state);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "save_state.hpp"
+
+#include <cstring>
+#include <fstream>
+
+const uint32_t EmuState::VERSION;
+const int EmuState::STACK_SIZE;
+
+/**
+ * Header written in front of the state in a state file.
+ */
+struct StateFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t size;
+  uint32_t checksum;
+};
+
+static const char STATE_FILE_MAGIC[4] = { 'C', '8', 'S', 'T' };
+
+bool write_state_file(const std::string& p_path, const EmuState& p_state) {
+  StateFileHeader header;
+  std::memcpy(header.magic, STATE_FILE_MAGIC, sizeof(header.magic));
+  header.version = EmuState::VERSION;
+  header.size = sizeof(EmuState);
+  header.checksum = state_checksum(&p_state, sizeof(EmuState));
+
+  std::ofstream file(p_path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(&p_state), sizeof(EmuState));
+  return static_cast<bool>(file);
+}
+
+bool read_state_file(const std::string& p_path, EmuState& p_state) {
+  std::ifstream file(p_path, std::ios::binary);
+  StateFileHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) 
+      || std::memcmp(header.magic, STATE_FILE_MAGIC, sizeof(header.magic)) != 0
+      || header.version != EmuState::VERSION || header.size != sizeof(EmuState)) {
+    return false;
+  }
+
+  // Read into a temporary so a bad file leaves p_state alone.
+  EmuState state;
+  if (!file.read(reinterpret_cast<char*>(&state), sizeof(state)) 
+      || state_checksum(&state, sizeof(state)) != header.checksum) {
+    return false;
+  }
+  p_state = state;
+  return true;
+}
+
+uint32_t state_checksum(const void* p_data, int p_length) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(p_data);
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < p_length; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,123 @@
+#ifndef SAVE_STATE_HPP
+#define SAVE_STATE_HPP
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * Everything needed to put an emulator back into exactly the state it was in, laid out as a flat,
+ * fixed size block of plain data so it can be copied around with memcpy. Filled in by 
+ * Emu::SaveState and applied by Emu::LoadState. Settings such as the execution engine are not part
+ * of the state.
+ */
+struct EmuState {
+  /**
+   * Layout version of the struct. Bumped every time a field is added, removed or moved.
+   */
+  const static uint32_t VERSION = 2;
+
+  /**
+   * Number of return addresses the call stack holds.
+   */
+  const static int STACK_SIZE = 16;
+
+  /**
+   * The layout version this state was saved with.
+   */
+  uint32_t version;
+
+  /**
+   * Instructions per second of virtual time, the timer phase is relative to it.
+   */
+  uint32_t clock_speed;
+
+  /**
+   * Total number of instruction cycles run.
+   */
+  int64_t cycle_count;
+
+  /**
+   * Progress of the virtual clock towards the next timer tick.
+   */
+  int32_t timer_phase;
+
+  /**
+   * State of the random number generator used by Cxkk.
+   */
+  uint32_t random_state;
+
+  uint16_t program_counter;
+
+  uint16_t index_register;
+
+  /**
+   * Return addresses, only the first stack_size entries are used.
+   */
+  uint16_t stack[STACK_SIZE];
+
+  /**
+   * State of keys 0x0 -> 0xF, key n in bit n.
+   */
+  uint16_t keys;
+
+  /**
+   * Variable registers V0 -> VF.
+   */
+  uint8_t registers[16];
+
+  uint8_t stack_size;
+
+  uint8_t delay_timer;
+
+  uint8_t sound_timer;
+
+  /**
+   * 1 while suspended on Fx0A.
+   */
+  uint8_t waiting_for_key;
+
+  /**
+   * The register the pending Fx0A stores the key in.
+   */
+  uint8_t wait_register;
+
+  /**
+   * Keeps the display rows 8 byte aligned, always 0.
+   */
+  uint8_t reserved[5];
+
+  /**
+   * Display rows, packed like Display::GetRow.
+   */
+  uint64_t display[32];
+
+  /**
+   * All 4kB of memory.
+   */
+  uint8_t memory[4096];
+};
+
+static_assert(std::is_trivially_copyable<EmuState>::value, "EmuState must be memcpy-able");
+static_assert(sizeof(EmuState) == 4440, "EmuState layout changed, bump EmuState::VERSION");
+
+/**
+ * Writes p_state to the file p_path, preceded by a header holding a magic number, the layout 
+ * version, the size and a checksum of the state. The state is written in host byte order. Returns
+ * false if the file could not be written.
+ */
+bool write_state_file(const std::string& p_path, const EmuState& p_state);
+
+/**
+ * Reads a state written by write_state_file from p_path into p_state. Returns false, leaving 
+ * p_state untouched, if the file can not be read, is not a state file, was written with a 
+ * different layout version or fails the checksum.
+ */
+bool read_state_file(const std::string& p_path, EmuState& p_state);
+
+/**
+ * Returns the 32-bit FNV-1a hash of the p_length bytes at p_data.
+ */
+uint32_t state_checksum(const void* p_data, int p_length);
+
+#endif
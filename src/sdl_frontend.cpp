@@ -0,0 +1,83 @@
+#include "sdl_frontend.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+int keypad_value(SDL_Scancode p_code) {
+  // SDL scan codes that will map to keypad hex values, in the same order as the values below.
+  const SDL_Scancode codes[] = {
+    SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4, SDL_SCANCODE_Q, SDL_SCANCODE_W, 
+    SDL_SCANCODE_E, SDL_SCANCODE_R, SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_F, 
+    SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_C, SDL_SCANCODE_V
+  };
+
+  // The keypad values that can be used as input. 
+  const int values[] = {
+    1,   2, 3,   0xC, 
+    4,   5, 6,   0xD,
+    7,   8, 9,   0xE, 
+    0xA, 0, 0xB, 0xF
+  };
+
+  int value = -1;
+  for (int i = 0; i < 16; i++) {
+    if (codes[i] == p_code) {
+      value = values[i];
+      break;
+    }
+  }
+  return value;
+}
+
+SdlVideoOutput::SdlVideoOutput(SDL_Renderer* p_renderer, int p_pixel_size) {
+  renderer_ = p_renderer;
+  pixel_size_ = p_pixel_size;
+  uploaded_generation_ = -1;
+
+  Display display;
+  texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 
+    display.get_pixel_width(), display.get_pixel_height());
+  if (texture_ == nullptr) {
+    std::cout << "Unable to create display texture: " << SDL_GetError() << std::endl;
+  }
+}
+
+SdlVideoOutput::~SdlVideoOutput() {
+  if (texture_ != nullptr) {
+    SDL_DestroyTexture(texture_);
+  }
+}
+
+void SdlVideoOutput::Present(const Display& p_display) {
+  if (texture_ != nullptr) {
+    if (p_display.get_generation() != uploaded_generation_) {
+      Upload(p_display);
+    }
+
+    SDL_Rect destination{
+      0,
+      0,
+      p_display.get_pixel_width() * pixel_size_,
+      p_display.get_pixel_height() * pixel_size_
+    };
+    SDL_RenderCopy(renderer_, texture_, nullptr, &destination);
+  }
+}
+
+void SdlVideoOutput::Upload(const Display& p_display) {
+  void* pixels;
+  int pitch;
+  if (SDL_LockTexture(texture_, nullptr, &pixels, &pitch) == 0) {
+    int width = p_display.get_pixel_width();
+    for (int i = 0; i < p_display.get_pixel_height(); i++) {
+      uint32_t* texels = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + i * pitch);
+      uint64_t row = p_display.GetRow(i);
+      for (int j = 0; j < width; j++) {
+        // Column 0 is the most significant bit of the row.
+        texels[j] = ((row >> (width - 1 - j)) & 1) ? 0xFFFFFFFF : 0xFF000000;
+      }
+    }
+    SDL_UnlockTexture(texture_);
+    uploaded_generation_ = p_display.get_generation();
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef SDL_FRONTEND_HPP
+#define SDL_FRONTEND_HPP
+
+#include "frontend.hpp"
+
+#include <SDL.h>
+
+/**
+ * Returns the keypad value 0x0 -> 0xF that the key with scancode p_code is mapped to, or -1 if the
+ * key is not mapped. The 4x4 hex keypad maps to keys 1-4, q-r, a-f, z-v on a qwerty keyboard.
+ */
+int keypad_value(SDL_Scancode p_code);
+
+/**
+ * Video output that keeps the display in a 64x32 streaming texture and draws it to an SDL renderer
+ * with a single scaled copy, each display pixel becoming a p_pixel_size sized square.
+ */
+class SdlVideoOutput : public VideoOutput {
+
+public:
+
+  SdlVideoOutput(SDL_Renderer* p_renderer, int p_pixel_size);
+
+  ~SdlVideoOutput();
+
+  SdlVideoOutput(const SdlVideoOutput&) = delete;
+  SdlVideoOutput& operator=(const SdlVideoOutput&) = delete;
+
+  /**
+   * Renders p_display with enabled pixels in white and the rest in black. The texture is only 
+   * uploaded again when the display changed since the last call. Presenting the renderer is left
+   * to the caller, so other panels can be drawn in the same frame.
+   */
+  void Present(const Display& p_display);
+
+private:
+
+  /**
+   * The renderer used to draw on.
+   */
+  SDL_Renderer* renderer_;
+
+  /**
+   * Streaming texture holding one texel per display pixel, or nullptr if it could not be created.
+   */
+  SDL_Texture* texture_;
+
+  /**
+   * Width and height in screen pixels of a single display pixel.
+   */
+  int pixel_size_;
+
+  /**
+   * Generation of the display the texture was last uploaded from, -1 before the first upload.
+   */
+  long long uploaded_generation_;
+
+  /**
+   * Expands the packed rows of p_display into the texture.
+   */
+  void Upload(const Display& p_display);
+};
+
+#endif
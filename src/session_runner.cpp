@@ -0,0 +1,206 @@
+#include "session_runner.hpp"
+
+#include "emu.hpp"
+#include "save_state.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+/**
+ * A session while it is being run.
+ */
+struct RunningSession {
+  const Session* session;
+  SessionResult* result;
+  std::unique_ptr<Emu> emu;
+  std::vector<InputEvent> events;
+  int next_event = 0;
+};
+
+/**
+ * Returns true if p_line holds nothing but whitespace or a # comment.
+ */
+static bool skip_line(const std::string& p_line) {
+  size_t start = p_line.find_first_not_of(" \t\r");
+  return start == std::string::npos || p_line[start] == '#';
+}
+
+bool read_manifest(const std::string& p_path, std::vector<Session>& p_sessions, 
+                   std::string& p_error) {
+  std::ifstream file(p_path);
+  if (!file) {
+    p_error = "unable to open " + p_path;
+    return false;
+  }
+
+  std::string line;
+  for (int line_number = 1; std::getline(file, line); line_number++) {
+    if (skip_line(line)) {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    Session session;
+    session.seed = Emu::DEFAULT_RANDOM_SEED;
+    if (!(fields >> session.name >> session.rom_path >> session.frames) || session.frames < 0) {
+      p_error = p_path + ":" + std::to_string(line_number) + ": expected <name> <rom> <frames>";
+      return false;
+    }
+
+    // The input script and seed are optional.
+    std::string input_path;
+    uint32_t seed;
+    if ((fields >> input_path) && input_path != "-") {
+      session.input_path = input_path;
+    }
+    if (fields >> seed) {
+      session.seed = seed;
+    }
+    p_sessions.push_back(session);
+  }
+  return true;
+}
+
+bool read_input_script(const std::string& p_path, std::vector<InputEvent>& p_events) {
+  std::ifstream file(p_path);
+  if (!file) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (skip_line(line)) {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    InputEvent event;
+    std::string action;
+    if (!(fields >> event.frame >> action >> std::hex >> event.key) 
+        || (action != "down" && action != "up")) {
+      return false;
+    }
+    event.down = action == "down";
+    p_events.push_back(event);
+  }
+
+  std::stable_sort(p_events.begin(), p_events.end(), 
+    [](const InputEvent& a, const InputEvent& b) { return a.frame < b.frame; });
+  return true;
+}
+
+/**
+ * Creates the emulator of p_running and loads its rom and input script. Returns false if either 
+ * can not be read.
+ */
+static bool start_session(RunningSession& p_running) {
+  const Session& session = *p_running.session;
+  std::ifstream rom_file(session.rom_path, std::ios::binary);
+  if (!rom_file) {
+    p_running.result->error = "unable to open " + session.rom_path;
+    return false;
+  }
+  std::vector<uint8_t> rom((std::istreambuf_iterator<char>(rom_file)), 
+                           std::istreambuf_iterator<char>());
+
+  if (!session.input_path.empty() && !read_input_script(session.input_path, p_running.events)) {
+    p_running.result->error = "unable to read input script " + session.input_path;
+    return false;
+  }
+
+  p_running.emu.reset(new Emu());
+  p_running.emu->set_random_seed(session.seed);
+  p_running.emu->LoadRom(rom.data(), rom.size());
+  return true;
+}
+
+/**
+ * Runs the next slice of p_running and queues the one after it, until the session is done.
+ */
+static void run_slice(WorkStealingPool& p_pool, RunningSession& p_running, 
+                      const RunnerOptions& p_options) {
+  auto start = std::chrono::steady_clock::now();
+  SessionResult& result = *p_running.result;
+
+  if (!p_running.emu && !start_session(p_running)) {
+    result.ok = false;
+    return;
+  }
+
+  Emu& emu = *p_running.emu;
+  int end = std::min(result.frames + p_options.slice_frames, p_running.session->frames);
+  for (; result.frames < end; result.frames++) {
+    while (p_running.next_event < (int)p_running.events.size() 
+           && p_running.events[p_running.next_event].frame <= result.frames) {
+      const InputEvent& event = p_running.events[p_running.next_event++];
+      if (event.down) {
+        emu.KeyDown(event.key);
+      } else {
+        emu.KeyUp(event.key);
+      }
+    }
+    RunSummary summary = emu.RunFrame(p_options.instructions_per_frame);
+    result.cycles += summary.instructions;
+    result.instructions += summary.executed;
+  }
+  result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (result.frames < p_running.session->frames) {
+    p_pool.Submit([&p_pool, &p_running, &p_options] { run_slice(p_pool, p_running, p_options); });
+    return;
+  }
+
+  // Done, keep the result and let go of the emulator.
+  result.program_counter = emu.get_program_counter();
+  uint64_t rows[32];
+  for (int row = 0; row < 32; row++) {
+    rows[row] = emu.get_display().GetRow(row);
+  }
+  result.display_hash = state_checksum(rows, sizeof(rows));
+  p_running.emu.reset();
+}
+
+RunnerReport run_sessions(const std::vector<Session>& p_sessions, const RunnerOptions& p_options) {
+  RunnerReport report;
+  report.results.resize(p_sessions.size());
+  std::vector<RunningSession> running(p_sessions.size());
+  for (int i = 0; i < (int)p_sessions.size(); i++) {
+    SessionResult& result = report.results[i];
+    result.name = p_sessions[i].name;
+    result.ok = true;
+    result.frames = 0;
+    result.cycles = 0;
+    result.instructions = 0;
+    result.program_counter = 0;
+    result.display_hash = 0;
+    result.seconds = 0;
+    running[i].session = &p_sessions[i];
+    running[i].result = &result;
+  }
+
+  RunnerOptions options = p_options;
+  options.slice_frames = std::max(1, options.slice_frames);
+
+  auto start = std::chrono::steady_clock::now();
+  WorkStealingPool pool(options.threads);
+  for (RunningSession& session : running) {
+    pool.Submit([&pool, &session, &options] { run_slice(pool, session, options); });
+  }
+  pool.Wait();
+  report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  report.threads = pool.get_thread_count();
+  report.steals = pool.get_steal_count();
+  report.cycles = 0;
+  report.instructions = 0;
+  for (const SessionResult& result : report.results) {
+    report.cycles += result.cycles;
+    report.instructions += result.instructions;
+  }
+  return report;
+}
@@ -0,0 +1,128 @@
+#ifndef SESSION_RUNNER_HPP
+#define SESSION_RUNNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A key press or release delivered at the start of a frame.
+ */
+struct InputEvent {
+  int frame;
+  int key;
+  bool down;
+};
+
+/**
+ * One headless run of a rom, read from a line of a manifest.
+ */
+struct Session {
+  std::string name;
+  std::string rom_path;
+
+  /**
+   * Input script played into the session, empty for none.
+   */
+  std::string input_path;
+
+  /**
+   * Number of 60hz frames to run.
+   */
+  int frames;
+
+  /**
+   * Seed of the session's random number generator.
+   */
+  uint32_t seed;
+};
+
+/**
+ * What a session ended up doing.
+ */
+struct SessionResult {
+  std::string name;
+
+  /**
+   * False if the rom or input script could not be loaded, error says why.
+   */
+  bool ok;
+  std::string error;
+
+  int frames;
+
+  /**
+   * Instruction cycles run, including cycles waiting on Fx0A and skipped idle loops.
+   */
+  long long cycles;
+
+  /**
+   * Instructions actually executed, the cycles without those waiting on Fx0A or skipped.
+   */
+  long long instructions;
+
+  int program_counter;
+
+  /**
+   * Checksum of the final display, for comparing runs.
+   */
+  uint32_t display_hash;
+
+  /**
+   * Time spent running the session, summed over all of its slices.
+   */
+  double seconds;
+};
+
+/**
+ * Settings for run_sessions.
+ */
+struct RunnerOptions {
+  /**
+   * Worker threads, less than 1 for one per hardware thread.
+   */
+  int threads = 0;
+
+  /**
+   * Frames a session runs before it goes back in the queue, so long sessions do not hold up a 
+   * worker while others wait.
+   */
+  int slice_frames = 60;
+
+  int instructions_per_frame = 9;
+};
+
+/**
+ * Results of run_sessions, with one result per session in manifest order.
+ */
+struct RunnerReport {
+  std::vector<SessionResult> results;
+  int threads;
+  long long cycles;
+  long long instructions;
+  double seconds;
+  long long steals;
+};
+
+/**
+ * Reads a manifest from p_path into p_sessions. Every line that is not blank or a # comment holds
+ * a session: "<name> <rom> <frames> [<input script>|-] [<seed>]". Returns false and describes the
+ * problem in p_error if a line can not be parsed.
+ */
+bool read_manifest(const std::string& p_path, std::vector<Session>& p_sessions, 
+                   std::string& p_error);
+
+/**
+ * Reads an input script from p_path into p_events. Every line that is not blank or a # comment 
+ * holds an event: "<frame> down|up <key in hex>". Events are sorted by frame. Returns false if the
+ * file can not be read or a line can not be parsed.
+ */
+bool read_input_script(const std::string& p_path, std::vector<InputEvent>& p_events);
+
+/**
+ * Runs every session in p_sessions on its own headless emulator, spread over a work stealing pool 
+ * in slices of p_options.slice_frames frames.
+ */
+RunnerReport run_sessions(const std::vector<Session>& p_sessions, const RunnerOptions& p_options);
+
+#endif
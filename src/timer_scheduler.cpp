@@ -0,0 +1,76 @@
+#include "timer_scheduler.hpp"
+
+const int TimerScheduler::TIMER_FREQUENCY;
+const int TimerScheduler::DEFAULT_CLOCK_SPEED;
+
+TimerScheduler::TimerScheduler() {
+  mode_ = VIRTUAL_CLOCK;
+  clock_speed_ = DEFAULT_CLOCK_SPEED;
+  phase_ = 0;
+  cycle_count_ = 0;
+  last_tick_time_ = std::chrono::steady_clock::now();
+}
+
+int TimerScheduler::CyclesUntilTick() const {
+  // Round up, so the tick lands after the instruction that crosses it.
+  return (clock_speed_ - phase_ + TIMER_FREQUENCY - 1) / TIMER_FREQUENCY;
+}
+
+int TimerScheduler::Advance(int p_cycles) {
+  cycle_count_ += p_cycles;
+
+  int ticks = 0;
+  if (mode_ == VIRTUAL_CLOCK) {
+    phase_ += p_cycles * TIMER_FREQUENCY;
+    ticks = phase_ / clock_speed_;
+    phase_ %= clock_speed_;
+  } else {
+    const std::chrono::nanoseconds period(1000000000 / TIMER_FREQUENCY);
+    auto elapsed = std::chrono::steady_clock::now() - last_tick_time_;
+    ticks = elapsed / period;
+    last_tick_time_ += ticks * period;
+  }
+  return ticks;
+}
+
+void TimerScheduler::CountCycles(int p_cycles) {
+  cycle_count_ += p_cycles;
+}
+
+void TimerScheduler::set_mode(Mode p_mode) {
+  mode_ = p_mode;
+  last_tick_time_ = std::chrono::steady_clock::now();
+}
+
+TimerScheduler::Mode TimerScheduler::get_mode() const {
+  return mode_;
+}
+
+void TimerScheduler::set_clock_speed(int p_hertz) {
+  if (p_hertz > 0) {
+    clock_speed_ = p_hertz;
+    phase_ = 0;
+  }
+}
+
+int TimerScheduler::get_clock_speed() const {
+  return clock_speed_;
+}
+
+long long TimerScheduler::get_cycle_count() const {
+  return cycle_count_;
+}
+
+void TimerScheduler::set_cycle_count(long long p_cycle_count) {
+  cycle_count_ = p_cycle_count;
+}
+
+int TimerScheduler::get_phase() const {
+  return phase_;
+}
+
+void TimerScheduler::set_phase(int p_phase) {
+  if (p_phase >= 0 && p_phase < clock_speed_) {
+    phase_ = p_phase;
+  }
+}
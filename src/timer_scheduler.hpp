@@ -0,0 +1,116 @@
+#ifndef TIMER_SCHEDULER_HPP
+#define TIMER_SCHEDULER_HPP
+
+#include <chrono>
+
+/**
+ * Decides when the 60hz delay and sound timers tick while instructions are being run. By default
+ * ticks are derived from the number of instructions executed at a fixed clock speed, a virtual
+ * clock, so the same program always sees the same timer values at the same instruction. For 
+ * interactive play the scheduler can instead follow the host's wall clock.
+ */
+class TimerScheduler {
+
+public:
+
+  /**
+   * Where timer ticks come from.
+   */
+  enum Mode {
+    VIRTUAL_CLOCK, // One tick every clock_speed / 60 executed instructions.
+    WALL_CLOCK,    // One tick every 1/60th of a second of real time.
+  };
+
+  /**
+   * Rate in hertz the delay and sound timers count down at.
+   */
+  const static int TIMER_FREQUENCY = 60;
+
+  /**
+   * Default number of instructions executed per second of virtual time.
+   */
+  const static int DEFAULT_CLOCK_SPEED = 540;
+
+  TimerScheduler();
+
+  /**
+   * Returns how many instructions can run before the next tick is due on the virtual clock, always
+   * at least 1. Also used to split up work in WALL_CLOCK mode, so the wall clock is checked about 
+   * as often as a tick would be due.
+   */
+  int CyclesUntilTick() const;
+
+  /**
+   * Records that p_cycles instructions ran and returns the number of timer ticks that became due.
+   */
+  int Advance(int p_cycles);
+
+  /**
+   * Records that p_cycles instructions ran without touching the progress towards the next tick,
+   * for callers that tick the timers themselves.
+   */
+  void CountCycles(int p_cycles);
+
+  /**
+   * Sets where timer ticks come from. Switching to WALL_CLOCK starts timing from now.
+   */
+  void set_mode(Mode p_mode);
+
+  /**
+   * Returns where timer ticks come from.
+   */
+  Mode get_mode() const;
+
+  /**
+   * Sets the number of instructions per second of virtual time and restarts the progress towards 
+   * the next tick. Values below 1 are ignored.
+   */
+  void set_clock_speed(int p_hertz);
+
+  /**
+   * Returns the number of instructions per second of virtual time.
+   */
+  int get_clock_speed() const;
+
+  /**
+   * Returns the total number of instructions recorded since the scheduler was created.
+   */
+  long long get_cycle_count() const;
+
+  /**
+   * Overwrites the total instruction count, used when restoring a saved state.
+   */
+  void set_cycle_count(long long p_cycle_count);
+
+  /**
+   * Returns the progress towards the next virtual clock tick, in 1/TIMER_FREQUENCY instructions.
+   */
+  int get_phase() const;
+
+  /**
+   * Sets the progress towards the next virtual clock tick. Values outside 0 -> clock speed - 1 are
+   * ignored.
+   */
+  void set_phase(int p_phase);
+
+private:
+
+  Mode mode_;
+
+  int clock_speed_;
+
+  /**
+   * Progress towards the next virtual clock tick, in 1/TIMER_FREQUENCY instruction units. A tick
+   * is due when it reaches clock_speed_.
+   */
+  int phase_;
+
+  long long cycle_count_;
+
+  /**
+   * Wall clock time of the last tick in WALL_CLOCK mode.
+   */
+  std::chrono::steady_clock::time_point last_tick_time_;
+};
+
+#endif
@@ -0,0 +1,275 @@
+#include "trace_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const uint8_t TraceRecord::NO_REGISTER;
+const int TraceRecorder::DEFAULT_CAPACITY;
+
+/**
+ * Header written in front of the records in a trace file.
+ */
+struct TraceFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t reserved;
+};
+
+static const char TRACE_FILE_MAGIC[4] = { 'C', '8', 'T', 'R' };
+
+/**
+ * Bytes of a memory mapped trace mapped at a time. The file grows by this much whenever the
+ * current window fills up.
+ */
+static const long long MAP_WINDOW_SIZE = 64 << 20;
+
+/**
+ * Records read from a trace file at a time.
+ */
+static const int READ_BUFFER_RECORDS = 1 << 14;
+
+int traced_register(const Instruction& p_instruction) {
+  switch (p_instruction.type) {
+    case OP_SET_REGISTER:
+    case OP_ADD_VALUE:
+    case OP_COPY_REGISTER:
+    case OP_OR:
+    case OP_AND:
+    case OP_XOR:
+    case OP_ADD_REGISTERS:
+    case OP_SUBTRACT:
+    case OP_SHIFT_RIGHT:
+    case OP_SUBTRACT_REVERSE:
+    case OP_SHIFT_LEFT:
+    case OP_RANDOM:
+    case OP_GET_DELAY:
+    case OP_READ_REGISTERS:
+      return p_instruction.x;
+    default:
+      return TraceRecord::NO_REGISTER;
+  }
+}
+
+TraceRecorder::TraceRecorder(int p_capacity) {
+  capacity_ = 1;
+  while (capacity_ < p_capacity) {
+    capacity_ <<= 1;
+  }
+  ring_.resize(capacity_);
+  head_ = 0;
+  tail_ = 0;
+  cached_tail_ = 0;
+  stalls_ = 0;
+  closing_ = false;
+  failed_ = false;
+  open_ = false;
+  mapped_file_ = -1;
+  mapping_ = nullptr;
+  mapped_offset_ = 0;
+  mapped_size_ = 0;
+  file_size_ = 0;
+}
+
+TraceRecorder::~TraceRecorder() {
+  Close();
+}
+
+bool TraceRecorder::Open(const std::string& p_path, bool p_memory_map) {
+  if (open_) {
+    return false;
+  }
+
+#ifndef _WIN32
+  if (p_memory_map) {
+    mapped_file_ = open(p_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (mapped_file_ < 0) {
+      return false;
+    }
+  }
+#endif
+  if (mapped_file_ < 0) {
+    file_.open(p_path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+      return false;
+    }
+  }
+
+  head_ = 0;
+  tail_ = 0;
+  cached_tail_ = 0;
+  stalls_ = 0;
+  closing_ = false;
+  failed_ = false;
+  file_size_ = 0;
+
+  TraceFileHeader header;
+  std::memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_FILE_VERSION;
+  header.record_size = sizeof(TraceRecord);
+  header.reserved = 0;
+  failed_ = !Write(&header, sizeof(header));
+
+  open_ = true;
+  drain_thread_ = std::thread(&TraceRecorder::Drain, this);
+  return true;
+}
+
+bool TraceRecorder::Close() {
+  if (!open_) {
+    return true;
+  }
+  closing_.store(true, std::memory_order_release);
+  drain_thread_.join();
+  open_ = false;
+
+#ifndef _WIN32
+  if (mapped_file_ >= 0) {
+    Unmap();
+    // Cut off the unused part of the last window.
+    if (ftruncate(mapped_file_, file_size_) != 0) {
+      failed_ = true;
+    }
+    close(mapped_file_);
+    mapped_file_ = -1;
+    return !failed_;
+  }
+#endif
+  file_.close();
+  return !failed_ && !file_.fail();
+}
+
+bool TraceRecorder::is_open() {
+  return open_;
+}
+
+long long TraceRecorder::get_record_count() {
+  return head_.load(std::memory_order_relaxed);
+}
+
+long long TraceRecorder::get_stall_count() {
+  return stalls_;
+}
+
+void TraceRecorder::WaitForSpace(long long p_head) {
+  stalls_++;
+  for (int spins = 0; ; spins++) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (p_head - cached_tail_ < capacity_) {
+      return;
+    }
+    if (spins > 64) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void TraceRecorder::Drain() {
+  long long tail = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    // Read closing_ first, so a head read after it holds every record added before Close.
+    bool closing = closing_.load(std::memory_order_acquire);
+    long long head = head_.load(std::memory_order_acquire);
+    if (head == tail) {
+      if (closing) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+
+    // Write up to the end of the ring, the rest goes on the next pass.
+    long long start = tail & (capacity_ - 1);
+    long long count = std::min(head - tail, capacity_ - start);
+    if (!failed_ && !Write(&ring_[start], count * sizeof(TraceRecord))) {
+      failed_ = true;
+    }
+    tail += count;
+    tail_.store(tail, std::memory_order_release);
+  }
+}
+
+bool TraceRecorder::Write(const void* p_data, long long p_size) {
+  if (mapped_file_ >= 0) {
+    return WriteMapped(p_data, p_size);
+  }
+  file_.write(static_cast<const char*>(p_data), p_size);
+  file_size_ += p_size;
+  return static_cast<bool>(file_);
+}
+
+bool TraceRecorder::WriteMapped(const void* p_data, long long p_size) {
+#ifndef _WIN32
+  const uint8_t* data = static_cast<const uint8_t*>(p_data);
+  while (p_size > 0) {
+    if (!mapping_ || file_size_ >= mapped_offset_ + mapped_size_) {
+      Unmap();
+      mapped_offset_ = file_size_ / MAP_WINDOW_SIZE * MAP_WINDOW_SIZE;
+      if (ftruncate(mapped_file_, mapped_offset_ + MAP_WINDOW_SIZE) != 0) {
+        return false;
+      }
+      void* mapping = mmap(nullptr, MAP_WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           mapped_file_, mapped_offset_);
+      if (mapping == MAP_FAILED) {
+        return false;
+      }
+      mapping_ = static_cast<uint8_t*>(mapping);
+      mapped_size_ = MAP_WINDOW_SIZE;
+    }
+
+    long long offset = file_size_ - mapped_offset_;
+    long long size = std::min(p_size, mapped_size_ - offset);
+    std::memcpy(mapping_ + offset, data, size);
+    data += size;
+    p_size -= size;
+    file_size_ += size;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void TraceRecorder::Unmap() {
+#ifndef _WIN32
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+    mapping_ = nullptr;
+    mapped_size_ = 0;
+  }
+#endif
+}
+
+bool TraceReader::Open(const std::string& p_path) {
+  file_.open(p_path, std::ios::binary);
+  TraceFileHeader header;
+  if (!file_.read(reinterpret_cast<char*>(&header), sizeof(header))
+      || std::memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0
+      || header.version != TRACE_FILE_VERSION || header.record_size != sizeof(TraceRecord)) {
+    return false;
+  }
+  buffer_.clear();
+  next_ = 0;
+  return true;
+}
+
+bool TraceReader::Next(TraceRecord& p_record) {
+  if (next_ == buffer_.size()) {
+    buffer_.resize(READ_BUFFER_RECORDS);
+    file_.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size() * sizeof(TraceRecord));
+    buffer_.resize(file_.gcount() / sizeof(TraceRecord));
+    next_ = 0;
+    if (buffer_.empty()) {
+      return false;
+    }
+  }
+  p_record = buffer_[next_++];
+  return true;
+}
@@ -0,0 +1,248 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include "opcode.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * One executed instruction, as written to a trace file.
+ */
+struct TraceRecord {
+  /**
+   * Value of changed_register when the instruction writes no register.
+   */
+  const static uint8_t NO_REGISTER = 0xFF;
+
+  /**
+   * Address the instruction was fetched from.
+   */
+  uint16_t program_counter;
+
+  uint16_t opcode;
+
+  /**
+   * Index register after the instruction.
+   */
+  uint16_t index_register;
+
+  /**
+   * Register the instruction wrote, or NO_REGISTER. Fx65 writes V0 up to this register.
+   */
+  uint8_t changed_register;
+
+  /**
+   * Value of changed_register after the instruction, 0 if there is none.
+   */
+  uint8_t changed_value;
+
+  /**
+   * VF after the instruction.
+   */
+  uint8_t flag_register;
+
+  /**
+   * Pads the record to a multiple of its alignment, always 0.
+   */
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(TraceRecord) == 12, "TraceRecord layout changed, bump TRACE_FILE_VERSION");
+
+/**
+ * Layout version of trace files. Bumped every time TraceRecord or the header changes.
+ */
+const uint32_t TRACE_FILE_VERSION = 1;
+
+/**
+ * Returns the register p_instruction writes, which is what a trace records as changed, or
+ * TraceRecord::NO_REGISTER if it writes none. VF written as a flag is not counted, since every
+ * record holds VF anyway.
+ */
+int traced_register(const Instruction& p_instruction);
+
+/**
+ * Writes a trace of executed instructions to a file without slowing the emulator down much. The
+ * emulating thread puts records into a lock-free single producer, single consumer ring, and a
+ * background thread drains the ring to the file in large runs. The emulator waits when the ring is
+ * full, so no record is ever dropped.
+ */
+class TraceRecorder {
+
+public:
+
+  /**
+   * Default number of records the ring holds.
+   */
+  const static int DEFAULT_CAPACITY = 1 << 16;
+
+  /**
+   * Makes a recorder with a ring of p_capacity records, rounded up to a power of two.
+   */
+  explicit TraceRecorder(int p_capacity = DEFAULT_CAPACITY);
+
+  /**
+   * Closes the trace if it is still open.
+   */
+  ~TraceRecorder();
+
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  /**
+   * Creates the trace file p_path and starts the thread draining into it. With p_memory_map the
+   * file is grown in large steps and records are copied into mappings of it instead of being
+   * written, where the platform supports it. Returns false if the file can not be created or a
+   * trace is already open.
+   */
+  bool Open(const std::string& p_path, bool p_memory_map);
+
+  /**
+   * Adds p_record to the trace. Only ever called from one thread at a time.
+   */
+  void Record(const TraceRecord& p_record) {
+    long long head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ >= capacity_) {
+      WaitForSpace(head);
+    }
+    ring_[head & (capacity_ - 1)] = p_record;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * Drains every record into the file, stops the draining thread and closes the file. Returns
+   * false if any of the trace could not be written.
+   */
+  bool Close();
+
+  /**
+   * Returns true while a trace is open.
+   */
+  bool is_open();
+
+  /**
+   * Returns the number of records added since the trace was opened.
+   */
+  long long get_record_count();
+
+  /**
+   * Returns the number of times Record had to wait for the ring to drain.
+   */
+  long long get_stall_count();
+
+private:
+
+  std::vector<TraceRecord> ring_;
+
+  /**
+   * Number of records in the ring, a power of two.
+   */
+  long long capacity_;
+
+  /**
+   * Number of records ever added, written by the emulating thread only.
+   */
+  alignas(64) std::atomic<long long> head_;
+
+  /**
+   * Last value of tail_ seen by the emulating thread, so it only has to read the other thread's
+   * cache line when the ring looks full.
+   */
+  long long cached_tail_;
+
+  long long stalls_;
+
+  /**
+   * Number of records ever drained, written by the draining thread only.
+   */
+  alignas(64) std::atomic<long long> tail_;
+
+  std::atomic<bool> closing_;
+
+  std::thread drain_thread_;
+
+  /**
+   * Set by the draining thread if a write fails.
+   */
+  bool failed_;
+
+  bool open_;
+
+  std::ofstream file_;
+
+  /**
+   * File descriptor of a memory mapped trace, or -1 when writing through file_.
+   */
+  int mapped_file_;
+
+  /**
+   * Current mapping of the file, mapped_size_ bytes long starting at mapped_offset_.
+   */
+  uint8_t* mapping_;
+  long long mapped_offset_;
+  long long mapped_size_;
+
+  /**
+   * Bytes of the file written so far, header included.
+   */
+  long long file_size_;
+
+  /**
+   * Spins, then yields, until the draining thread has made room for the record at p_head.
+   */
+  void WaitForSpace(long long p_head);
+
+  /**
+   * Body of the draining thread.
+   */
+  void Drain();
+
+  /**
+   * Appends p_size bytes at p_data to the file.
+   */
+  bool Write(const void* p_data, long long p_size);
+
+  /**
+   * Appends p_size bytes at p_data to the memory mapped file, mapping the next window as needed.
+   */
+  bool WriteMapped(const void* p_data, long long p_size);
+
+  /**
+   * Unmaps the current window, if any.
+   */
+  void Unmap();
+};
+
+/**
+ * Reads the records of a trace file one at a time, buffering large runs of them.
+ */
+class TraceReader {
+
+public:
+
+  /**
+   * Opens the trace file p_path. Returns false if it can not be read or is not a trace file of
+   * this version.
+   */
+  bool Open(const std::string& p_path);
+
+  /**
+   * Reads the next record into p_record. Returns false at the end of the trace.
+   */
+  bool Next(TraceRecord& p_record);
+
+private:
+
+  std::ifstream file_;
+
+  std::vector<TraceRecord> buffer_;
+
+  size_t next_ = 0;
+};
+
+#endif
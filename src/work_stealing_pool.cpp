@@ -0,0 +1,117 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+/**
+ * The pool and worker index of the calling thread, if it is a pool worker.
+ */
+static thread_local WorkStealingPool* current_pool = nullptr;
+static thread_local int current_worker = -1;
+
+WorkStealingPool::WorkStealingPool(int p_threads) {
+  int threads = p_threads;
+  if (threads < 1) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  pending_ = 0;
+  queued_ = 0;
+  steals_ = 0;
+  next_queue_ = 0;
+  stopping_ = false;
+
+  for (int i = 0; i < threads; i++) {
+    queues_.emplace_back(new WorkQueue());
+  }
+  for (int i = 0; i < threads; i++) {
+    threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Submit(Task p_task) {
+  int index = current_worker;
+  if (current_pool != this) {
+    index = next_queue_++ % queues_.size();
+  }
+
+  pending_++;
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(p_task));
+  }
+  queued_++;
+
+  // Taking the lock orders the notify after any worker that is just about to go to sleep.
+  std::lock_guard<std::mutex> lock(idle_mutex_);
+  work_available_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+  std::unique_lock<std::mutex> lock(idle_mutex_);
+  all_done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+int WorkStealingPool::get_thread_count() const {
+  return threads_.size();
+}
+
+long long WorkStealingPool::get_steal_count() const {
+  return steals_;
+}
+
+void WorkStealingPool::WorkerLoop(int p_index) {
+  current_pool = this;
+  current_worker = p_index;
+
+  while (true) {
+    Task task;
+    if (TakeTask(p_index, task)) {
+      task();
+      if (--pending_ == 0) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        all_done_.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    work_available_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+    if (stopping_ && queued_ == 0) {
+      break;
+    }
+  }
+}
+
+bool WorkStealingPool::TakeTask(int p_index, Task& p_task) {
+  int count = queues_.size();
+  for (int i = 0; i < count; i++) {
+    WorkQueue& queue = *queues_[(p_index + i) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+
+    if (i == 0) {
+      p_task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      p_task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      steals_++;
+    }
+    queued_--;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,119 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads that run submitted tasks. Every worker has a deque of its own. Tasks
+ * submitted from inside a task go on the back of the submitting worker's deque and the worker takes
+ * its next task from the back too, so follow-up work stays on the thread whose caches already hold
+ * its data. A worker that runs dry steals from the front of another worker's deque.
+ */
+class WorkStealingPool {
+
+public:
+
+  typedef std::function<void()> Task;
+
+  /**
+   * Starts p_threads workers, or one per hardware thread if p_threads is less than 1.
+   */
+  explicit WorkStealingPool(int p_threads);
+
+  /**
+   * Finishes every queued task, then stops and joins the workers.
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * Queues p_task. Called from one of the pool's own tasks it goes on that worker's deque, 
+   * otherwise the deques are filled round robin.
+   */
+  void Submit(Task p_task);
+
+  /**
+   * Blocks until every submitted task, including tasks submitted by other tasks, has finished.
+   */
+  void Wait();
+
+  /**
+   * Returns the number of worker threads.
+   */
+  int get_thread_count() const;
+
+  /**
+   * Returns the number of tasks a worker took from another worker's deque.
+   */
+  long long get_steal_count() const;
+
+private:
+
+  /**
+   * A worker's deque of tasks and the lock guarding it.
+   */
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+  std::vector<std::thread> threads_;
+
+  /**
+   * Guards sleeping and waking, for both idle workers and Wait.
+   */
+  std::mutex idle_mutex_;
+
+  /**
+   * Signalled when a task is queued or the pool is stopping.
+   */
+  std::condition_variable work_available_;
+
+  /**
+   * Signalled when the last pending task finishes.
+   */
+  std::condition_variable all_done_;
+
+  /**
+   * Tasks submitted but not yet finished.
+   */
+  std::atomic<long long> pending_;
+
+  /**
+   * Tasks sitting in a deque, waiting for a worker.
+   */
+  std::atomic<long long> queued_;
+
+  std::atomic<long long> steals_;
+
+  /**
+   * Deque the next task submitted from outside the pool goes on.
+   */
+  std::atomic<unsigned> next_queue_;
+
+  bool stopping_;
+
+  /**
+   * Body of worker thread p_index.
+   */
+  void WorkerLoop(int p_index);
+
+  /**
+   * Takes a task for worker p_index, from the back of its own deque or else stolen from the front 
+   * of another one. Returns false if every deque is empty.
+   */
+  bool TakeTask(int p_index, Task& p_task);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+
+TEST_CASE("Testing block cache hits on a loop", "[blocks]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::BLOCK_ENGINE);
+
+  // V0 += 1, V1 += 2, jump back to the start.
+  emu.LoadInstruction(0x200, 0x7001);
+  emu.LoadInstruction(0x202, 0x7102);
+  emu.LoadInstruction(0x204, 0x1200);
+  emu.set_program_counter(0x200);
+
+  REQUIRE(emu.ExecuteBatch(30) == 30);
+
+  BlockCacheStats stats = emu.get_block_cache_stats();
+  REQUIRE(stats.misses == 1);
+  REQUIRE(stats.hits == 9);
+  REQUIRE(stats.invalidations == 0);
+  REQUIRE(emu.get_register(0) == 10);
+  REQUIRE(emu.get_register(1) == 20);
+}
+
+TEST_CASE("Testing set memory invalidates only overlapping blocks", "[blocks]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::BLOCK_ENGINE);
+  emu.LoadInstruction(0x200, 0x6005);
+  emu.LoadInstruction(0x202, 0x1200);
+  emu.set_program_counter(0x200);
+  emu.ExecuteBatch(2);
+
+  // Writing outside the block leaves it alone.
+  emu.set_memory(0x204, 0x12);
+  REQUIRE(emu.get_block_cache_stats().invalidations == 0);
+
+  // Rewriting the immediate of 6005 to 6007 throws the block away and takes effect.
+  emu.set_memory(0x201, 0x07);
+  REQUIRE(emu.get_block_cache_stats().invalidations == 1);
+  emu.ExecuteBatch(2);
+  REQUIRE(emu.get_register(0) == 0x07);
+}
+
+TEST_CASE("Testing block stops when it overwrites itself", "[blocks]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::BLOCK_ENGINE);
+
+  // Store V0..V1 over the instruction right after the store, which was 6155 (V1 = 0x55).
+  emu.LoadInstruction(0x200, 0x6061);
+  emu.LoadInstruction(0x202, 0x6199);
+  emu.LoadInstruction(0x204, 0xA208);
+  emu.LoadInstruction(0x206, 0xF155);
+  emu.LoadInstruction(0x208, 0x6155);
+  emu.LoadInstruction(0x20A, 0x120A);
+  emu.set_program_counter(0x200);
+
+  emu.ExecuteBatch(5);
+
+  // 6155 was replaced with 6199 before it ran, so V1 keeps 0x99.
+  REQUIRE(emu.get_block_cache_stats().invalidations == 1);
+  REQUIRE(emu.get_memory(0x208) == 0x61);
+  REQUIRE(emu.get_memory(0x209) == 0x99);
+  REQUIRE(emu.get_register(1) == 0x99);
+  REQUIRE(emu.get_program_counter() == 0x20A);
+}
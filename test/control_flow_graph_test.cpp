@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "../src/control_flow_graph.hpp"
+
+#include <vector>
+
+TEST_CASE("Testing the control flow graph finds blocks, loops and calls", "[control_flow_graph]") {
+  const uint8_t rom[] = {
+    0x60, 0x00, // 200: LD V0, 0x00
+    0x22, 0x16, // 202: CALL 0x216
+    0x70, 0x01, // 204: ADD V0, 0x01, outer loop
+    0x61, 0x00, // 206: LD V1, 0x00
+    0x71, 0x01, // 208: ADD V1, 0x01, inner loop
+    0x31, 0x05, // 20A: SE V1, 0x05
+    0x12, 0x08, // 20C: JP 0x208
+    0x30, 0x0A, // 20E: SE V0, 0x0A
+    0x12, 0x04, // 210: JP 0x204
+    0xA2, 0x18, // 212: LD I, 0x218
+    0xB2, 0x1A, // 214: JP V0, 0x21A
+    0x22, 0x18, // 216: CALL 0x218
+    0x00, 0xEE, // 218: RET
+    0xFF, 0xFF  // 21A: data
+  };
+  Disassembly disassembly = disassemble(rom, sizeof(rom));
+  ControlFlowGraph graph = build_control_flow_graph(disassembly);
+
+  std::vector<int> starts;
+  for (const BasicBlock& block : graph.blocks) {
+    starts.push_back(block.start);
+  }
+  REQUIRE(starts == std::vector<int>({ 0x200, 0x204, 0x208, 0x20C, 0x20E, 0x210, 0x212, 0x216,
+                                       0x218 }));
+  REQUIRE(graph.blocks[1].end == 0x208);
+  REQUIRE(graph.blocks[1].instructions.size() == 2);
+
+  const std::vector<CfgEdge>& call = graph.blocks[0].successors;
+  REQUIRE(call.size() == 2);
+  REQUIRE((call[0].target == 7 && call[0].kind == EDGE_CALL));
+  REQUIRE((call[1].target == 1 && call[1].kind == EDGE_NEXT));
+  const std::vector<CfgEdge>& skip = graph.blocks[4].successors;
+  REQUIRE(skip.size() == 2);
+  REQUIRE((skip[0].target == 5 && skip[0].kind == EDGE_NEXT));
+  REQUIRE((skip[1].target == 6 && skip[1].kind == EDGE_SKIP));
+  REQUIRE(graph.blocks[6].successors.empty());
+  REQUIRE(graph.blocks[6].unresolved);
+  REQUIRE(graph.blocks[8].returns);
+  REQUIRE(graph.unresolved_jumps == 1);
+  REQUIRE(graph.reachable_bytes == 0x1A);
+
+  // The inner loop sits inside the outer one.
+  REQUIRE(graph.loops.size() == 2);
+  REQUIRE(graph.max_loop_depth == 2);
+  REQUIRE(graph.blocks[0].loop_depth == 0);
+  REQUIRE(graph.blocks[1].loop_depth == 1);
+  REQUIRE(graph.blocks[3].loop_depth == 2);
+  REQUIRE(graph.blocks[6].loop_depth == 0);
+  for (const CfgLoop& loop : graph.loops) {
+    if (loop.header == 2) {
+      REQUIRE(loop.blocks == std::vector<int>({ 2, 3 }));
+      REQUIRE(loop.depth == 2);
+    } else {
+      REQUIRE(loop.header == 1);
+      REQUIRE(loop.blocks == std::vector<int>({ 1, 2, 3, 4, 5 }));
+      REQUIRE(loop.depth == 1);
+    }
+  }
+
+  // Main calls 0x216, which calls 0x218.
+  REQUIRE(graph.functions.size() == 3);
+  REQUIRE(graph.functions[0].blocks == std::vector<int>({ 0, 1, 2, 3, 4, 5, 6 }));
+  REQUIRE(graph.functions[0].callees == std::vector<int>({ 1 }));
+  REQUIRE(graph.functions[1].call_depth == 1);
+  REQUIRE(graph.functions[2].call_depth == 0);
+  REQUIRE(graph.max_call_depth == 2);
+  REQUIRE(!graph.functions[1].recursive);
+
+  REQUIRE(graph.regions.size() == 1);
+  REQUIRE(graph.regions[0].start == 0x200);
+  REQUIRE(graph.regions[0].end == 0x21A);
+  REQUIRE(graph.regions[0].read_as_data);
+}
+
+TEST_CASE("Testing recursion leaves the call depth unbounded", "[control_flow_graph]") {
+  const uint8_t rom[] = {
+    0x22, 0x04, // 200: CALL 0x204
+    0x12, 0x02, // 202: JP 0x202
+    0x30, 0x00, // 204: SE V0, 0x00
+    0x22, 0x04, // 206: CALL 0x204
+    0x00, 0xEE  // 208: RET
+  };
+  Disassembly disassembly = disassemble(rom, sizeof(rom));
+  ControlFlowGraph graph = build_control_flow_graph(disassembly);
+
+  REQUIRE(graph.functions.size() == 2);
+  REQUIRE(graph.functions[1].recursive);
+  REQUIRE(graph.functions[1].call_depth == -1);
+  REQUIRE(graph.max_call_depth == -1);
+  REQUIRE(graph.loops.size() == 1);
+  REQUIRE(graph.blocks[graph.loops[0].header].start == 0x202);
+  REQUIRE(graph.regions.size() == 1);
+  REQUIRE(!graph.regions[0].read_as_data);
+}
+
+TEST_CASE("Testing every function on a cycle of calls is recursive", "[control_flow_graph]") {
+  const uint8_t rom[] = {
+    0x22, 0x06, // 200: CALL 0x206, main calls A
+    0x22, 0x12, // 202: CALL 0x212, then D
+    0x12, 0x04, // 204: JP 0x204
+    0x22, 0x0A, // 206: A: CALL 0x20A
+    0x00, 0xEE, // 208: RET
+    0x22, 0x0E, // 20A: B: CALL 0x20E
+    0x00, 0xEE, // 20C: RET
+    0x22, 0x06, // 20E: C: CALL 0x206, back to A
+    0x00, 0xEE, // 210: RET
+    0x00, 0xEE  // 212: D: RET
+  };
+  Disassembly disassembly = disassemble(rom, sizeof(rom));
+  ControlFlowGraph graph = build_control_flow_graph(disassembly);
+
+  REQUIRE(graph.functions.size() == 5);
+  for (const CfgFunction& function : graph.functions) {
+    int entry = graph.blocks[function.entry].start;
+    bool on_cycle = entry == 0x206 || entry == 0x20A || entry == 0x20E;
+    REQUIRE(function.recursive == on_cycle);
+    REQUIRE(function.call_depth == (entry == 0x212 ? 0 : -1));
+  }
+  REQUIRE(graph.max_call_depth == -1);
+}
@@ -0,0 +1,130 @@
+#include "catch.hpp"
+#include "../src/debugger.hpp"
+#include "../src/emu.hpp"
+
+#include <vector>
+
+TEST_CASE("Testing instruction_memory_access finds what instructions touch through I", 
+          "[debugger]") {
+  MemoryAccess access;
+  REQUIRE(instruction_memory_access(decode_instruction(0xD125), 0x300, access));
+  REQUIRE((access.address == 0x300 && access.length == 5 && !access.write));
+  REQUIRE(instruction_memory_access(decode_instruction(0xF333), 0x300, access));
+  REQUIRE((access.length == 3 && access.write));
+  REQUIRE(instruction_memory_access(decode_instruction(0xF755), 0x300, access));
+  REQUIRE((access.length == 8 && access.write));
+  REQUIRE(instruction_memory_access(decode_instruction(0xF065), 0x300, access));
+  REQUIRE((access.length == 1 && !access.write));
+  REQUIRE(!instruction_memory_access(decode_instruction(0x6A12), 0x300, access));
+}
+
+TEST_CASE("Testing the debugger stops at breakpoints, watchpoints and register changes", 
+          "[debugger]") {
+  const uint8_t rom[] = {
+    0x60, 0x01, // 200: LD V0, 0x01
+    0x61, 0x02, // 202: LD V1, 0x02
+    0xA3, 0x00, // 204: LD I, 0x300
+    0xF1, 0x55, // 206: LD [I], V1
+    0xA3, 0x00, // 208: LD I, 0x300
+    0xD0, 0x12, // 20A: DRW V0, V1, 2
+    0x72, 0x01, // 20C: ADD V2, 0x01
+    0x12, 0x0C  // 20E: JP 0x20C
+  };
+  const Emu::ExecutionEngine engines[] = { Emu::SWITCH_ENGINE, Emu::THREADED_ENGINE, 
+                                           Emu::JIT_ENGINE };
+  for (Emu::ExecutionEngine engine : engines) {
+    Emu emu;
+    emu.set_execution_engine(engine);
+    emu.LoadRom(rom, sizeof(rom));
+    Debugger debugger;
+    debugger.SetBreakpoint(0x202, true);
+    debugger.SetWatchpoint(0x301, 0x301, Debugger::WATCH_WRITE);
+    debugger.SetWatchpoint(0x300, 0x300, Debugger::WATCH_READ);
+    debugger.WatchRegister(2, true);
+    emu.set_debugger(&debugger);
+
+    // Breakpoints stop before the instruction runs.
+    REQUIRE(emu.ExecuteBatch(100) == 1);
+    REQUIRE(debugger.is_paused());
+    REQUIRE(debugger.get_stop().reason == STOP_BREAKPOINT);
+    REQUIRE(emu.get_program_counter() == 0x202);
+    REQUIRE(emu.ExecuteBatch(100) == 0);
+
+    // Fx55 writes V0 and V1 to 0x300 and 0x301, only the write to 0x301 is watched.
+    debugger.Resume();
+    REQUIRE(emu.ExecuteBatch(100) == 2);
+    REQUIRE(debugger.get_stop().reason == STOP_WRITE);
+    REQUIRE(debugger.get_stop().program_counter == 0x206);
+    REQUIRE(debugger.get_stop().target == 0x301);
+    REQUIRE(emu.get_memory(0x300) == 0);
+
+    // Resuming runs the write without stopping on it again, then Dxyn reads 0x300.
+    debugger.Resume();
+    REQUIRE(emu.ExecuteBatch(100) == 2);
+    REQUIRE(emu.get_memory(0x301) == 2);
+    REQUIRE(debugger.get_stop().reason == STOP_READ);
+    REQUIRE(debugger.get_stop().program_counter == 0x20A);
+
+    // Register triggers stop after the instruction that changed the register.
+    debugger.Resume();
+    REQUIRE(emu.ExecuteBatch(100) == 2);
+    REQUIRE(debugger.get_stop().reason == STOP_REGISTER);
+    REQUIRE(debugger.get_stop().program_counter == 0x20C);
+    REQUIRE(debugger.get_stop().target == 2);
+    REQUIRE(emu.get_register(2) == 1);
+    REQUIRE(emu.get_program_counter() == 0x20E);
+
+    debugger.WatchRegister(2, false);
+    debugger.StepInstruction();
+    REQUIRE(emu.ExecuteBatch(100) == 1);
+    REQUIRE(debugger.get_stop().reason == STOP_STEP);
+    REQUIRE(emu.get_program_counter() == 0x20C);
+
+    debugger.Resume();
+    REQUIRE(emu.ExecuteBatch(100) == 100);
+    REQUIRE(!debugger.is_paused());
+    REQUIRE(debugger.get_stop_count() == 5);
+
+    // Time stands still while paused, the timers hold and no cycles run.
+    emu.set_delay_timer(10);
+    debugger.Pause(emu.get_program_counter());
+    REQUIRE(emu.RunFrame(9).instructions == 0);
+    REQUIRE(emu.RunCycles(100).instructions == 0);
+    REQUIRE(emu.get_register(2) == 51);
+    REQUIRE(emu.get_delay_timer() == 10);
+
+    // A step within a frame ends the frame after it, without a timer tick.
+    debugger.StepInstruction();
+    RunSummary summary = emu.RunFrame(9);
+    REQUIRE(summary.instructions == 1);
+    REQUIRE(summary.executed == 1);
+    REQUIRE(debugger.is_paused());
+    REQUIRE(emu.get_delay_timer() == 10);
+
+    debugger.Resume();
+    REQUIRE(emu.RunFrame(9).instructions == 9);
+    REQUIRE(emu.get_delay_timer() == 9);
+  }
+}
+
+TEST_CASE("Testing a debugger with nothing set runs the same as no debugger", "[debugger]") {
+  std::vector<uint8_t> rom;
+  REQUIRE(read_test_rom("tetris.rom", rom));
+
+  Emu debugged;
+  debugged.LoadRom(rom.data(), rom.size());
+  Debugger debugger;
+  debugged.set_debugger(&debugger);
+  Emu reference;
+  reference.LoadRom(rom.data(), rom.size());
+  reference.set_idle_loop_skipping(false);
+  for (int frame = 0; frame < 1000; frame++) {
+    debugged.RunFrame(9);
+    reference.RunFrame(9);
+  }
+  REQUIRE(!debugger.is_paused());
+  REQUIRE(debugged.get_program_counter() == reference.get_program_counter());
+  for (int i = 0; i < 16; i++) {
+    REQUIRE(debugged.get_register(i) == reference.get_register(i));
+  }
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "../src/disassembler.hpp"
+
+#include <vector>
+
+TEST_CASE("Testing recursive descent separates code from data", "[disassembler]") {
+  const uint8_t rom[] = {
+    0x22, 0x0A, // 200: CALL 0x20A
+    0x30, 0x01, // 202: SE V0, 0x01
+    0x12, 0x10, // 204: JP 0x210
+    0x12, 0x13, // 206: JP 0x213, an odd address
+    0xFF, 0xFF, // 208: data
+    0x60, 0x05, // 20A: LD V0, 0x05
+    0x00, 0xEE, // 20C: RET
+    0x00, 0x00, // 20E: data
+    0x12, 0x10, // 210: JP 0x210
+    0xAA,       // 212: data
+    0x61, 0x07, // 213: LD V1, 0x07
+    0x12, 0x15  // 215: JP 0x215
+  };
+  Disassembly disassembly = disassemble(rom, sizeof(rom));
+
+  std::vector<int> addresses;
+  for (const DisassembledInstruction& code : disassembly.instructions) {
+    addresses.push_back(code.address);
+  }
+  REQUIRE(addresses == std::vector<int>({ 0x200, 0x202, 0x204, 0x206, 0x20A, 0x20C, 0x210, 
+                                          0x213, 0x215 }));
+  REQUIRE(disassembly.labels == std::vector<int>({ 0x210, 0x213, 0x215 }));
+  REQUIRE(disassembly.subroutines == std::vector<int>({ 0x20A }));
+  REQUIRE(!disassembly.indirect_jumps);
+
+  REQUIRE(!disassembly.Has(0x208, Disassembly::CODE));
+  REQUIRE(!disassembly.Has(0x20E, Disassembly::CODE));
+  REQUIRE(!disassembly.Has(0x212, Disassembly::CODE));
+  REQUIRE(disassembly.Has(0x214, Disassembly::CODE));
+  REQUIRE(!disassembly.Has(0x214, Disassembly::INSTRUCTION));
+  REQUIRE(disassembly.Find(0x213) == 7);
+  REQUIRE(disassembly.Find(0x214) == -1);
+}
+
+TEST_CASE("Testing instructions format as assembly", "[disassembler]") {
+  REQUIRE(format_instruction(decode_instruction(0xD015)) == "DRW V0, V1, 5");
+  REQUIRE(format_instruction(decode_instruction(0xA2B4)) == "LD I, 0x2B4");
+  REQUIRE(format_instruction(decode_instruction(0x23E6), "sub_3E6") == "CALL sub_3E6");
+  REQUIRE(format_instruction(decode_instruction(0x8AB6)) == "SHR VA, VB");
+  REQUIRE(format_instruction(decode_instruction(0xF565)) == "LD V5, [I]");
+  REQUIRE(format_instruction(decode_instruction(0x00EE)) == "RET");
+  REQUIRE(format_instruction(decode_instruction(0x0123)) == "DW 0x0123");
+}
@@ -0,0 +1,164 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/opcode.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Gives both emulators the same randomly chosen registers, index and program counter, and loads
+ * p_instruction at the program counter of each.
+ */
+void prepare_emulators(Emu& p_first, Emu& p_second, int p_instruction) {
+  int index = 0x200 + rand() % 0xD00;
+  for (int i = 0; i <= 0xF; i++) {
+    int value = rand() % 0x100;
+    p_first.set_register(i, value);
+    p_second.set_register(i, value);
+  }
+  p_first.set_index_register(index);
+  p_second.set_index_register(index);
+  p_first.set_program_counter(0x100);
+  p_second.set_program_counter(0x100);
+  p_first.LoadInstruction(0x100, p_instruction);
+  p_second.LoadInstruction(0x100, p_instruction);
+}
+
+/**
+ * Returns true if both emulators save exactly the same state: registers, timers, return stack, 
+ * keys, display and memory.
+ */
+bool same_state(Emu& p_first, Emu& p_second) {
+  EmuState first;
+  EmuState second;
+  p_first.SaveState(first);
+  p_second.SaveState(second);
+  return std::memcmp(&first, &second, sizeof(EmuState)) == 0;
+}
+
+TEST_CASE("Testing opcode decoder extracts operands", "[dispatch]") {
+  Instruction instruction = decode_instruction(0xD123);
+  REQUIRE(instruction.type == OP_DRAW);
+  REQUIRE(instruction.x == 0x1);
+  REQUIRE(instruction.y == 0x2);
+  REQUIRE(instruction.n == 0x3);
+  REQUIRE(instruction.nn == 0x23);
+  REQUIRE(instruction.nnn == 0x123);
+  REQUIRE(instruction.Opcode() == 0xD123);
+
+  REQUIRE(decode_instruction(0x00E0).type == OP_CLEAR_SCREEN);
+  REQUIRE(decode_instruction(0x8AB6).type == OP_SHIFT_RIGHT);
+  REQUIRE(decode_instruction(0xF365).type == OP_READ_REGISTERS);
+  REQUIRE(decode_instruction(0x5121).type == OP_UNKNOWN);
+  REQUIRE(decode_instruction(0xE1A2).type == OP_UNKNOWN);
+}
+
+TEST_CASE("Testing dispatch table matches switch decoder for every opcode", "[dispatch]") {
+  Emu switch_emu;
+  Emu table_emu;
+  switch_emu.set_execution_engine(Emu::SWITCH_ENGINE);
+  table_emu.set_execution_engine(Emu::TABLE_ENGINE);
+
+  for (int opcode = 0; opcode < DispatchTable::ENTRIES; opcode++) {
+    int type = decode_instruction(opcode).type;
+
+    // Skip opcodes that only print an error.
+    if (type == OP_UNKNOWN) {
+      continue;
+    }
+
+    prepare_emulators(switch_emu, table_emu, opcode);
+
+    // Random numbers must come out the same for both engines.
+    switch_emu.set_random_seed(opcode);
+    switch_emu.Step();
+    table_emu.set_random_seed(opcode);
+    table_emu.Step();
+
+    REQUIRE(same_state(switch_emu, table_emu));
+
+    if (type == OP_DRAW || type == OP_CLEAR_SCREEN) {
+      for (int row = 0; row < 32; row++) {
+        for (int col = 0; col < 64; col++) {
+          REQUIRE(switch_emu.get_display().GetPixel(row, col) 
+            == table_emu.get_display().GetPixel(row, col));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Fills p_emu's program space with the random instructions in p_program, starting at PROGRAM_START.
+ */
+void load_program(Emu& p_emu, const std::vector<int>& p_program) {
+  for (int i = 0; i < p_program.size(); i++) {
+    p_emu.LoadInstruction(p_emu.PROGRAM_START + i * 2, p_program[i]);
+  }
+}
+
+TEST_CASE("Testing batch execution gives the same result with every engine", "[dispatch]") {
+  // Random program made only of instructions that neither block for input nor fail to decode.
+  std::vector<int> program;
+  while (program.size() < 0x400) {
+    int opcode = rand() % 0x10000;
+    int type = decode_instruction(opcode).type;
+    if (type != OP_WAIT_KEY && type != OP_UNKNOWN) {
+      program.push_back(opcode);
+    }
+  }
+
+  Emu switch_emu;
+  Emu table_emu;
+  Emu threaded_emu;
+  Emu block_emu;
+  Emu jit_emu;
+  switch_emu.set_execution_engine(Emu::SWITCH_ENGINE);
+  table_emu.set_execution_engine(Emu::TABLE_ENGINE);
+  threaded_emu.set_execution_engine(Emu::THREADED_ENGINE);
+  block_emu.set_execution_engine(Emu::BLOCK_ENGINE);
+  jit_emu.set_execution_engine(Emu::JIT_ENGINE);
+  load_program(switch_emu, program);
+  load_program(table_emu, program);
+  load_program(threaded_emu, program);
+  load_program(block_emu, program);
+  load_program(jit_emu, program);
+
+  switch_emu.set_random_seed(1);
+  REQUIRE(switch_emu.ExecuteBatch(5000) == 5000);
+  table_emu.set_random_seed(1);
+  REQUIRE(table_emu.ExecuteBatch(5000) == 5000);
+  threaded_emu.set_random_seed(1);
+  REQUIRE(threaded_emu.ExecuteBatch(5000) == 5000);
+  block_emu.set_random_seed(1);
+  REQUIRE(block_emu.ExecuteBatch(5000) == 5000);
+  jit_emu.set_random_seed(1);
+  REQUIRE(jit_emu.ExecuteBatch(5000) == 5000);
+
+  REQUIRE(same_state(switch_emu, table_emu));
+  REQUIRE(same_state(switch_emu, threaded_emu));
+  REQUIRE(same_state(switch_emu, block_emu));
+  REQUIRE(same_state(switch_emu, jit_emu));
+}
+
+TEST_CASE("Testing batches end once Fx0A waits for a key", "[dispatch]") {
+  const Emu::ExecutionEngine engines[] = { Emu::SWITCH_ENGINE, Emu::TABLE_ENGINE, 
+    Emu::THREADED_ENGINE, Emu::BLOCK_ENGINE, Emu::JIT_ENGINE };
+  for (Emu::ExecutionEngine engine : engines) {
+    Emu emu;
+    emu.set_execution_engine(engine);
+    load_program(emu, { 0x6001, 0x7001, 0xF30A, 0x1200 });
+
+    // Round enough times for the block and jit engines to translate and compile the loop.
+    REQUIRE(emu.ExecuteBatch(100) == 3);
+    for (int round = 0; round < 8; round++) {
+      REQUIRE(emu.is_waiting_for_key());
+      REQUIRE(emu.get_program_counter() == 0x204);
+      REQUIRE(emu.ExecuteBatch(100) == 0);
+      emu.KeyDown(round);
+      REQUIRE(emu.get_register(3) == round);
+      REQUIRE(emu.ExecuteBatch(100) == 4);
+    }
+  }
+}
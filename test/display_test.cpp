@@ -36,4 +36,33 @@ TEST_CASE("Testing the clear display method and is clear method", "[hardware]")
   REQUIRE(!test_display.IsClear());
   test_display.Clear();
   REQUIRE(test_display.IsClear()); 
-}
\ No newline at end of file
+}
+
+TEST_CASE("Testing draw sprite XORs rows and reports collisions", "[hardware]") {
+  Display display;
+  const uint8_t sprite[] = { 0xF0, 0x81 };
+
+  REQUIRE(!display.DrawSprite(4, 10, sprite, 2));
+  REQUIRE(display.GetRow(10) == (uint64_t(0xF0) << 52));
+  REQUIRE(display.GetPixel(11, 4));
+  REQUIRE(display.GetPixel(11, 11));
+  REQUIRE(!display.GetPixel(11, 5));
+
+  // Drawing the same sprite again turns every pixel back off.
+  REQUIRE(display.DrawSprite(4, 10, sprite, 2));
+  REQUIRE(display.IsClear());
+}
+
+TEST_CASE("Testing draw sprite wraps its position and clips at the edges", "[hardware]") {
+  Display display;
+  const uint8_t sprite[] = { 0xFF, 0xFF, 0xFF };
+
+  // (124, 62) wraps around to (60, 30), then the right 4 columns and the last row are clipped.
+  display.DrawSprite(124, 62, sprite, 3);
+  REQUIRE(display.GetRow(30) == 0xF);
+  REQUIRE(display.GetRow(31) == 0xF);
+  REQUIRE(display.GetRow(0) == 0);
+  for (int row = 0; row < display.get_pixel_height(); row++) {
+    REQUIRE(!display.GetPixel(row, 0));
+  }
+}
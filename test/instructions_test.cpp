@@ -1,5 +1,5 @@
 #include "catch.hpp"
-#include "../src/emu.hpp "
+#include "../src/emu.hpp"
 
 #include <iostream>
 #include <random>
@@ -851,4 +851,90 @@ TEST_CASE("Testing shift register right", "[instructions]") {
     REQUIRE(test_emu.get_register(0xF) == expected_least_sig);
     REQUIRE(test_emu.get_register(second_register) == first_value >> 1);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Testing timer ticks decrement until zero", "[instructions]") {
+  Emu emu;
+  emu.set_delay_timer(2);
+  emu.set_sound_timer(1);
+  for (int i = 0; i < 3; i++) {
+    emu.DelayTick();
+    emu.SoundTick();
+  }
+  REQUIRE(emu.get_delay_timer() == 0);
+  REQUIRE(emu.get_sound_timer() == 0);
+}
+
+TEST_CASE("Testing wait for key press suspends until a key is pressed", "[instructions]") {
+  Emu emu;
+  emu.set_program_counter(0);
+  emu.LoadInstruction(0, std::bitset<16>(0xF30A));
+
+  // The instruction does not block, the emulator stays on it waiting for a key.
+  emu.Step();
+  REQUIRE(emu.is_waiting_for_key());
+  REQUIRE(emu.get_program_counter() == 0);
+  emu.Step();
+  REQUIRE(emu.get_program_counter() == 0);
+
+  // Keys outside the keypad are ignored, a keypad key completes the instruction.
+  emu.KeyDown(0x10);
+  REQUIRE(emu.is_waiting_for_key());
+  emu.KeyDown(0xB);
+  REQUIRE(!emu.is_waiting_for_key());
+  REQUIRE(emu.get_program_counter() == 2);
+  REQUIRE(emu.get_register(3) == 0xB);
+}
+
+/**
+ * Video output that counts the pixels that are on every time it is presented with the display.
+ */
+class CountingVideoOutput : public VideoOutput {
+public:
+  int pixels = 0;
+
+  void Present(const Display& p_display) {
+    pixels = 0;
+    for (int row = 0; row < p_display.get_pixel_height(); row++) {
+      for (int col = 0; col < p_display.get_pixel_width(); col++) {
+        pixels += p_display.GetPixel(row, col);
+      }
+    }
+  }
+};
+
+TEST_CASE("Testing render hands the display to the video output", "[instructions]") {
+  CountingVideoOutput output;
+  Emu emu(&output);
+  emu.get_display().SetPixel(4, 7, 1);
+  emu.get_display().SetPixel(5, 9, 1);
+  emu.Render();
+  REQUIRE(output.pixels == 2);
+}
+
+TEST_CASE("Testing random numbers come from the emulator's own seeded generator", "[instructions]") {
+  Emu first;
+  Emu second;
+  Emu other_seed;
+  first.set_random_seed(1234);
+  second.set_random_seed(1234);
+  other_seed.set_random_seed(4321);
+  first.LoadInstruction(0x200, 0xC30F);
+  first.LoadInstruction(0x202, 0x1200);
+  second.LoadInstruction(0x200, 0xC30F);
+  second.LoadInstruction(0x202, 0x1200);
+  other_seed.LoadInstruction(0x200, 0xC3FF);
+  other_seed.LoadInstruction(0x202, 0x1200);
+
+  // Interleaving the emulators must not change either of their sequences.
+  int differences = 0;
+  for (int i = 0; i < 100; i++) {
+    first.ExecuteBatch(2);
+    other_seed.ExecuteBatch(2);
+    second.ExecuteBatch(2);
+    REQUIRE(first.get_register(3) == second.get_register(3));
+    REQUIRE(first.get_register(3) <= 0x0F);
+    differences += (first.get_register(3) != (other_seed.get_register(3) & 0x0F));
+  }
+  REQUIRE(differences > 0);
+}
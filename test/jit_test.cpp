@@ -0,0 +1,176 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/opcode.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+TEST_CASE("Testing jit matches the interpreter after every chunk", "[jit]") {
+  // Random program made only of instructions that neither block for input nor fail to decode.
+  srand(6);
+  std::vector<int> program;
+  while (program.size() < 0x400) {
+    int opcode = rand() % 0x10000;
+    int type = decode_instruction(opcode).type;
+    if (type != OP_WAIT_KEY && type != OP_UNKNOWN) {
+      program.push_back(opcode);
+    }
+  }
+
+  Emu table_emu;
+  Emu jit_emu;
+  table_emu.set_execution_engine(Emu::TABLE_ENGINE);
+  jit_emu.set_execution_engine(Emu::JIT_ENGINE);
+  load_program(table_emu, program);
+  load_program(jit_emu, program);
+
+  // Small chunks make blocks straddle chunk boundaries, which must not change the result.
+  for (int chunk = 0; chunk < 200; chunk++) {
+    table_emu.set_random_seed(chunk);
+    REQUIRE(table_emu.ExecuteBatch(47) == 47);
+    jit_emu.set_random_seed(chunk);
+    REQUIRE(jit_emu.ExecuteBatch(47) == 47);
+    REQUIRE(same_state(table_emu, jit_emu));
+  }
+}
+
+TEST_CASE("Testing jit matches the interpreter on every instruction scenario", "[jit]") {
+  // The instructions covered one at a time by instructions_test.cpp, with the bits under each mask
+  // filled in at random. Fx0A is left out since it waits for a key.
+  const int scenarios[][2] = {
+    { 0x00E0, 0x0000 }, { 0x00EE, 0x0000 }, { 0x1000, 0x0FFF }, { 0x2000, 0x0FFF },
+    { 0x3000, 0x0FFF }, { 0x4000, 0x0FFF }, { 0x5000, 0x0FF0 }, { 0x6000, 0x0FFF },
+    { 0x7000, 0x0FFF }, { 0x8000, 0x0FF0 }, { 0x8001, 0x0FF0 }, { 0x8002, 0x0FF0 },
+    { 0x8003, 0x0FF0 }, { 0x8004, 0x0FF0 }, { 0x8005, 0x0FF0 }, { 0x8006, 0x0FF0 },
+    { 0x8007, 0x0FF0 }, { 0x800E, 0x0FF0 }, { 0x9000, 0x0FF0 }, { 0xA000, 0x0FFF },
+    { 0xB000, 0x0FFF }, { 0xC000, 0x0FFF }, { 0xD000, 0x0FFF }, { 0xE09E, 0x0F00 },
+    { 0xE0A1, 0x0F00 }, { 0xF007, 0x0F00 }, { 0xF015, 0x0F00 }, { 0xF018, 0x0F00 },
+    { 0xF01E, 0x0F00 }, { 0xF029, 0x0F00 }, { 0xF033, 0x0F00 }, { 0xF055, 0x0F00 },
+    { 0xF065, 0x0F00 }
+  };
+  srand(7);
+  for (const int* scenario : scenarios) {
+    for (int i = 0; i < 20; i++) {
+      int opcode = scenario[0] | (rand() & scenario[1]);
+
+      // The instruction at 0x300, called from 0x200 so 00EE has somewhere to return to, followed 
+      // by a jump back to it.
+      Emu setup;
+      setup.LoadInstruction(0x200, 0x2300);
+      setup.LoadInstruction(0x300, opcode);
+      setup.LoadInstruction(0x302, 0x1300);
+      setup.Step();
+      for (int j = 0; j <= 0xF; j++) {
+        setup.set_register(j, rand() % 0x100);
+      }
+      setup.set_index_register(0x400 + rand() % 0xB00);
+      setup.set_delay_timer(rand() % 0x100);
+      setup.set_sound_timer(rand() % 0x100);
+      setup.set_random_seed(rand());
+      setup.KeyDown(rand() % 0x10);
+      EmuState state;
+      setup.SaveState(state);
+
+      // Run the scenario from the same state until the jit has compiled it and run it natively.
+      Emu table_emu;
+      Emu jit_emu;
+      table_emu.set_execution_engine(Emu::TABLE_ENGINE);
+      jit_emu.set_execution_engine(Emu::JIT_ENGINE);
+      for (int run = 0; run <= JitCompiler::HOT_THRESHOLD; run++) {
+        REQUIRE(table_emu.LoadState(state));
+        REQUIRE(jit_emu.LoadState(state));
+        REQUIRE(table_emu.ExecuteBatch(2) == 2);
+        REQUIRE(jit_emu.ExecuteBatch(2) == 2);
+        REQUIRE(same_state(table_emu, jit_emu));
+      }
+    }
+  }
+}
+
+TEST_CASE("Testing jit compiled loop arithmetic", "[jit]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::JIT_ENGINE);
+
+  // V0 += 1, V1 = V1 + V0 with carry into VF, I += V0, loop until V0 == 0x40.
+  emu.LoadInstruction(0x200, 0x7001);
+  emu.LoadInstruction(0x202, 0x8104);
+  emu.LoadInstruction(0x204, 0xF01E);
+  emu.LoadInstruction(0x206, 0x3040);
+  emu.LoadInstruction(0x208, 0x1200);
+  emu.LoadInstruction(0x20A, 0x120A);
+  emu.set_program_counter(0x200);
+
+  emu.ExecuteBatch(0x40 * 5);
+
+  REQUIRE(emu.get_program_counter() == 0x20A);
+  REQUIRE(emu.get_register(0) == 0x40);
+  // 1 + 2 + ... + 64 = 2080 = 0x820, and the last addition 0xE0 + 0x40 carried.
+  REQUIRE(emu.get_register(1) == 0x20);
+  REQUIRE(emu.get_register(0xF) == 1);
+  REQUIRE(emu.get_index_register().to_ulong() == 0x820);
+}
+
+TEST_CASE("Testing jit drops compiled code overwritten by the program", "[jit]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::JIT_ENGINE);
+
+  // Loop on V2 += 1 until V2 == 8, then overwrite the skip at 0x202 with a jump to 0x214 and go
+  // back into the loop, whose block has been compiled by then.
+  emu.LoadInstruction(0x200, 0x7201);
+  emu.LoadInstruction(0x202, 0x3208);
+  emu.LoadInstruction(0x204, 0x1200);
+  emu.LoadInstruction(0x206, 0x6012);
+  emu.LoadInstruction(0x208, 0x6114);
+  emu.LoadInstruction(0x20A, 0xA202);
+  emu.LoadInstruction(0x20C, 0xF155);
+  emu.LoadInstruction(0x20E, 0x1200);
+  emu.LoadInstruction(0x214, 0x6301);
+  emu.LoadInstruction(0x216, 0x1216);
+  emu.set_program_counter(0x200);
+
+  emu.ExecuteBatch(40);
+
+  REQUIRE(emu.get_register(2) == 9);
+  REQUIRE(emu.get_register(3) == 1);
+  REQUIRE(emu.get_program_counter() == 0x216);
+}
+
+/**
+ * Reads the rom p_name from the roms directory into p_rom. Returns false if it can not be found.
+ */
+bool read_test_rom(const std::string& p_name, std::vector<uint8_t>& p_rom) {
+  std::ifstream file("../roms/" + p_name, std::ios::binary);
+  if (!file) {
+    file.open("roms/" + p_name, std::ios::binary);
+  }
+  if (!file) {
+    return false;
+  }
+  p_rom.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+TEST_CASE("Testing jit matches the interpreter running roms", "[jit]") {
+  const char* roms[] = { "tetris.rom", "test_opcode.ch8", "Maze.ch8" };
+  for (const char* name : roms) {
+    std::vector<uint8_t> rom;
+    REQUIRE(read_test_rom(name, rom));
+
+    Emu table_emu;
+    Emu jit_emu;
+    jit_emu.set_execution_engine(Emu::JIT_ENGINE);
+    table_emu.LoadRom(rom.data(), rom.size());
+    jit_emu.LoadRom(rom.data(), rom.size());
+
+    for (int chunk = 0; chunk < 500; chunk++) {
+      table_emu.set_random_seed(chunk);
+      table_emu.ExecuteBatch(53);
+      jit_emu.set_random_seed(chunk);
+      jit_emu.ExecuteBatch(53);
+      REQUIRE(same_state(table_emu, jit_emu));
+    }
+  }
+}
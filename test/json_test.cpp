@@ -0,0 +1,14 @@
+#include "catch.hpp"
+#include "../src/json.hpp"
+
+#include <string>
+
+TEST_CASE("Testing json_string escapes quotes, backslashes and control characters", "[json]") {
+  REQUIRE(json_string("tetris.rom") == "\"tetris.rom\"");
+  REQUIRE(json_string("Breakout [Carmelo Cortez, 1979].ch8") 
+    == "\"Breakout [Carmelo Cortez, 1979].ch8\"");
+  REQUIRE(json_string("a\"b\\c") == "\"a\\\"b\\\\c\"");
+  REQUIRE(json_string("line\nbreak\ttab\r") == "\"line\\nbreak\\ttab\\r\"");
+  REQUIRE(json_string(std::string("\x01 \x1F", 3)) == "\"\\u0001 \\u001F\"");
+  REQUIRE(json_string("rom\xC3\xA9.ch8") == "\"rom\xC3\xA9.ch8\"");
+}
@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/lockstep_emu.hpp"
+#include "../src/save_state.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * Returns true if lane p_lane of p_lockstep saves the same state as p_emu byte for byte.
+ */
+bool same_lane_state(LockstepEmu& p_lockstep, int p_lane, Emu& p_emu) {
+  EmuState lane;
+  EmuState scalar;
+  p_lockstep.SaveState(p_lane, lane);
+  p_emu.SaveState(scalar);
+  return std::memcmp(&lane, &scalar, sizeof(EmuState)) == 0;
+}
+
+TEST_CASE("Testing every lane runs roms exactly like its own emulator", "[lockstep]") {
+  const char* roms[] = { 
+    "tetris.rom", "breakout.rom", "Breakout [Carmelo Cortez, 1979].ch8", "Maze.ch8", 
+    "ibm_logo.ch8", "test_opcode.ch8" 
+  };
+  for (const char* name : roms) {
+    std::vector<uint8_t> rom;
+    REQUIRE(read_test_rom(name, rom));
+
+    LockstepEmu lockstep(LockstepEmu::MAX_LANES);
+    REQUIRE(lockstep.get_lane_count() == LockstepEmu::MAX_LANES);
+    lockstep.LoadRom(rom.data(), rom.size());
+    std::vector<std::unique_ptr<Emu>> emus;
+    for (int lane = 0; lane < LockstepEmu::MAX_LANES; lane++) {
+      emus.emplace_back(new Emu());
+      emus[lane]->LoadRom(rom.data(), rom.size());
+      emus[lane]->set_random_seed(lane);
+      lockstep.set_random_seed(lane, lane);
+    }
+
+    // Every lane gets its own key presses, so the lanes drift apart and come back together.
+    for (int frame = 0; frame < 600; frame++) {
+      for (int lane = 0; lane < LockstepEmu::MAX_LANES; lane++) {
+        int key = (frame / 7 + lane) % 16;
+        if ((frame + lane) % 11 == 0) {
+          lockstep.KeyDown(lane, key);
+          emus[lane]->KeyDown(key);
+        } else if ((frame + lane) % 11 == 5) {
+          lockstep.KeyUp(lane, key);
+          emus[lane]->KeyUp(key);
+        }
+      }
+
+      lockstep.RunFrame(9);
+      for (int lane = 0; lane < LockstepEmu::MAX_LANES; lane++) {
+        emus[lane]->RunFrame(9);
+      }
+      if (frame % 50 == 49) {
+        for (int lane = 0; lane < LockstepEmu::MAX_LANES; lane++) {
+          REQUIRE(same_lane_state(lockstep, lane, *emus[lane]));
+        }
+      }
+    }
+
+    LockstepStats stats = lockstep.get_stats();
+    REQUIRE(stats.groups > 0);
+    REQUIRE(stats.lane_instructions >= stats.groups);
+  }
+}
+
+TEST_CASE("Testing lanes running random programs from different registers", "[lockstep]") {
+  // Random program filling all of memory, made only of instructions that neither block for input 
+  // nor fail to decode. Nothing may run off the end of memory, so offset jumps stay low and the 
+  // last instruction jumps back to the start.
+  std::vector<int> program;
+  while (program.size() < 0x7FF) {
+    int opcode = rand() % 0x10000;
+    Instruction instruction = decode_instruction(opcode);
+    if (instruction.type != OP_WAIT_KEY && instruction.type != OP_UNKNOWN 
+        && !(instruction.type == OP_JUMP_OFFSET && instruction.nnn >= 0xF00)) {
+      program.push_back(opcode);
+    }
+  }
+  program.push_back(0x1200);
+
+  const int lanes = 8;
+  LockstepEmu lockstep(lanes);
+  std::vector<std::unique_ptr<Emu>> emus;
+  for (int lane = 0; lane < lanes; lane++) {
+    emus.emplace_back(new Emu());
+    for (int address = 0; address < 0x1000; address += 2) {
+      emus[lane]->LoadInstruction(address, program[address / 2]);
+    }
+    for (int i = 0; i < 16; i++) {
+      emus[lane]->set_register(i, rand() % 0x100);
+    }
+    emus[lane]->set_index_register(rand() % 0x1000);
+    emus[lane]->set_delay_timer(rand() % 0x100);
+    emus[lane]->set_random_seed(lane);
+
+    EmuState state;
+    emus[lane]->SaveState(state);
+    REQUIRE(lockstep.LoadState(lane, state));
+    REQUIRE(same_lane_state(lockstep, lane, *emus[lane]));
+  }
+
+  for (int frame = 0; frame < 200; frame++) {
+    lockstep.RunFrame(10);
+    for (int lane = 0; lane < lanes; lane++) {
+      emus[lane]->RunFrame(10);
+    }
+  }
+  for (int lane = 0; lane < lanes; lane++) {
+    REQUIRE(same_lane_state(lockstep, lane, *emus[lane]));
+    REQUIRE(lockstep.get_program_counter(lane) == emus[lane]->get_program_counter());
+  }
+}
+
+TEST_CASE("Testing a lane waiting on Fx0A does not hold up the others", "[lockstep]") {
+  LockstepEmu lockstep(2);
+  const uint8_t program[] = { 0x63, 0x00, 0x33, 0x01, 0xF5, 0x0A, 0x71, 0x01, 0x12, 0x06 };
+  lockstep.LoadRom(program, sizeof(program));
+
+  // Lane 1 sets V3 and skips the wait, lane 0 stops on it.
+  EmuState state;
+  lockstep.SaveState(1, state);
+  state.program_counter = 0x202;
+  state.registers[3] = 1;
+  REQUIRE(lockstep.LoadState(1, state));
+
+  lockstep.ExecuteBatch(20);
+  REQUIRE(lockstep.is_waiting_for_key(0));
+  REQUIRE_FALSE(lockstep.is_waiting_for_key(1));
+  REQUIRE(lockstep.get_register(0, 1) == 0);
+  REQUIRE(lockstep.get_register(1, 1) > 0);
+
+  lockstep.KeyDown(0, 0xB);
+  REQUIRE_FALSE(lockstep.is_waiting_for_key(0));
+  REQUIRE(lockstep.get_register(0, 5) == 0xB);
+  lockstep.ExecuteBatch(2);
+  REQUIRE(lockstep.get_register(0, 1) == 1);
+}
+
+TEST_CASE("Testing lanes that drift apart run one at a time", "[lockstep]") {
+  std::vector<uint8_t> rom;
+  REQUIRE(read_test_rom("tetris.rom", rom));
+
+  // Tetris picks its pieces at random, so lanes with different seeds soon go their own way.
+  LockstepEmu diverged(LockstepEmu::MAX_LANES);
+  diverged.LoadRom(rom.data(), rom.size());
+  LockstepEmu together(LockstepEmu::MAX_LANES);
+  together.LoadRom(rom.data(), rom.size());
+  Emu emu;
+  emu.LoadRom(rom.data(), rom.size());
+  emu.set_random_seed(5);
+  for (int lane = 0; lane < LockstepEmu::MAX_LANES; lane++) {
+    diverged.set_random_seed(lane, lane);
+  }
+  for (int frame = 0; frame < 1000; frame++) {
+    diverged.RunFrame(9);
+    together.RunFrame(9);
+    emu.RunFrame(9);
+  }
+
+  REQUIRE(same_lane_state(diverged, 5, emu));
+
+  // By now the lanes are apart, so nearly everything runs lane by lane.
+  LockstepStats before = diverged.get_stats();
+  for (int frame = 0; frame < 1000; frame++) {
+    diverged.RunFrame(9);
+  }
+  LockstepStats after = diverged.get_stats();
+  long long lane_instructions = after.lane_instructions - before.lane_instructions;
+  REQUIRE(after.scalar_instructions - before.scalar_instructions > lane_instructions * 9 / 10);
+  REQUIRE(together.get_stats().scalar_instructions == 0);
+}
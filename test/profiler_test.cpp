@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/profiler.hpp"
+
+#include <sstream>
+#include <string>
+
+TEST_CASE("Testing the profiler counts by instruction type and address", "[profiler]") {
+  Profiler profiler;
+  profiler.Record(0x200, OP_DRAW, 100);
+  profiler.Record(0x200, OP_DRAW, 50);
+  profiler.Record(0x202, OP_JUMP, 10);
+  profiler.Record(0x1202, OP_JUMP, 5);
+
+  REQUIRE(profiler.get_type(OP_DRAW).count == 2);
+  REQUIRE(profiler.get_type(OP_DRAW).nanoseconds == 150);
+  REQUIRE(profiler.get_address(0x202).count == 2);
+  REQUIRE(profiler.get_address(0x202).nanoseconds == 15);
+  REQUIRE(profiler.get_total().count == 4);
+  REQUIRE(profiler.get_total().nanoseconds == 165);
+
+  std::ostringstream report;
+  profiler.WriteReport(report);
+  REQUIRE(report.str().find("DRW") < report.str().find("JP"));
+
+  std::ostringstream collapsed;
+  profiler.WriteCollapsed(collapsed);
+  REQUIRE(collapsed.str() == "chip8;DRW;0x200 150\nchip8;JP;0x202 15\n");
+
+  profiler.Reset();
+  REQUIRE(profiler.get_total().count == 0);
+}
+
+TEST_CASE("Testing an attached profiler sees every instruction in profiling builds", "[profiler]") {
+  const Emu::ExecutionEngine engines[] = { Emu::SWITCH_ENGINE, Emu::TABLE_ENGINE, 
+    Emu::THREADED_ENGINE, Emu::BLOCK_ENGINE, Emu::JIT_ENGINE };
+  for (Emu::ExecutionEngine engine : engines) {
+    Emu emu;
+    emu.set_execution_engine(engine);
+    Profiler profiler;
+    emu.set_profiler(&profiler);
+    REQUIRE(emu.get_profiler() == &profiler);
+
+    // 6005, 7001, 1202: a loop of two instructions after the first.
+    emu.LoadInstruction(0x200, 0x6005);
+    emu.LoadInstruction(0x202, 0x7001);
+    emu.LoadInstruction(0x204, 0x1202);
+    emu.ExecuteBatch(201);
+    REQUIRE(emu.get_register(0) == 105);
+
+#ifdef CHIP8_PROFILE
+    REQUIRE(profiler.get_total().count == 201);
+    REQUIRE(profiler.get_address(0x200).count == 1);
+    REQUIRE(profiler.get_address(0x202).count == 100);
+    REQUIRE(profiler.get_type(OP_JUMP).count == 100);
+#else
+    REQUIRE(profiler.get_total().count == 0);
+#endif
+  }
+}
+
+TEST_CASE("Testing idle loops are not skipped while a profiler is attached", "[profiler]") {
+  Emu emu;
+  Profiler profiler;
+  emu.set_profiler(&profiler);
+
+  // A jump to self, which is skipped whenever nothing needs to see it run.
+  emu.LoadInstruction(0x200, 0x1200);
+  long long skipped = 0;
+  for (int frame = 0; frame < 10; frame++) {
+    skipped += emu.RunFrame(9).skipped_cycles;
+  }
+
+#ifdef CHIP8_PROFILE
+  REQUIRE(skipped == 0);
+  REQUIRE(profiler.get_total().count == 90);
+  REQUIRE(profiler.get_address(0x200).count == 90);
+#else
+  REQUIRE(skipped > 0);
+  REQUIRE(profiler.get_total().count == 0);
+#endif
+}
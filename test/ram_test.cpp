@@ -19,4 +19,41 @@ TEST_CASE("Testing ram read write", "[hardware]") {
 TEST_CASE("Testing bad Read addresses", "[hardware]") {
   int bad_address = -10;
   REQUIRE(test_ram.Read(bad_address).to_ulong() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Testing ram bulk write and read", "[hardware]") {
+  Ram ram;
+  const uint8_t bytes[] = {0x12, 0x34, 0x56, 0x78};
+  REQUIRE(ram.Write(0x200, bytes, 4) == 4);
+
+  uint8_t read_back[4];
+  REQUIRE(ram.Read(0x200, read_back, 4) == 4);
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(read_back[i] == bytes[i]);
+    REQUIRE(ram.ReadByte(0x200 + i) == bytes[i]);
+  }
+}
+
+TEST_CASE("Testing ram bulk access clips at end of memory", "[hardware]") {
+  Ram ram;
+  const uint8_t bytes[] = {0xAA, 0xBB, 0xCC};
+  REQUIRE(ram.Write(Ram::ADDRESSES - 1, bytes, 3) == 1);
+  REQUIRE(ram.ReadByte(Ram::ADDRESSES - 1) == 0xAA);
+
+  uint8_t read_back[3] = {0xFF, 0xFF, 0xFF};
+  REQUIRE(ram.Read(Ram::ADDRESSES - 1, read_back, 3) == 1);
+  REQUIRE(read_back[0] == 0xAA);
+  REQUIRE(read_back[1] == 0);
+  REQUIRE(read_back[2] == 0);
+
+  REQUIRE(ram.View(Ram::ADDRESSES - 2, 10).size == 2);
+  REQUIRE(ram.View(-1, 10).size == 0);
+}
+
+TEST_CASE("Testing ram view reflects writes without copying", "[hardware]") {
+  Ram ram;
+  ByteView view = ram.View();
+  REQUIRE(view.size == Ram::ADDRESSES);
+  ram.WriteByte(0x300, 0x42);
+  REQUIRE(view[0x300] == 0x42);
+}
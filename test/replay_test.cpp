@@ -0,0 +1,106 @@
+#include "catch.hpp"
+#include "../src/replay.hpp"
+#include "../src/rewind_buffer.hpp"
+#include "../src/save_state.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+TEST_CASE("Testing a recorded run replays to the same final state", "[replay]") {
+  const char* roms[] = { "tetris.rom", "breakout.rom" };
+  for (const char* name : roms) {
+    std::vector<uint8_t> rom;
+    REQUIRE(read_test_rom(name, rom));
+
+    // Play like the frontend does: keys between frames, rewinding part of the way through.
+    Emu emu;
+    emu.LoadRom(rom.data(), rom.size());
+    ReplayRecorder recorder(&emu, rom.data(), rom.size(), 77, 9);
+    RewindBuffer rewind_buffer(1 << 20, 600);
+    EmuState state;
+    for (int frame = 0; frame < 1200; frame++) {
+      if (frame % 23 == 0) {
+        recorder.KeyDown((frame / 23) % 16);
+      } else if (frame % 23 == 7) {
+        recorder.KeyUp((frame / 23) % 16);
+      }
+      recorder.KeyDown(-1);
+      if (frame == 600) {
+        for (int back = 0; back < 100; back++) {
+          REQUIRE(rewind_buffer.Pop(state));
+        }
+        emu.LoadState(state);
+        recorder.Rewind();
+        recorder.KeyDown(frame % 16);
+      }
+      emu.SaveState(state);
+      rewind_buffer.Push(state);
+      emu.RunFrame(9);
+    }
+    Replay recorded = recorder.Finish();
+    REQUIRE(recorded.end_cycle == emu.get_cycle_count());
+    for (const ReplayEvent& event : recorded.events) {
+      REQUIRE(event.cycle <= recorded.end_cycle);
+    }
+
+    const char* path = "replay_test.tmp";
+    REQUIRE(write_replay_file(path, recorded));
+    Replay loaded;
+    REQUIRE(read_replay_file(path, loaded));
+    REQUIRE(loaded.events.size() == recorded.events.size());
+    std::remove(path);
+
+    Emu replayed;
+    REQUIRE(play_replay(replayed, loaded, rom.data(), rom.size()));
+    REQUIRE(replay_state_hash(replayed) == loaded.final_state_hash);
+
+    EmuState expected;
+    EmuState actual;
+    emu.SaveState(expected);
+    replayed.SaveState(actual);
+    REQUIRE(std::memcmp(&expected, &actual, sizeof(EmuState)) == 0);
+
+    // A replay only plays on the rom it was recorded on.
+    rom[0] ^= 1;
+    Emu other;
+    REQUIRE(!play_replay(other, loaded, rom.data(), rom.size()));
+  }
+}
+
+TEST_CASE("Testing replay files reject damage", "[replay]") {
+  Replay replay;
+  replay.rom_hash = 1;
+  replay.seed = 2;
+  replay.instructions_per_frame = 9;
+  replay.end_cycle = 1 << 20;
+  replay.final_state_hash = 3;
+  replay.events.push_back({ 0, 0x5, true });
+  replay.events.push_back({ 90, 0x5, false });
+  replay.events.push_back({ 1 << 19, 0xF, true });
+
+  const char* path = "replay_test.tmp";
+  REQUIRE(write_replay_file(path, replay));
+  Replay loaded;
+  REQUIRE(read_replay_file(path, loaded));
+  REQUIRE(loaded.events.size() == 3);
+  REQUIRE(loaded.events[1].cycle == 90);
+  REQUIRE(!loaded.events[1].down);
+  REQUIRE(loaded.events[2].cycle == 1 << 19);
+  REQUIRE(loaded.events[2].key == 0xF);
+  REQUIRE(loaded.end_cycle == 1 << 20);
+
+  // Flip a byte of the events.
+  {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    int size = in.tellg();
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(size - 1);
+    file.put(0x3F);
+  }
+  REQUIRE(!read_replay_file(path, loaded));
+  REQUIRE(loaded.events.size() == 3);
+  REQUIRE(!read_replay_file("replay_test.missing", loaded));
+  std::remove(path);
+}
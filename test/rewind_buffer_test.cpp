@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/rewind_buffer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Runs p_frames frames of tetris, pushing the state before each one into p_buffer and storing a 
+ * copy in p_history. Returns false if the rom is missing.
+ */
+bool record_tetris(int p_frames, RewindBuffer& p_buffer, std::vector<EmuState>& p_history) {
+  std::vector<uint8_t> rom;
+  if (!read_test_rom("tetris.rom", rom)) {
+    return false;
+  }
+
+  Emu emu;
+  emu.LoadRom(rom.data(), rom.size());
+  for (int frame = 0; frame < p_frames; frame++) {
+    EmuState state;
+    emu.SaveState(state);
+    p_buffer.Push(state);
+    p_history.push_back(state);
+
+    // Move the piece around now and then so there is something to rewind.
+    if (frame % 7 == 0) {
+      emu.KeyDown(frame % 3 + 4);
+    } else {
+      emu.KeyUp(frame % 3 + 4);
+    }
+    emu.RunFrame(9);
+  }
+  return true;
+}
+
+TEST_CASE("Testing rewinding gives back every frame in reverse", "[rewind]") {
+  RewindBuffer buffer(1 << 20, 1000);
+  std::vector<EmuState> history;
+  REQUIRE(record_tetris(500, buffer, history));
+  REQUIRE(buffer.get_frame_count() == 500);
+
+  // Deltas are much smaller than whole states.
+  REQUIRE(buffer.get_used_bytes() < 500 * (int)sizeof(EmuState) / 4);
+
+  EmuState state;
+  for (int frame = 499; frame >= 0; frame--) {
+    REQUIRE(buffer.Pop(state));
+    REQUIRE(std::memcmp(&state, &history[frame], sizeof(EmuState)) == 0);
+  }
+  REQUIRE(!buffer.Pop(state));
+}
+
+TEST_CASE("Testing the rewind buffer evicts the oldest frames", "[rewind]") {
+  RewindBuffer buffer(40000, 300, 30);
+  std::vector<EmuState> history;
+  REQUIRE(record_tetris(1000, buffer, history));
+  REQUIRE(buffer.get_frame_count() <= 300);
+  REQUIRE(buffer.get_frame_count() > 30);
+  REQUIRE(buffer.get_used_bytes() <= buffer.get_capacity());
+
+  // Whatever is left is the most recent history, newest first.
+  EmuState state;
+  int frame = history.size() - 1;
+  while (buffer.Pop(state)) {
+    REQUIRE(std::memcmp(&state, &history[frame], sizeof(EmuState)) == 0);
+    frame--;
+  }
+  REQUIRE(frame < 1000 - 30);
+}
+
+TEST_CASE("Testing frames pushed after rewinding build on what is left", "[rewind]") {
+  RewindBuffer buffer(1 << 20, 1000, 10);
+  std::vector<EmuState> history;
+  REQUIRE(record_tetris(95, buffer, history));
+
+  // Rewind past a keyframe, then push the history back again.
+  EmuState state;
+  for (int i = 0; i < 17; i++) {
+    REQUIRE(buffer.Pop(state));
+  }
+  for (int frame = 78; frame < 95; frame++) {
+    buffer.Push(history[frame]);
+  }
+  for (int frame = 94; frame >= 0; frame--) {
+    REQUIRE(buffer.Pop(state));
+    REQUIRE(std::memcmp(&state, &history[frame], sizeof(EmuState)) == 0);
+  }
+}
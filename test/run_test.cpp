@@ -0,0 +1,157 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+TEST_CASE("Testing run cycles ticks the timers at the clock speed", "[run]") {
+  Emu emu;
+  emu.set_clock_speed(600);
+  emu.set_delay_timer(5);
+  emu.set_sound_timer(1);
+
+  // Jump to self, 10 instructions per tick.
+  emu.LoadInstruction(0x200, 0x1200);
+  emu.set_program_counter(0x200);
+
+  RunSummary summary = emu.RunCycles(25);
+  REQUIRE(summary.instructions == 25);
+  REQUIRE(summary.executed + summary.skipped_cycles == 25);
+  REQUIRE(emu.get_delay_timer() == 3);
+  REQUIRE(emu.get_sound_timer() == 0);
+
+  // The 5 cycles left over from the last call complete the next tick.
+  emu.RunCycles(5);
+  REQUIRE(emu.get_delay_timer() == 2);
+}
+
+TEST_CASE("Testing run frame reports display changes", "[run]") {
+  Emu emu;
+
+  // Draw the '0' font sprite at V0, V0 then jump to self.
+  emu.LoadInstruction(0x200, 0xA050);
+  emu.LoadInstruction(0x202, 0xD005);
+  emu.LoadInstruction(0x204, 0x1204);
+  emu.set_program_counter(0x200);
+  emu.set_delay_timer(2);
+
+  RunSummary summary = emu.RunFrame(9);
+  REQUIRE(summary.instructions == 9);
+  REQUIRE(summary.display_changed);
+  REQUIRE(!summary.waiting_for_key);
+  REQUIRE(emu.get_delay_timer() == 1);
+
+  summary = emu.RunFrame(9);
+  REQUIRE(!summary.display_changed);
+  REQUIRE(emu.get_delay_timer() == 0);
+}
+
+TEST_CASE("Testing run cycles waits on Fx0A without executing", "[run]") {
+  Emu emu;
+  emu.set_clock_speed(600);
+  emu.set_delay_timer(10);
+  emu.LoadInstruction(0x200, 0xF40A);
+  emu.LoadInstruction(0x202, 0x1202);
+  emu.set_program_counter(0x200);
+
+  RunSummary summary = emu.RunCycles(100);
+  REQUIRE(summary.instructions == 100);
+  REQUIRE(summary.executed == 1);
+  REQUIRE(summary.waiting_for_key);
+  REQUIRE(emu.get_program_counter() == 0x200);
+
+  // Time keeps passing while waiting.
+  REQUIRE(emu.get_delay_timer() == 0);
+
+  emu.KeyDown(0x7);
+  summary = emu.RunCycles(10);
+  REQUIRE(summary.executed + summary.skipped_cycles == 10);
+  REQUIRE(!summary.waiting_for_key);
+  REQUIRE(emu.get_register(4) == 0x7);
+  REQUIRE(emu.get_program_counter() == 0x202);
+}
+
+TEST_CASE("Testing run cycles fast-forwards a delay timer busy-wait", "[run]") {
+  Emu skipping_emu;
+  Emu executing_emu;
+  executing_emu.set_idle_loop_skipping(false);
+
+  // Wait for the delay timer to run out, then count up in V1 forever.
+  Emu* emus[] = { &skipping_emu, &executing_emu };
+  for (Emu* emu : emus) {
+    emu->set_clock_speed(6000);
+    emu->LoadInstruction(0x200, 0x6005);
+    emu->LoadInstruction(0x202, 0xF015);
+    emu->LoadInstruction(0x204, 0xF007);
+    emu->LoadInstruction(0x206, 0x3000);
+    emu->LoadInstruction(0x208, 0x1204);
+    emu->LoadInstruction(0x20A, 0x7101);
+    emu->LoadInstruction(0x20C, 0x120A);
+    emu->set_program_counter(0x200);
+  }
+
+  long long skipped = 0;
+  for (int call = 0; call < 20; call++) {
+    skipped += skipping_emu.RunCycles(37).skipped_cycles;
+    executing_emu.RunCycles(37);
+    REQUIRE(same_state(skipping_emu, executing_emu));
+  }
+  REQUIRE(skipped > 0);
+  REQUIRE(skipped == skipping_emu.get_skipped_cycles());
+  REQUIRE(executing_emu.get_skipped_cycles() == 0);
+
+  // Both left the loop once the timer ran out.
+  REQUIRE(skipping_emu.get_delay_timer() == 0);
+  REQUIRE(skipping_emu.get_register(1) > 0);
+}
+
+TEST_CASE("Testing run cycles fast-forwards a key spin until the key is pressed", "[run]") {
+  Emu emu;
+  emu.set_clock_speed(6000);
+
+  // Spin on Ex9E until key 5 is down.
+  emu.LoadInstruction(0x200, 0x6305);
+  emu.LoadInstruction(0x202, 0xE39E);
+  emu.LoadInstruction(0x204, 0x1202);
+  emu.LoadInstruction(0x206, 0x1206);
+  emu.set_program_counter(0x200);
+
+  RunSummary summary = emu.RunCycles(1000);
+  REQUIRE(summary.skipped_cycles > 800);
+  REQUIRE(emu.get_program_counter() >= 0x202);
+  REQUIRE(emu.get_program_counter() <= 0x204);
+
+  emu.KeyDown(0x5);
+  emu.RunCycles(10);
+  REQUIRE(emu.get_program_counter() == 0x206);
+
+  // Now stuck jumping to itself.
+  summary = emu.RunFrame(100);
+  REQUIRE(summary.skipped_cycles > 90);
+  REQUIRE(summary.executed + summary.skipped_cycles == 100);
+  REQUIRE(emu.get_program_counter() == 0x206);
+}
+
+TEST_CASE("Testing idle loop skipping does not change how roms run", "[run]") {
+  const char* roms[] = { "breakout.rom", "Maze.ch8", "ibm_logo.ch8", "tetris.rom" };
+  for (const char* name : roms) {
+    std::vector<uint8_t> rom;
+    REQUIRE(read_test_rom(name, rom));
+
+    Emu skipping_emu;
+    Emu executing_emu;
+    executing_emu.set_idle_loop_skipping(false);
+    skipping_emu.set_clock_speed(20000);
+    executing_emu.set_clock_speed(20000);
+    skipping_emu.LoadRom(rom.data(), rom.size());
+    executing_emu.LoadRom(rom.data(), rom.size());
+
+    for (int call = 0; call < 300; call++) {
+      skipping_emu.set_random_seed(call);
+      skipping_emu.RunCycles(211);
+      executing_emu.set_random_seed(call);
+      executing_emu.RunCycles(211);
+      REQUIRE(same_state(skipping_emu, executing_emu));
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/save_state.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/**
+ * Returns true if both emulators save byte for byte identical states.
+ */
+bool same_saved_state(Emu& p_first, Emu& p_second) {
+  EmuState first;
+  EmuState second;
+  p_first.SaveState(first);
+  p_second.SaveState(second);
+  return std::memcmp(&first, &second, sizeof(EmuState)) == 0;
+}
+
+TEST_CASE("Testing loading a saved state replays the same run", "[save_state]") {
+  std::vector<uint8_t> rom;
+  REQUIRE(read_test_rom("tetris.rom", rom));
+
+  Emu emu;
+  emu.set_clock_speed(1000);
+  emu.LoadRom(rom.data(), rom.size());
+  emu.RunCycles(5000);
+  emu.KeyDown(0x5);
+
+  EmuState saved;
+  emu.SaveState(saved);
+  REQUIRE(saved.version == EmuState::VERSION);
+
+  Emu first_run;
+  Emu second_run;
+  first_run.set_execution_engine(Emu::JIT_ENGINE);
+  REQUIRE(first_run.LoadState(saved));
+  REQUIRE(second_run.LoadState(saved));
+  REQUIRE(same_saved_state(emu, first_run));
+
+  for (int frame = 0; frame < 200; frame++) {
+    first_run.RunCycles(17);
+    second_run.RunCycles(17);
+    REQUIRE(same_saved_state(first_run, second_run));
+  }
+
+  // Rewinding the first run and replaying it ends up in the same place again.
+  EmuState ended;
+  first_run.SaveState(ended);
+  REQUIRE(first_run.LoadState(saved));
+  for (int frame = 0; frame < 200; frame++) {
+    first_run.RunCycles(17);
+  }
+  REQUIRE(same_saved_state(first_run, second_run));
+  REQUIRE(first_run.get_cycle_count() == 5000 + 200 * 17);
+  REQUIRE(first_run.get_display().GetRow(31) == second_run.get_display().GetRow(31));
+}
+
+TEST_CASE("Testing loading a state restores code that was overwritten", "[save_state]") {
+  Emu emu;
+  emu.set_execution_engine(Emu::BLOCK_ENGINE);
+  emu.LoadInstruction(0x200, 0x7001);
+  emu.LoadInstruction(0x202, 0x1200);
+
+  EmuState saved;
+  emu.SaveState(saved);
+  emu.ExecuteBatch(10);
+  REQUIRE(emu.get_register(0) == 5);
+
+  // Replace the add with a set, then go back to the saved state with the add in it.
+  emu.LoadInstruction(0x200, 0x6042);
+  emu.ExecuteBatch(2);
+  REQUIRE(emu.get_register(0) == 0x42);
+  REQUIRE(emu.LoadState(saved));
+  emu.ExecuteBatch(10);
+  REQUIRE(emu.get_register(0) == 5);
+}
+
+TEST_CASE("Testing loading an invalid state changes nothing", "[save_state]") {
+  Emu emu;
+  emu.set_register(3, 0x33);
+  EmuState saved;
+  emu.SaveState(saved);
+  saved.registers[3] = 0x44;
+
+  EmuState wrong_version = saved;
+  wrong_version.version = EmuState::VERSION + 1;
+  REQUIRE(!emu.LoadState(wrong_version));
+
+  EmuState bad_stack = saved;
+  bad_stack.stack_size = Emu::STACK_SIZE + 1;
+  REQUIRE(!emu.LoadState(bad_stack));
+  REQUIRE(emu.get_register(3) == 0x33);
+
+  REQUIRE(emu.LoadState(saved));
+  REQUIRE(emu.get_register(3) == 0x44);
+}
+
+TEST_CASE("Testing the call stack holds 16 return addresses", "[save_state]") {
+  Emu emu;
+  for (int i = 0; i <= Emu::STACK_SIZE; i++) {
+    emu.LoadInstruction(0x200 + i * 2, 0x2202 + i * 2);
+  }
+  emu.ExecuteBatch(Emu::STACK_SIZE + 1);
+
+  // The 17th call does not fit and is skipped.
+  EmuState saved;
+  emu.SaveState(saved);
+  REQUIRE(saved.stack_size == Emu::STACK_SIZE);
+  REQUIRE(saved.stack[0] == 0x202);
+  REQUIRE(emu.get_program_counter() == 0x200 + (Emu::STACK_SIZE + 1) * 2);
+}
+
+TEST_CASE("Testing state files round trip and reject corruption", "[save_state]") {
+  Emu emu;
+  emu.LoadInstruction(0x200, 0xA123);
+  emu.set_delay_timer(7);
+  emu.Step();
+
+  EmuState saved;
+  emu.SaveState(saved);
+  const char* path = "save_state_test.tmp";
+  REQUIRE(write_state_file(path, saved));
+
+  EmuState loaded;
+  REQUIRE(read_state_file(path, loaded));
+  REQUIRE(std::memcmp(&saved, &loaded, sizeof(EmuState)) == 0);
+
+  // Flip a byte of memory in the file.
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(EmuState) + 8);
+    file.put(0x5A);
+  }
+  REQUIRE(!read_state_file(path, loaded));
+  REQUIRE(!read_state_file("save_state_test.missing", loaded));
+  std::remove(path);
+}
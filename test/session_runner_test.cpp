@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "../src/session_runner.hpp"
+#include "../src/work_stealing_pool.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Queues a task that queues p_depth more tasks below it, counting every task that runs.
+ */
+void submit_tree(WorkStealingPool& p_pool, std::atomic<int>& p_count, int p_depth) {
+  p_pool.Submit([&p_pool, &p_count, p_depth] {
+    p_count++;
+    if (p_depth > 0) {
+      submit_tree(p_pool, p_count, p_depth - 1);
+      submit_tree(p_pool, p_count, p_depth - 1);
+    }
+  });
+}
+
+TEST_CASE("Testing the pool runs every task, including tasks queued by tasks", "[runner]") {
+  WorkStealingPool pool(4);
+  REQUIRE(pool.get_thread_count() == 4);
+
+  std::atomic<int> count(0);
+  submit_tree(pool, count, 10);
+  pool.Wait();
+  REQUIRE(count == (1 << 11) - 1);
+
+  // The pool can be reused after waiting.
+  submit_tree(pool, count, 3);
+  pool.Wait();
+  REQUIRE(count == (1 << 11) - 1 + 15);
+}
+
+/**
+ * Returns the path to p_name in the rom folder, or an empty string if the roms can not be found.
+ */
+std::string test_rom_path(const std::string& p_name) {
+  for (std::string folder : { "../roms/", "roms/" }) {
+    if (std::ifstream(folder + p_name)) {
+      return folder + p_name;
+    }
+  }
+  return "";
+}
+
+TEST_CASE("Testing session results do not depend on the number of threads", "[runner]") {
+  std::string tetris = test_rom_path("tetris.rom");
+  std::string maze = test_rom_path("Maze.ch8");
+  REQUIRE(!tetris.empty());
+  REQUIRE(!maze.empty());
+
+  {
+    std::ofstream script("runner_test_input.tmp");
+    script << "# move left, then drop\n10 down 5\n40 up 5\n45 down 4\n300 up 4\n";
+    std::ofstream manifest("runner_test_manifest.tmp");
+    manifest << "# name rom frames input seed\n";
+    for (int i = 0; i < 12; i++) {
+      manifest << "tetris" << i << " " << tetris << " " << 200 + i * 37 << " runner_test_input.tmp " 
+        << i << "\n";
+      manifest << "maze" << i << " " << maze << " 150 - " << i << "\n";
+    }
+    manifest << "missing " << tetris << ".missing 10\n";
+  }
+
+  std::vector<Session> sessions;
+  std::string error;
+  REQUIRE(read_manifest("runner_test_manifest.tmp", sessions, error));
+  REQUIRE(sessions.size() == 25);
+  REQUIRE(sessions[0].input_path == "runner_test_input.tmp");
+  REQUIRE(sessions[1].input_path.empty());
+  REQUIRE(sessions[3].seed == 1);
+  REQUIRE(sessions[24].seed == Emu::DEFAULT_RANDOM_SEED);
+
+  RunnerOptions options;
+  options.threads = 1;
+  RunnerReport single = run_sessions(sessions, options);
+  options.threads = 4;
+  options.slice_frames = 7;
+  RunnerReport parallel = run_sessions(sessions, options);
+
+  REQUIRE(parallel.threads == 4);
+  REQUIRE(single.instructions == parallel.instructions);
+  // Tetris waits out its delays in idle loops, which are skipped rather than executed.
+  REQUIRE(single.instructions < single.cycles);
+  for (int i = 0; i < 24; i++) {
+    REQUIRE(single.results[i].ok);
+    REQUIRE(single.results[i].frames == sessions[i].frames);
+    REQUIRE(single.results[i].instructions == parallel.results[i].instructions);
+    REQUIRE(single.results[i].cycles == sessions[i].frames * options.instructions_per_frame);
+    REQUIRE(single.results[i].instructions <= single.results[i].cycles);
+    REQUIRE(single.results[i].program_counter == parallel.results[i].program_counter);
+    REQUIRE(single.results[i].display_hash == parallel.results[i].display_hash);
+  }
+  REQUIRE(!parallel.results[24].ok);
+
+  // Maze draws a different maze for every seed.
+  REQUIRE(single.results[1].display_hash != single.results[3].display_hash);
+
+  std::remove("runner_test_input.tmp");
+  std::remove("runner_test_manifest.tmp");
+}
+
+TEST_CASE("Testing bad manifests and input scripts are rejected", "[runner]") {
+  {
+    std::ofstream manifest("runner_test_manifest.tmp");
+    manifest << "\n# fine so far\ngood rom.ch8 10\nbad rom.ch8 lots\n";
+    std::ofstream script("runner_test_input.tmp");
+    script << "5 down A\n2 sideways 3\n";
+  }
+
+  std::vector<Session> sessions;
+  std::string error;
+  REQUIRE(!read_manifest("runner_test_manifest.tmp", sessions, error));
+  REQUIRE(error.find(":4:") != std::string::npos);
+
+  std::vector<InputEvent> events;
+  REQUIRE(!read_input_script("runner_test_input.tmp", events));
+  REQUIRE(!read_input_script("runner_test_input.missing", events));
+
+  std::remove("runner_test_input.tmp");
+  std::remove("runner_test_manifest.tmp");
+}
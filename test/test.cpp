@@ -6,4 +6,20 @@
 #include "register_test.cpp" 
 #include "ram_test.cpp"
 #include "display_test.cpp"
-#include "instructions_test.cpp" 
\ No newline at end of file
+#include "instructions_test.cpp"
+#include "dispatch_test.cpp"
+#include "block_cache_test.cpp"
+#include "jit_test.cpp"
+#include "run_test.cpp"
+#include "timer_scheduler_test.cpp"
+#include "save_state_test.cpp"
+#include "rewind_buffer_test.cpp"
+#include "session_runner_test.cpp"
+#include "lockstep_emu_test.cpp"
+#include "replay_test.cpp"
+#include "profiler_test.cpp"
+#include "trace_recorder_test.cpp"
+#include "disassembler_test.cpp"
+#include "control_flow_graph_test.cpp"
+#include "debugger_test.cpp"
+#include "json_test.cpp"
\ No newline at end of file
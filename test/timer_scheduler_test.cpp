@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/timer_scheduler.hpp"
+
+#include <chrono>
+#include <thread>
+
+TEST_CASE("Testing virtual clock ticks every clock speed / 60 cycles", "[scheduler]") {
+  TimerScheduler scheduler;
+  scheduler.set_clock_speed(600);
+
+  REQUIRE(scheduler.CyclesUntilTick() == 10);
+  REQUIRE(scheduler.Advance(9) == 0);
+  REQUIRE(scheduler.CyclesUntilTick() == 1);
+  REQUIRE(scheduler.Advance(1) == 1);
+  REQUIRE(scheduler.Advance(35) == 3);
+  REQUIRE(scheduler.CyclesUntilTick() == 5);
+  REQUIRE(scheduler.get_cycle_count() == 45);
+}
+
+TEST_CASE("Testing virtual clock runs are reproducible", "[scheduler]") {
+  // Count the delay timer down in a loop and store how far V1 got each time it hits zero.
+  Emu first;
+  Emu second;
+  Emu* emulators[] = { &first, &second };
+  for (Emu* emu : emulators) {
+    emu->LoadInstruction(0x200, 0x6005);
+    emu->LoadInstruction(0x202, 0xF015);
+    emu->LoadInstruction(0x204, 0x7101);
+    emu->LoadInstruction(0x206, 0xF007);
+    emu->LoadInstruction(0x208, 0x3000);
+    emu->LoadInstruction(0x20A, 0x1204);
+    emu->LoadInstruction(0x20C, 0x1200);
+    emu->set_program_counter(0x200);
+  }
+
+  // Run the same number of cycles split up differently.
+  first.RunCycles(1000);
+  for (int i = 0; i < 100; i++) {
+    second.RunCycles(7);
+    second.RunCycles(3);
+  }
+
+  REQUIRE(first.get_cycle_count() == 1000);
+  REQUIRE(same_state(first, second));
+  REQUIRE(first.get_register(1) == second.get_register(1));
+}
+
+TEST_CASE("Testing wall clock ticks follow real time", "[scheduler]") {
+  TimerScheduler scheduler;
+  scheduler.set_mode(TimerScheduler::WALL_CLOCK);
+
+  // No time has passed, so however many cycles run there is no tick yet.
+  REQUIRE(scheduler.Advance(100000) == 0);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  int ticks = scheduler.Advance(1);
+  REQUIRE(ticks >= 3);
+  REQUIRE(ticks <= 30);
+}
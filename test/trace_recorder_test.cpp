@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "../src/emu.hpp"
+#include "../src/trace_recorder.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+TEST_CASE("Testing traced_register names the register an instruction writes", "[trace]") {
+  REQUIRE(traced_register(decode_instruction(0x6A12)) == 0xA);
+  REQUIRE(traced_register(decode_instruction(0x8124)) == 0x1);
+  REQUIRE(traced_register(decode_instruction(0xF565)) == 0x5);
+  REQUIRE(traced_register(decode_instruction(0xF555)) == TraceRecord::NO_REGISTER);
+  REQUIRE(traced_register(decode_instruction(0xD125)) == TraceRecord::NO_REGISTER);
+  REQUIRE(traced_register(decode_instruction(0x1200)) == TraceRecord::NO_REGISTER);
+}
+
+TEST_CASE("Testing a trace holds every executed instruction in order", "[trace]") {
+  std::vector<uint8_t> rom;
+  REQUIRE(read_test_rom("tetris.rom", rom));
+
+  const bool memory_maps[] = { false, true };
+  for (bool memory_map : memory_maps) {
+    const char* path = "trace_test.tmp";
+
+    // A tiny ring, so the emulator has to wait on the draining thread over and over.
+    TraceRecorder recorder(64);
+    REQUIRE(recorder.Open(path, memory_map));
+    REQUIRE(!recorder.Open(path, memory_map));
+
+    Emu traced;
+    traced.set_execution_engine(Emu::JIT_ENGINE);
+    traced.LoadRom(rom.data(), rom.size());
+    traced.set_trace_recorder(&recorder);
+    for (int frame = 0; frame < 2000; frame++) {
+      traced.RunFrame(9);
+    }
+    REQUIRE(recorder.Close());
+    REQUIRE(!recorder.is_open());
+    long long records = recorder.get_record_count();
+    REQUIRE(records > 0);
+
+    // Step an untraced emulator alongside the trace.
+    Emu reference;
+    reference.LoadRom(rom.data(), rom.size());
+    reference.set_idle_loop_skipping(false);
+    TraceReader reader;
+    REQUIRE(reader.Open(path));
+    TraceRecord record;
+    long long read = 0;
+    for (; reader.Next(record); read++) {
+      REQUIRE(record.program_counter == reference.get_program_counter());
+
+      // Timer ticks do not show in the trace, so line the delay timer up with the traced run.
+      if (decode_instruction(record.opcode).type == OP_GET_DELAY) {
+        reference.set_delay_timer(record.changed_value);
+      }
+      reference.Step();
+      REQUIRE(record.index_register == reference.get_index_register().to_ulong());
+      REQUIRE(record.flag_register == reference.get_register(0xF));
+      if (record.changed_register != TraceRecord::NO_REGISTER) {
+        REQUIRE(record.changed_value == reference.get_register(record.changed_register));
+      }
+    }
+    REQUIRE(read == records);
+    std::remove(path);
+  }
+}
+
+TEST_CASE("Testing a trace holds the instructions of skipped idle loops", "[trace]") {
+  std::vector<uint8_t> rom;
+  REQUIRE(read_test_rom("breakout.rom", rom));
+  const char* path = "trace_test.tmp";
+
+  // Breakout waits out its delays in idle loops, which are skipped when nothing is attached.
+  TraceRecorder recorder;
+  REQUIRE(recorder.Open(path, false));
+  Emu traced;
+  traced.LoadRom(rom.data(), rom.size());
+  traced.set_trace_recorder(&recorder);
+  Emu reference;
+  reference.LoadRom(rom.data(), rom.size());
+  long long cycles = 0;
+  for (int frame = 0; frame < 600; frame++) {
+    cycles += traced.RunFrame(9).instructions;
+    reference.RunFrame(9);
+  }
+  REQUIRE(recorder.Close());
+  REQUIRE(reference.get_skipped_cycles() > 0);
+
+  REQUIRE(traced.get_skipped_cycles() == 0);
+  REQUIRE(recorder.get_record_count() == cycles);
+  REQUIRE(same_state(traced, reference));
+  std::remove(path);
+}
@@ -0,0 +1,223 @@
+#include "../src/control_flow_graph.hpp"
+#include "../src/json.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+const char* USAGE = "chip8-cfg [-format text|dot|json] [-o <file>] <rom>";
+
+const char* EDGE_NAMES[] = { "next", "jump", "skip", "call" };
+
+/**
+ * Returns p_values as a JSON array.
+ */
+std::string json_array(const std::vector<int>& p_values) {
+  std::string array = "[";
+  for (size_t i = 0; i < p_values.size(); i++) {
+    array += (i ? ", " : "") + std::to_string(p_values[i]);
+  }
+  return array + "]";
+}
+
+/**
+ * Appends the summary lines of p_graph to p_out.
+ */
+void write_text(std::string& p_out, const ControlFlowGraph& p_graph) {
+  char line[160];
+  int read_as_data = 0;
+  for (const CodeRegion& region : p_graph.regions) {
+    read_as_data += region.read_as_data;
+  }
+  std::snprintf(line, sizeof(line), "%zu blocks, %zu functions, %zu loops, %d reachable bytes, "
+    "%d unresolved jumps\n", p_graph.blocks.size(), p_graph.functions.size(), p_graph.loops.size(),
+    p_graph.reachable_bytes, p_graph.unresolved_jumps);
+  p_out += line;
+  std::snprintf(line, sizeof(line), "max loop depth %d, max call depth %s\n",
+    p_graph.max_loop_depth, p_graph.max_call_depth < 0 ? "unbounded"
+      : std::to_string(p_graph.max_call_depth).c_str());
+  p_out += line;
+
+  p_out += "\nfunctions:\n";
+  for (const CfgFunction& function : p_graph.functions) {
+    std::snprintf(line, sizeof(line), "  %03X: %zu blocks, %zu callees, call depth %d%s\n",
+      p_graph.blocks[function.entry].start, function.blocks.size(), function.callees.size(),
+      function.call_depth, function.recursive ? ", recursive" : "");
+    p_out += line;
+  }
+
+  p_out += "\nloops:\n";
+  for (const CfgLoop& loop : p_graph.loops) {
+    std::snprintf(line, sizeof(line), "  %03X: %zu blocks, depth %d\n",
+      p_graph.blocks[loop.header].start, loop.blocks.size(), loop.depth);
+    p_out += line;
+  }
+
+  p_out += "\ncode regions:\n";
+  for (const CodeRegion& region : p_graph.regions) {
+    std::snprintf(line, sizeof(line), "  %03X-%03X: %d bytes%s\n", region.start, region.end - 1,
+      region.end - region.start, region.read_as_data ? ", read as data" : "");
+    p_out += line;
+  }
+  std::snprintf(line, sizeof(line), "%d of %zu regions read as data\n", read_as_data,
+    p_graph.regions.size());
+  p_out += line;
+}
+
+/**
+ * Appends p_graph as a DOT digraph to p_out, one box per block listing its instructions. Calls are
+ * dashed and BNNN jumps go to a single unresolved node.
+ */
+void write_dot(std::string& p_out, const Disassembly& p_disassembly,
+               const ControlFlowGraph& p_graph) {
+  char line[96];
+  p_out += "digraph cfg {\n  node [shape=box, fontname=monospace];\n";
+  for (size_t i = 0; i < p_graph.blocks.size(); i++) {
+    const BasicBlock& block = p_graph.blocks[i];
+    std::string label;
+    for (int index : block.instructions) {
+      const DisassembledInstruction& code = p_disassembly.instructions[index];
+      std::snprintf(line, sizeof(line), "%03X: %s\\l", code.address,
+        format_instruction(code.instruction).c_str());
+      label += line;
+    }
+    p_out += "  b" + std::to_string(i) + " [label=\"" + label + "\"];\n";
+  }
+
+  if (p_graph.unresolved_jumps > 0) {
+    p_out += "  unresolved [shape=ellipse, style=dashed];\n";
+  }
+  for (size_t i = 0; i < p_graph.blocks.size(); i++) {
+    const BasicBlock& block = p_graph.blocks[i];
+    for (const CfgEdge& edge : block.successors) {
+      std::snprintf(line, sizeof(line), "  b%zu -> b%d [label=%s%s];\n", i, edge.target,
+        EDGE_NAMES[edge.kind], edge.kind == EDGE_CALL ? ", style=dashed" : "");
+      p_out += line;
+    }
+    if (block.unresolved) {
+      p_out += "  b" + std::to_string(i) + " -> unresolved [style=dotted];\n";
+    }
+  }
+  p_out += "}\n";
+}
+
+/**
+ * Appends p_graph as a JSON object to p_out. Blocks are referred to by index.
+ */
+void write_json(std::string& p_out, const Disassembly& p_disassembly,
+                const ControlFlowGraph& p_graph) {
+  char item[192];
+  std::snprintf(item, sizeof(item), "{\n  \"block_count\": %zu, \"reachable_bytes\": %d, "
+    "\"unresolved_jumps\": %d, \"max_loop_depth\": %d, \"max_call_depth\": %d,\n  \"blocks\": [",
+    p_graph.blocks.size(), p_graph.reachable_bytes, p_graph.unresolved_jumps,
+    p_graph.max_loop_depth, p_graph.max_call_depth);
+  p_out += item;
+  for (size_t i = 0; i < p_graph.blocks.size(); i++) {
+    const BasicBlock& block = p_graph.blocks[i];
+    std::snprintf(item, sizeof(item), "%s\n    {\"start\": %d, \"end\": %d, \"function\": %d, "
+      "\"loop_depth\": %d, \"returns\": %s, \"unresolved\": %s, \"instructions\": [",
+      i ? "," : "", block.start, block.end, block.function, block.loop_depth,
+      block.returns ? "true" : "false", block.unresolved ? "true" : "false");
+    p_out += item;
+    for (size_t j = 0; j < block.instructions.size(); j++) {
+      const DisassembledInstruction& code = p_disassembly.instructions[block.instructions[j]];
+      p_out += (j ? ", " : "") + json_string(format_instruction(code.instruction));
+    }
+    p_out += "], \"successors\": [";
+    for (size_t j = 0; j < block.successors.size(); j++) {
+      std::snprintf(item, sizeof(item), "%s{\"target\": %d, \"kind\": \"%s\"}", j ? ", " : "",
+        block.successors[j].target, EDGE_NAMES[block.successors[j].kind]);
+      p_out += item;
+    }
+    p_out += "]}";
+  }
+
+  p_out += "],\n  \"functions\": [";
+  for (size_t i = 0; i < p_graph.functions.size(); i++) {
+    const CfgFunction& function = p_graph.functions[i];
+    std::snprintf(item, sizeof(item), "%s\n    {\"entry\": %d, \"call_depth\": %d, "
+      "\"recursive\": %s, \"blocks\": ", i ? "," : "", function.entry, function.call_depth,
+      function.recursive ? "true" : "false");
+    p_out += item + json_array(function.blocks) + ", \"callees\": "
+      + json_array(function.callees) + "}";
+  }
+
+  p_out += "],\n  \"loops\": [";
+  for (size_t i = 0; i < p_graph.loops.size(); i++) {
+    const CfgLoop& loop = p_graph.loops[i];
+    std::snprintf(item, sizeof(item), "%s\n    {\"header\": %d, \"depth\": %d, \"blocks\": ",
+      i ? "," : "", loop.header, loop.depth);
+    p_out += item + json_array(loop.blocks) + "}";
+  }
+
+  p_out += "],\n  \"regions\": [";
+  for (size_t i = 0; i < p_graph.regions.size(); i++) {
+    const CodeRegion& region = p_graph.regions[i];
+    std::snprintf(item, sizeof(item), "%s\n    {\"start\": %d, \"end\": %d, \"read_as_data\": %s}",
+      i ? "," : "", region.start, region.end, region.read_as_data ? "true" : "false");
+    p_out += item;
+  }
+  p_out += "]\n}\n";
+}
+
+/**
+ * Builds the control flow graph of a rom from its disassembly and writes it as a summary report,
+ * a DOT graph or JSON.
+ */
+int main(int argc, char* argv[]) {
+  std::string rom_path;
+  std::string format = "text";
+  std::string output_file;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-format" && i + 1 < argc) {
+      format = argv[++i];
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (rom_path.empty()) {
+      rom_path = arg;
+    } else {
+      std::cout << USAGE << std::endl;
+      return 1;
+    }
+  }
+  if (rom_path.empty() || (format != "text" && format != "dot" && format != "json")) {
+    std::cout << USAGE << std::endl;
+    return 1;
+  }
+
+  std::ifstream rom_file(rom_path, std::ios::binary);
+  if (!rom_file) {
+    std::cerr << "unable to open " << rom_path << std::endl;
+    return 1;
+  }
+  std::vector<uint8_t> rom((std::istreambuf_iterator<char>(rom_file)),
+                           std::istreambuf_iterator<char>());
+  Disassembly disassembly = disassemble(rom.data(), rom.size());
+  ControlFlowGraph graph = build_control_flow_graph(disassembly);
+
+  std::string text;
+  if (format == "dot") {
+    write_dot(text, disassembly, graph);
+  } else if (format == "json") {
+    write_json(text, disassembly, graph);
+  } else {
+    text += rom_path + ": ";
+    write_text(text, graph);
+  }
+
+  std::ofstream file;
+  if (!output_file.empty()) {
+    file.open(output_file);
+  }
+  std::ostream& out = output_file.empty() ? std::cout : file;
+  out << text;
+  if (!out) {
+    std::cerr << "unable to write " << output_file << std::endl;
+    return 1;
+  }
+  return 0;
+}
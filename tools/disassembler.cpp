@@ -0,0 +1,229 @@
+#include "../src/disassembler.hpp"
+#include "../src/json.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+const char* USAGE = "chip8-dis [-format text|json] [-summary] [-o <file>] <rom>...";
+
+/**
+ * Returns the name the listing gives p_address, or an empty string if it is not a jump or call
+ * target.
+ */
+std::string label_name(const Disassembly& p_disassembly, int p_address) {
+  char name[16] = "";
+  if (p_disassembly.Has(p_address, Disassembly::SUBROUTINE)) {
+    std::snprintf(name, sizeof(name), "sub_%03X", p_address);
+  } else if (p_disassembly.Has(p_address, Disassembly::LABEL)) {
+    std::snprintf(name, sizeof(name), "label_%03X", p_address);
+  }
+  return name;
+}
+
+/**
+ * Returns p_instruction formatted with its jump or call target named, if the target has a name.
+ */
+std::string instruction_text(const Disassembly& p_disassembly, const Instruction& p_instruction) {
+  bool branch = p_instruction.type == OP_JUMP || p_instruction.type == OP_CALL 
+    || p_instruction.type == OP_JUMP_OFFSET;
+  return format_instruction(p_instruction, 
+    branch ? label_name(p_disassembly, p_instruction.nnn) : "");
+}
+
+/**
+ * Returns the number of rom bytes no path reaches.
+ */
+int data_bytes(const Disassembly& p_disassembly) {
+  int data = 0;
+  for (uint8_t flags : p_disassembly.flags) {
+    data += !(flags & Disassembly::CODE);
+  }
+  return data;
+}
+
+/**
+ * Appends a one line summary of p_disassembly of rom p_name to p_out.
+ */
+void write_summary(std::string& p_out, const std::string& p_name, const Disassembly& p_disassembly,
+                   bool p_json) {
+  char line[160];
+  int size = p_disassembly.rom.size();
+  int instructions = p_disassembly.instructions.size();
+  int labels = p_disassembly.labels.size();
+  int subroutines = p_disassembly.subroutines.size();
+  if (p_json) {
+    std::snprintf(line, sizeof(line), "\"size\": %d, \"instruction_count\": %d, "
+      "\"data_bytes\": %d, \"label_count\": %d, \"subroutine_count\": %d, "
+      "\"indirect_jumps\": %s", size, instructions, data_bytes(p_disassembly), labels, 
+      subroutines, p_disassembly.indirect_jumps ? "true" : "false");
+    p_out += "{\"name\": " + json_string(p_name) + ", " + line;
+  } else {
+    std::snprintf(line, sizeof(line), ": %d bytes, %d instructions, %d data bytes, %d labels, "
+      "%d subroutines%s\n", size, instructions, data_bytes(p_disassembly), labels, subroutines, 
+      p_disassembly.indirect_jumps ? ", indirect jumps" : "");
+    p_out += p_name + line;
+  }
+}
+
+/**
+ * Appends the listing of p_disassembly to p_out: every instruction under its label, with runs of
+ * data between them as .byte lines.
+ */
+void write_listing(std::string& p_out, const Disassembly& p_disassembly) {
+  char line[96];
+  int end = Disassembly::ORIGIN + p_disassembly.rom.size();
+  for (int address = Disassembly::ORIGIN; address < end;) {
+    std::string label = label_name(p_disassembly, address);
+    if (!label.empty()) {
+      p_out += "\n" + label + ":\n";
+    }
+
+    if (p_disassembly.Has(address, Disassembly::INSTRUCTION)) {
+      const Instruction& instruction 
+        = p_disassembly.instructions[p_disassembly.Find(address)].instruction;
+      std::snprintf(line, sizeof(line), "  %03X: %04X  %s\n", address, instruction.Opcode(),
+        instruction_text(p_disassembly, instruction).c_str());
+      p_out += line;
+      address += 2;
+      continue;
+    }
+
+    // Up to 8 data bytes, stopping at the next instruction or label.
+    int length = std::snprintf(line, sizeof(line), "  %03X: .byte", address);
+    int first = address;
+    do {
+      length += std::snprintf(line + length, sizeof(line) - length, "%s0x%02X", 
+        address == first ? " " : ", ", p_disassembly.rom[address - Disassembly::ORIGIN]);
+      address++;
+    } while (address < end && address - first < 8 
+             && !p_disassembly.Has(address, Disassembly::INSTRUCTION)
+             && label_name(p_disassembly, address).empty());
+    p_out += line;
+    p_out += "\n";
+  }
+}
+
+/**
+ * Appends p_disassembly as the fields of a JSON object to p_out, after its summary.
+ */
+void write_json(std::string& p_out, const Disassembly& p_disassembly) {
+  char item[96];
+  p_out += ",\n  \"labels\": [";
+  for (size_t i = 0; i < p_disassembly.labels.size(); i++) {
+    p_out += (i ? ", " : "") + std::to_string(p_disassembly.labels[i]);
+  }
+  p_out += "],\n  \"subroutines\": [";
+  for (size_t i = 0; i < p_disassembly.subroutines.size(); i++) {
+    p_out += (i ? ", " : "") + std::to_string(p_disassembly.subroutines[i]);
+  }
+  p_out += "],\n  \"code\": [";
+  for (size_t i = 0; i < p_disassembly.instructions.size(); i++) {
+    const DisassembledInstruction& code = p_disassembly.instructions[i];
+    std::snprintf(item, sizeof(item), "%s\n    {\"address\": %d, \"opcode\": %d, \"text\": ", 
+      i ? "," : "", code.address, code.instruction.Opcode());
+    p_out += item + json_string(instruction_text(p_disassembly, code.instruction)) + "}";
+  }
+  p_out += "],\n  \"data\": [";
+
+  // Runs of data bytes as address and length.
+  bool first = true;
+  int size = p_disassembly.rom.size();
+  for (int offset = 0; offset < size;) {
+    if (p_disassembly.flags[offset] & Disassembly::CODE) {
+      offset++;
+      continue;
+    }
+    int start = offset;
+    while (offset < size && !(p_disassembly.flags[offset] & Disassembly::CODE)) {
+      offset++;
+    }
+    std::snprintf(item, sizeof(item), "%s{\"address\": %d, \"length\": %d}", first ? "" : ", ",
+      Disassembly::ORIGIN + start, offset - start);
+    p_out += item;
+    first = false;
+  }
+  p_out += "]";
+}
+
+/**
+ * Disassembles every rom named on the command line by recursive descent from 0x200, and writes a
+ * listing, or just a summary line, per rom as text or as a JSON array.
+ */
+int main(int argc, char* argv[]) {
+  std::vector<std::string> roms;
+  bool json = false;
+  bool summary = false;
+  std::string output_file;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-format" && i + 1 < argc) {
+      json = std::string(argv[++i]) == "json";
+    } else if (arg == "-summary") {
+      summary = true;
+    } else if (arg == "-o" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else {
+      roms.push_back(arg);
+    }
+  }
+  if (roms.empty()) {
+    std::cout << USAGE << std::endl;
+    return 1;
+  }
+
+  std::ofstream file;
+  if (!output_file.empty()) {
+    file.open(output_file);
+  }
+  std::ostream& out = output_file.empty() ? std::cout : file;
+
+  int failed = 0;
+  int written = 0;
+  std::string text;
+  if (json) {
+    out << "[\n";
+  }
+  for (size_t i = 0; i < roms.size(); i++) {
+    std::ifstream rom_file(roms[i], std::ios::binary);
+    if (!rom_file) {
+      std::cerr << "unable to open " << roms[i] << std::endl;
+      failed++;
+      continue;
+    }
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(rom_file)), 
+                             std::istreambuf_iterator<char>());
+    Disassembly disassembly = disassemble(rom.data(), rom.size());
+
+    text.clear();
+    if (json) {
+      text += written ? ",\n" : "";
+      write_summary(text, roms[i], disassembly, true);
+      if (!summary) {
+        write_json(text, disassembly);
+      }
+      text += "}";
+    } else {
+      text += summary ? "" : "; ";
+      write_summary(text, roms[i], disassembly, false);
+      if (!summary) {
+        write_listing(text, disassembly);
+        text += "\n";
+      }
+    }
+    out << text;
+    written++;
+  }
+  if (json) {
+    out << "\n]\n";
+  }
+
+  if (!out) {
+    std::cerr << "unable to write " << output_file << std::endl;
+    return 1;
+  }
+  return failed > 0 ? 1 : 0;
+}
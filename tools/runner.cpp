@@ -0,0 +1,117 @@
+#include "../src/replay.hpp"
+#include "../src/session_runner.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+const char* USAGE = "chip8-runner -m <manifest> [-t <threads>] [-slice <frames>] "
+  "[-f <instructions per frame>]\n       chip8-runner -replay <replay file> -rom <rom>";
+
+/**
+ * Plays the replay at p_replay_path on p_rom_path headless as fast as possible and checks it ends
+ * in the state the recording did. Returns the exit code, 1 if the replay can not be played or 
+ * ends up somewhere else.
+ */
+int run_replay(const std::string& p_replay_path, const std::string& p_rom_path) {
+  Replay replay;
+  if (!read_replay_file(p_replay_path, replay)) {
+    std::cout << "unable to read replay " << p_replay_path << std::endl;
+    return 1;
+  }
+  std::ifstream rom_file(p_rom_path, std::ios::binary);
+  if (!rom_file) {
+    std::cout << "unable to open " << p_rom_path << std::endl;
+    return 1;
+  }
+  std::vector<uint8_t> rom((std::istreambuf_iterator<char>(rom_file)), 
+                           std::istreambuf_iterator<char>());
+
+  Emu emu;
+  auto start = std::chrono::steady_clock::now();
+  if (!play_replay(emu, replay, rom.data(), rom.size())) {
+    std::cout << p_replay_path << " was not recorded on " << p_rom_path << std::endl;
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool matches = replay_state_hash(emu) == replay.final_state_hash;
+  long long frames = replay.end_cycle / replay.instructions_per_frame;
+  std::cout << p_replay_path << ": " << replay.events.size() << " events, " << frames 
+    << " frames in " << seconds << "s (" 
+    << (seconds > 0 ? static_cast<long long>(frames / seconds / 60) : 0) 
+    << "x real time), final state " << (matches ? "matches" : "differs") << std::endl;
+  return matches ? 0 : 1;
+}
+
+/**
+ * Runs every session listed in a manifest on headless emulators spread over all cores, then prints
+ * a line per session followed by the aggregate instruction rate. Exits with 1 if any session 
+ * failed to load. With -replay, plays a single recorded run instead.
+ */
+int main(int argc, char* argv[]) {
+  std::string manifest;
+  std::string replay;
+  std::string rom;
+  RunnerOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-m" && i + 1 < argc) {
+      manifest = argv[++i];
+    } else if (arg == "-t" && i + 1 < argc) {
+      options.threads = std::atoi(argv[++i]);
+    } else if (arg == "-slice" && i + 1 < argc) {
+      options.slice_frames = std::atoi(argv[++i]);
+    } else if (arg == "-f" && i + 1 < argc) {
+      options.instructions_per_frame = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-replay" && i + 1 < argc) {
+      replay = argv[++i];
+    } else if (arg == "-rom" && i + 1 < argc) {
+      rom = argv[++i];
+    }
+  }
+
+  if (!replay.empty() && !rom.empty()) {
+    return run_replay(replay, rom);
+  }
+
+  if (manifest.empty()) {
+    std::cout << USAGE << std::endl;
+    return 1;
+  }
+
+  std::vector<Session> sessions;
+  std::string error;
+  if (!read_manifest(manifest, sessions, error)) {
+    std::cout << error << std::endl;
+    return 1;
+  }
+
+  RunnerReport report = run_sessions(sessions, options);
+
+  int failed = 0;
+  for (const SessionResult& result : report.results) {
+    if (!result.ok) {
+      std::cout << result.name << ": " << result.error << std::endl;
+      failed++;
+      continue;
+    }
+    std::cout << result.name << ": " << result.frames << " frames, " << result.instructions 
+      << " instructions of " << result.cycles << " cycles, pc " << std::hex << result.program_counter << ", display " 
+      << std::setw(8) << std::setfill('0') << result.display_hash << std::dec << std::setfill(' ')
+      << ", " << result.seconds << "s" << std::endl;
+  }
+
+  std::cout << sessions.size() << " sessions on " << report.threads << " threads: " 
+    << report.instructions << " instructions of " << report.cycles << " cycles in " 
+    << report.seconds << "s (" 
+    << (report.seconds > 0 ? static_cast<long long>(report.instructions / report.seconds) : 0) 
+    << " instructions/s, " 
+    << report.steals << " steals)" << std::endl;
+  return failed > 0 ? 1 : 0;
+}
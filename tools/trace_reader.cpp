@@ -0,0 +1,123 @@
+#include "../src/opcode.hpp"
+#include "../src/trace_recorder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+const char* USAGE = "chip8-trace <trace file> [-pc <address>[-<address>]] [-type <mnemonic>] "
+  "[-reg <register>] [-skip <records>] [-count <records>]";
+
+/**
+ * Which records get printed.
+ */
+struct TraceFilter {
+  int first_address = 0;
+  int last_address = 0xFFFF;
+
+  /**
+   * Mnemonic the instruction must have, as returned by instruction_name, empty for any.
+   */
+  std::string type;
+
+  /**
+   * Register the instruction must change, -1 for any.
+   */
+  int changed_register = -1;
+
+  /**
+   * Matching records to pass over before printing.
+   */
+  long long skip = 0;
+
+  /**
+   * Matching records to print, -1 for all of them.
+   */
+  long long count = -1;
+};
+
+/**
+ * Returns true if p_record passes p_filter.
+ */
+bool matches(const TraceRecord& p_record, const TraceFilter& p_filter) {
+  if (p_record.program_counter < p_filter.first_address
+      || p_record.program_counter > p_filter.last_address) {
+    return false;
+  }
+  if (p_filter.changed_register >= 0 && p_record.changed_register != p_filter.changed_register) {
+    return false;
+  }
+  return p_filter.type.empty()
+    || p_filter.type == instruction_name(decode_instruction(p_record.opcode).type);
+}
+
+/**
+ * Prints the records of a trace written by TraceRecorder that pass the filters, one per line with
+ * its position in the trace, followed by how many matched.
+ */
+int main(int argc, char* argv[]) {
+  std::string path;
+  TraceFilter filter;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-pc" && i + 1 < argc) {
+      std::string range = argv[++i];
+      size_t dash = range.find('-');
+      filter.first_address = std::strtol(range.c_str(), nullptr, 16);
+      filter.last_address = dash == std::string::npos ? filter.first_address
+        : std::strtol(range.c_str() + dash + 1, nullptr, 16);
+    } else if (arg == "-type" && i + 1 < argc) {
+      filter.type = argv[++i];
+    } else if (arg == "-reg" && i + 1 < argc) {
+      filter.changed_register = std::strtol(argv[++i], nullptr, 16);
+    } else if (arg == "-skip" && i + 1 < argc) {
+      filter.skip = std::atoll(argv[++i]);
+    } else if (arg == "-count" && i + 1 < argc) {
+      filter.count = std::atoll(argv[++i]);
+    } else if (path.empty()) {
+      path = arg;
+    } else {
+      std::cout << USAGE << std::endl;
+      return 1;
+    }
+  }
+
+  TraceReader reader;
+  if (path.empty()) {
+    std::cout << USAGE << std::endl;
+    return 1;
+  }
+  if (!reader.Open(path)) {
+    std::cout << "unable to read trace " << path << std::endl;
+    return 1;
+  }
+
+  TraceRecord record;
+  long long index = 0;
+  long long matched = 0;
+  long long printed = 0;
+  char line[96];
+  for (; reader.Next(record); index++) {
+    if (!matches(record, filter)) {
+      continue;
+    }
+    matched++;
+    if (matched <= filter.skip || (filter.count >= 0 && printed >= filter.count)) {
+      continue;
+    }
+    printed++;
+
+    int length = std::snprintf(line, sizeof(line), "%10lld %03X %04X %-9s I=%03X", index,
+      record.program_counter, record.opcode,
+      instruction_name(decode_instruction(record.opcode).type), record.index_register);
+    if (record.changed_register != TraceRecord::NO_REGISTER) {
+      length += std::snprintf(line + length, sizeof(line) - length, " V%X=%02X",
+        record.changed_register, record.changed_value);
+    }
+    std::snprintf(line + length, sizeof(line) - length, " VF=%02X", record.flag_register);
+    std::cout << line << '\n';
+  }
+  std::cout << matched << " of " << index << " records matched" << std::endl;
+  return 0;
+}